@@ -0,0 +1,212 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "batch.h"
+
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+
+
+namespace Batch {
+
+	namespace {
+
+		/*
+
+		Read the positions of the input file. A line is a FEN if its fifth and sixth fields are numbers, and otherwise the first four fields are kept
+		as in an EPD line.
+
+		*/
+		std::vector<std::string> read_positions(const std::string& path) {
+			std::vector<std::string> positions;
+			std::ifstream file(path);
+			std::string line;
+
+			while (std::getline(file, line)) {
+				std::istringstream ss(line);
+				std::string field, fen;
+
+				for (int n = 0; n < 6 && ss >> field; n++) {
+					if (n >= 4 && field.find_first_not_of("0123456789") != std::string::npos) {
+						break;
+					}
+					fen += (n > 0 ? " " : "") + field;
+				}
+
+				if (fen.empty() || fen[0] == '#' || std::count(fen.begin(), fen.end(), ' ') < 3) {
+					continue;
+				}
+				positions.push_back(fen);
+			}
+
+			return positions;
+		}
+
+
+		/*
+
+		Search a position and return its line of the output file. Checkmates and stalemates get no move and a score of mate 0 or cp 0.
+
+		*/
+		std::string search_position(SearchThread_t* thread, const std::string& fen, const Settings& settings) {
+			thread->pos->parseFen(fen);
+
+			thread->info->clear();
+			thread->info->starttime = getTimeMs();
+			thread->info->stoptime = thread->info->starttime + settings.movetime;
+			thread->info->timeset = settings.movetime > 0;
+			thread->info->depth = settings.depth;
+			thread->info->node_limit = settings.nodes;
+
+			Search::searchPosition(thread);
+
+			std::ostringstream line;
+			int score = thread->best_score;
+
+			line << fen << " ; bestmove " << ((thread->best_move != NOMOVE) ? printMove(thread->best_move) : std::string("(none)"));
+			line << " ; score " << ((std::abs(score) > MATE) ? "mate " + std::to_string(to_mate(score)) : "cp " + std::to_string(to_cp(score)));
+			line << " ; depth " << thread->best_depth << " ; nodes " << thread->info->nodes << " ; pv";
+
+			for (unsigned int move : thread->best_pv) {
+				line << " " << printMove(move);
+			}
+
+			return line.str();
+		}
+	}
+
+
+	/*
+
+	Search the positions on settings.threads threads. The main thread writes the finished lines to the output file in the order of the input and
+	prints the progress every few seconds.
+
+	*/
+	void run(const Settings& settings) {
+		// Step 1. Read the positions and open the output file.
+		std::vector<std::string> positions = read_positions(settings.input);
+
+		if (positions.empty()) {
+			std::cout << "info string batch: no positions in " << settings.input << std::endl;
+			return;
+		}
+
+		std::ofstream output(settings.output);
+		if (!output) {
+			std::cout << "info string batch: could not open " << settings.output << std::endl;
+			return;
+		}
+
+		// Step 2. Create the threads. With private tables the Hash size is split between them.
+		std::optional<TableResizeGuard> table_guard;
+
+		if (settings.shared_table) {
+			tt->clear_table();
+		}
+		else {
+			table_guard.emplace(settings.threads);
+		}
+
+		std::vector<SearchThread_t*> threads;
+		for (int t = 0; t < settings.threads; t++) {
+			threads.push_back(new SearchThread_t);
+			threads.back()->thread_id = t;
+			threads.back()->standalone = true;
+			threads.back()->own_table = (table_guard) ? table_guard->thread_table() : nullptr;
+		}
+
+		// Step 3. Search the positions, and write the lines in order as they are finished. A line is freed once it is written.
+		long long start = getTimeMs();
+		long long last_report = start;
+
+		std::atomic<long long> nodes{ 0 };
+		std::vector<std::string> lines(positions.size());
+		size_t written = 0;
+
+		run_ordered(positions.size(), settings.threads,
+			[&](int id, size_t i) {
+				// Every position is a new search, so the table is aged like it is for a "go" command. Otherwise the entries of the earlier
+				//	positions would never be replaced by age.
+				threads[id]->table()->increment_age();
+
+				lines[i] = search_position(threads[id], positions[i], settings);
+				nodes += threads[id]->info->nodes;
+			},
+			[&](size_t i) {
+				output << lines[i] << "\n";
+				std::string().swap(lines[i]);
+				written++;
+			},
+			[&]() {
+				output.flush();
+
+				if (getTimeMs() - last_report >= 5000) {
+					last_report = getTimeMs();
+					std::cout << "info string batch " << written << "/" << positions.size() << " positions, " << std::fixed << std::setprecision(1)
+						<< written / ((last_report - start) / 1000.0) << " positions/s" << std::endl;
+				}
+			});
+
+		for (SearchThread_t* thread : threads) {
+			delete thread->own_table;
+			delete thread;
+		}
+		table_guard.reset();
+
+		// Step 4. Print the totals.
+		double seconds = std::max(getTimeMs() - start, 1LL) / 1000.0;
+
+		std::cout << "info string batch done: " << positions.size() << " positions and " << nodes.load() << " nodes in " << std::fixed
+			<< std::setprecision(1) << seconds << "s, " << positions.size() / seconds << " positions/s, " << std::setprecision(0)
+			<< nodes.load() / seconds << " nps" << std::endl;
+	}
+
+
+	void parse(const std::string& command) {
+		Settings settings;
+
+		std::istringstream ss(command);
+		std::string token;
+		ss >> token; // "batch"
+
+		if (!(ss >> settings.input >> settings.output)) {
+			std::cout << "info string batch: usage batch <input> <output> [depth d] [nodes n] [movetime ms] [threads t] [tt shared|private]" << std::endl;
+			return;
+		}
+
+		while (ss >> token) {
+			if (token == "depth") { ss >> settings.depth; }
+			else if (token == "nodes") { ss >> settings.nodes; }
+			else if (token == "movetime") { ss >> settings.movetime; }
+			else if (token == "threads") { ss >> settings.threads; }
+			else if (token == "tt" && ss >> token) { settings.shared_table = (token != "private"); }
+		}
+
+		if (settings.depth == MAXDEPTH && settings.nodes <= 0 && settings.movetime <= 0) {
+			settings.depth = 10;
+		}
+
+		settings.depth = std::clamp(settings.depth, 1, MAXDEPTH);
+		settings.nodes = std::max(settings.nodes, 0LL);
+		settings.movetime = std::max(settings.movetime, 0);
+		settings.threads = std::clamp(settings.threads, THREADS_MIN_NUM, THREADS_MAX_NUM);
+
+		run(settings);
+	}
+}
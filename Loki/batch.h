@@ -0,0 +1,55 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef BATCH_H
+#define BATCH_H
+#include "search.h"
+
+#include <string>
+
+
+/*
+
+Batch analysis of the positions in a file. Every thread runs its own single-threaded searches, which uses the processor better than searching
+each position with all threads when there are many positions. The results are written to the output file in the order of the input, one line per
+position:
+
+	<fen> ; bestmove <move> ; score cp <x> ; depth <d> ; nodes <n> ; pv <moves>
+
+The input has one FEN or EPD position per line. Only the FEN part of an EPD line is kept.
+
+*/
+namespace Batch {
+
+	struct Settings {
+		std::string input;
+		std::string output;
+		int depth = MAXDEPTH;		// The limits of each search. If none are given, the depth is 10.
+		long long nodes = 0;
+		int movetime = 0;
+		int threads = 1;
+		bool shared_table = true;	// If false, every thread has its own transposition table of Hash / threads megabytes.
+	};
+
+	void run(const Settings& settings);
+
+	// Parses a "batch <input> <output> [depth d] [nodes n] [movetime ms] [threads t] [tt shared|private]" command and runs it.
+	void parse(const std::string& command);
+}
+
+
+#endif
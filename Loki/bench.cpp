@@ -82,12 +82,14 @@ namespace Bench {
         SearchInfo_t* info = new SearchInfo_t();
 
         long total_nodes = 0;
+        uint64_t lazy_calls = 0;
+        uint64_t lazy_exits = 0;
 
         long long start, end;
         long long total_time = 0;
 
         // Step 2. Loop through all the positions and search them.
-        for (int n = 0; n < benchmarks.size(); n++) {
+        for (int n = 0; n < int(benchmarks.size()); n++) {
 
             // Step 2A. Parse the position and set up the searchinfo.
             pos->parseFen(benchmarks[n]);
@@ -101,6 +103,8 @@ namespace Bench {
             // Step 2C. Save the node-count and time
             total_nodes += info->nodes;
             total_time += end - start;
+            lazy_calls += info->lazy_calls;
+            lazy_exits += info->lazy_exits;
 
             long long duration = end - start;
             long long nps = info->nodes / (((duration <= 0) ? 1 : duration) / 1000.0);
@@ -118,8 +122,112 @@ namespace Bench {
             "\n======================\n" <<
             "Time spent        " << total_time << "\n" <<
             "Nodes             " << total_nodes << "\n" <<
-            "nps               " << total_nodes / (total_time / 1000) << std::endl;
+            "nps               " << (long long)(total_nodes / (((total_time <= 0) ? 1 : total_time) / 1000.0)) << "\n" <<
+            "Lazy evals        " << lazy_exits << " / " << lazy_calls << " (" << ((lazy_calls == 0) ? 0.0 : 100.0 * double(lazy_exits) / double(lazy_calls)) << "%)" << std::endl;
         
     }
 
+
+
+    void run_slider_benchmark() {
+        constexpr int iterations = 200;
+
+        // Step 1. Generate random occupancies. Two random numbers and'ed together give around 16 pieces, which is a typical middlegame density.
+        std::mt19937_64 rng(20210801);
+        std::vector<Bitboard> occupancies(4096);
+
+        for (Bitboard& occ : occupancies) {
+            occ = rng() & rng();
+        }
+
+        Magics::SliderBackend original = Magics::backend;
+        Bitboard reference = 0;
+
+        // Step 2. Look up the rook and bishop attacks from every square with every occupancy, with each backend.
+        for (Magics::SliderBackend b : { Magics::MAGIC_BACKEND, Magics::PEXT_BACKEND }) {
+            if (!Magics::backend_available(b)) {
+                std::cout << "Backend " << Magics::backend_name(b) << " is not supported by this processor" << std::endl;
+                continue;
+            }
+
+            Magics::set_backend(b);
+
+            // The xor of all attacks makes sure the lookups aren't optimized away, and that the backends agree.
+            Bitboard checksum = 0;
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (int i = 0; i < iterations; i++) {
+                for (Bitboard occ : occupancies) {
+                    for (int sq = 0; sq < 64; sq++) {
+                        checksum ^= Magics::attacks_bb<ROOK>(sq, occ) ^ Magics::attacks_bb<BISHOP>(sq, occ);
+                    }
+                }
+            }
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            double lookups = 2.0 * 64.0 * double(occupancies.size()) * double(iterations);
+
+            if (b == Magics::MAGIC_BACKEND) {
+                reference = checksum;
+            }
+
+            // Step 3. Print the results.
+            std::cout << "Backend " << Magics::backend_name(b) <<
+                " lookups " << (long long)lookups <<
+                " time[ms] " << (long long)ms <<
+                " ns/lookup " << (ms * 1e6 / lookups) <<
+                ((checksum == reference) ? "" : " (MISMATCH)") << std::endl;
+        }
+
+        // Step 4. Go back to the backend selected on startup.
+        Magics::set_backend(original);
+    }
+
+
+
+    void run_eval_benchmark() {
+        constexpr int iterations = 20000;
+
+        // The Evaluate object is large, so it is put on the heap like in SearchThread_t.
+        GameState_t* pos = new GameState_t();
+        Eval::Evaluate<NORMAL>* eval = new Eval::Evaluate<NORMAL>;
+
+        long long total_evals = 0;
+        double total_ms = 0.0;
+
+        // The sum of all evaluations makes sure the calls aren't optimized away.
+        long long checksum = 0;
+
+        // Step 1. Evaluate every bench position repeatedly without the hash tables, so the full evaluation is timed each time.
+        for (int n = 0; n < int(benchmarks.size()); n++) {
+            pos->parseFen(benchmarks[n]);
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (int i = 0; i < iterations; i++) {
+                checksum += eval->score(pos, false);
+            }
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+            total_evals += iterations;
+        }
+
+        // Step 2. Print the results.
+        std::cout <<
+            "\n======================\n" <<
+            "Evaluations       " << total_evals << "\n" <<
+            "Time[ms]          " << (long long)total_ms << "\n" <<
+            "Evals/second      " << (long long)(double(total_evals) / (total_ms / 1000.0)) << "\n" <<
+            "ns/eval           " << (total_ms * 1e6 / double(total_evals)) << "\n" <<
+            "Checksum          " << checksum << std::endl;
+
+        delete eval;
+        delete pos;
+    }
+
 }
\ No newline at end of file
@@ -19,6 +19,9 @@
 #define BENCH_H
 #include "search.h"
 
+#include <chrono>
+#include <random>
+
 constexpr int BENCHMARK_DEPTH = 8;
 
 inline void setup_params(SearchInfo_t* info) {
@@ -39,6 +42,12 @@ namespace Bench {
     extern std::vector<std::string> benchmarks;
 
     extern void run_benchmark();
+
+    // Times attacks_bb with every slider backend supported by the processor.
+    extern void run_slider_benchmark();
+
+    // Times the full static evaluation of the bench positions.
+    extern void run_eval_benchmark();
 }
 
 
@@ -0,0 +1,191 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "bitbase.h"
+#include "bitboard.h"
+
+#include <bitset>
+#include <mutex>
+#include <vector>
+
+
+namespace Bitbase {
+
+	namespace {
+
+		// The white king, black king, side to move, pawn file (A-D) and pawn rank (2-7) of every position.
+		constexpr unsigned int MAX_INDEX = 64 * 64 * 2 * 4 * 6;
+
+		std::bitset<MAX_INDEX> kpk_wins;
+		std::once_flag kpk_generated;
+
+
+		/// <summary>
+		/// The index of a position. The pawn rank is stored as RANK_7 - rank so the positions closest to promotion come first.
+		/// </summary>
+		unsigned int index(SIDE stm, int bksq, int wksq, int psq) {
+			return unsigned(wksq) | (unsigned(bksq) << 6) | (unsigned(stm == WHITE) << 12) | (unsigned(psq % 8) << 13)
+				| (unsigned(RANK_7 - psq / 8) << 15);
+		}
+
+
+		int distance(int sq1, int sq2) {
+			return std::max(std::abs(sq1 / 8 - sq2 / 8), std::abs(sq1 % 8 - sq2 % 8));
+		}
+
+
+		// The results are bit flags, so the results of all moves from a position can be or'ed together.
+		enum Result : uint8_t { INVALID = 0, UNKNOWN = 1, DRAW = 2, WIN = 4 };
+
+
+		/// <summary>
+		/// A position in the generation of the bitbase.
+		/// </summary>
+		struct KPKPosition {
+			KPKPosition() = default;
+			explicit KPKPosition(unsigned int idx);
+
+			Result classify(const std::vector<KPKPosition>& db);
+
+			SIDE stm = WHITE;
+			int ksq[2] = { 0, 0 };
+			int psq = 0;
+			Result result = INVALID;
+		};
+
+
+		/*
+
+		Classify the positions that can be decided without looking at any moves.
+
+		*/
+		KPKPosition::KPKPosition(unsigned int idx) {
+			ksq[WHITE] = int(idx & 63);
+			ksq[BLACK] = int((idx >> 6) & 63);
+			stm = ((idx >> 12) & 1) ? WHITE : BLACK;
+			psq = 8 * (RANK_7 - int((idx >> 15) & 7)) + int((idx >> 13) & 3);
+
+			Bitboard pawn_attacks = shift<NORTHWEST>(uint64_t(1) << psq) | shift<NORTHEAST>(uint64_t(1) << psq);
+			int promotion_sq = psq + 8;
+
+			// Step 1. Two pieces on the same square, adjacent kings or a king that can be captured are invalid.
+			if (distance(ksq[WHITE], ksq[BLACK]) <= 1 || ksq[WHITE] == psq || ksq[BLACK] == psq
+				|| (stm == WHITE && (pawn_attacks & (uint64_t(1) << ksq[BLACK])))) {
+				result = INVALID;
+			}
+
+			// Step 2. White wins if the pawn can promote without being captured.
+			else if (stm == WHITE && psq / 8 == RANK_7 && ksq[WHITE] != promotion_sq
+				&& (distance(ksq[BLACK], promotion_sq) > 1 || distance(ksq[WHITE], promotion_sq) == 1)) {
+				result = WIN;
+			}
+
+			// Step 3. It is a draw if black is stalemated or can capture an undefended pawn.
+			else if (stm == BLACK
+				&& (!(BBS::king_attacks[ksq[BLACK]] & ~(BBS::king_attacks[ksq[WHITE]] | pawn_attacks))
+					|| (BBS::king_attacks[ksq[BLACK]] & ~BBS::king_attacks[ksq[WHITE]] & (uint64_t(1) << psq)))) {
+				result = DRAW;
+			}
+
+			else {
+				result = UNKNOWN;
+			}
+		}
+
+
+		/*
+
+		Classify a position from the results of its moves. White wins if one of its moves wins, and black draws if one of its moves draws. If
+		the position can't be decided yet, it stays unknown.
+
+		*/
+		Result KPKPosition::classify(const std::vector<KPKPosition>& db) {
+			const Result good = (stm == WHITE) ? WIN : DRAW;
+			const Result bad = (stm == WHITE) ? DRAW : WIN;
+
+			int r = INVALID;
+
+			// Step 1. King moves.
+			Bitboard moves = BBS::king_attacks[ksq[stm]];
+			while (moves) {
+				int to = PopBit(&moves);
+
+				r |= (stm == WHITE) ? db[index(BLACK, ksq[BLACK], to, psq)].result : db[index(WHITE, to, ksq[WHITE], psq)].result;
+			}
+
+			// Step 2. Pawn pushes. A push onto a king is an invalid position, so it doesn't add anything.
+			if (stm == WHITE) {
+				if (psq / 8 < RANK_7) {
+					r |= db[index(BLACK, ksq[BLACK], ksq[WHITE], psq + 8)].result;
+				}
+				if (psq / 8 == RANK_2 && psq + 8 != ksq[WHITE] && psq + 8 != ksq[BLACK]) {
+					r |= db[index(BLACK, ksq[BLACK], ksq[WHITE], psq + 16)].result;
+				}
+			}
+
+			result = (r & good) ? good : ((r & UNKNOWN) ? UNKNOWN : bad);
+			return result;
+		}
+	}
+
+
+	/// <summary>
+	/// Generate the bitbase by retrograde analysis.
+	/// </summary>
+	void generate() {
+		std::vector<KPKPosition> db(MAX_INDEX);
+
+		// Step 1. Classify the positions that don't depend on others.
+		for (unsigned int idx = 0; idx < MAX_INDEX; idx++) {
+			db[idx] = KPKPosition(idx);
+		}
+
+		// Step 2. Keep classifying the unknown positions until nothing changes.
+		bool changed = true;
+		while (changed) {
+			changed = false;
+
+			for (unsigned int idx = 0; idx < MAX_INDEX; idx++) {
+				changed |= (db[idx].result == UNKNOWN && db[idx].classify(db) != UNKNOWN);
+			}
+		}
+
+		// Step 3. Store the wins. The positions that are still unknown are draws.
+		kpk_wins.reset();
+		for (unsigned int idx = 0; idx < MAX_INDEX; idx++) {
+			if (db[idx].result == WIN) {
+				kpk_wins.set(idx);
+			}
+		}
+	}
+
+
+	void INIT() {
+		std::call_once(kpk_generated, generate);
+	}
+
+
+	bool probe_kpk(int wksq, int wpsq, int bksq, SIDE stm) {
+		assert(wpsq % 8 <= FILE_D);
+		assert(wpsq / 8 >= RANK_2 && wpsq / 8 <= RANK_7);
+
+		// The bitbase is only needed in KPK endgames, so it is generated the first time one is probed instead of at startup.
+		INIT();
+
+		return kpk_wins[index(stm, bksq, wksq, wpsq)];
+	}
+}
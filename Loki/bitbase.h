@@ -0,0 +1,43 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef BITBASE_H
+#define BITBASE_H
+#include "defs.h"
+
+
+/*
+
+The king and pawn versus king bitbase. It holds one bit for every position with white to have the pawn on the a- to d-files, which is set if
+white wins. The other positions are found by mirroring. It is generated by retrograde analysis the first time it is probed,
+which takes a few milliseconds.
+
+*/
+namespace Bitbase {
+
+	// Generates the bitbase if it hasn't been already. It is safe to call from several threads.
+	void INIT();
+
+	/// <summary>
+	/// Look up a KPK position. The pawn must be white and on one of the files A-D.
+	/// </summary>
+	/// <returns>True if white wins, and false if it is a draw.</returns>
+	bool probe_kpk(int wksq, int wpsq, int bksq, SIDE stm);
+}
+
+
+#endif
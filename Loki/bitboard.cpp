@@ -19,54 +19,9 @@
 
 #include <random>
 
-Bitboard BBS::knight_attacks[64] = { 0 };
-
-void BBS::init_knightAttacks() {
-	Bitboard knightAttackBrd = 0;
-
-	// We'll loop through all squares and add knight attacks as if it was an empty board.
-	for (int sq = 0; sq < 64; sq++) {
-		knightAttackBrd = 0;
-		knightAttackBrd |= ((uint64_t(1) << sq) & ~FileMasks8[FILE_H]) << 17;
-		knightAttackBrd |= ((uint64_t(1) << sq) & ~FileMasks8[FILE_A]) << 15;
-		knightAttackBrd |= ((uint64_t(1) << sq) & ~(FileMasks8[FILE_G] | FileMasks8[FILE_H])) << 10;
-		knightAttackBrd |= ((uint64_t(1) << sq) & ~(FileMasks8[FILE_G] | FileMasks8[FILE_H])) >> 6;
-		knightAttackBrd |= ((uint64_t(1) << sq) & ~FileMasks8[FILE_H]) >> 15;
-		knightAttackBrd |= ((uint64_t(1) << sq) & ~FileMasks8[FILE_A]) >> 17;
-		knightAttackBrd |= ((uint64_t(1) << sq) & ~(FileMasks8[FILE_A] | FileMasks8[FILE_B])) << 6;
-		knightAttackBrd |= ((uint64_t(1) << sq) & ~(FileMasks8[FILE_A] | FileMasks8[FILE_B])) >> 10;
-
-		knight_attacks[sq] = knightAttackBrd;
-	}
-
-}
-
-
-Bitboard BBS::king_attacks[64] = { 0 };
-
-void BBS::init_kingAttacks() {
-	Bitboard attackBrd = 0;
-
-	for (int sq = 0; sq < 64; sq++) {
-		attackBrd = 0;
-		Bitboard sqBrd = uint64_t(1) << sq;
-
-		attackBrd |= (sqBrd & ~RankMasks8[RANK_8]) << 8;
-		attackBrd |= (sqBrd & ~RankMasks8[RANK_1]) >> 8;
-		attackBrd |= (sqBrd & ~FileMasks8[FILE_H]) << 1;
-		attackBrd |= (sqBrd & ~FileMasks8[FILE_A]) >> 1;
-
-		attackBrd |= (sqBrd & ~(RankMasks8[RANK_8] | FileMasks8[FILE_A])) << 7;
-		attackBrd |= (sqBrd & ~(RankMasks8[RANK_8] | FileMasks8[FILE_H])) << 9;
-		attackBrd |= (sqBrd & ~(RankMasks8[RANK_1] | FileMasks8[FILE_A])) >> 9;
-		attackBrd |= (sqBrd & ~(RankMasks8[RANK_1] | FileMasks8[FILE_H])) >> 7;
-
-
-
-		king_attacks[sq] = attackBrd;
-	}
-}
-
+#if defined(HAS_PEXT_INSTRUCTION)
+#include <immintrin.h>
+#endif
 
 Bitboard BBS::Zobrist::piece_keys[2][6][64] = { {{0}} };
 Bitboard BBS::Zobrist::empty_keys[64] = { 0 };
@@ -99,366 +54,95 @@ void BBS::Zobrist::init_zobrist() {
 
 
 
-Bitboard BBS::EvalBitMasks::passed_pawn_masks[2][64] = { {0} };
-Bitboard BBS::EvalBitMasks::isolated_bitmasks[8] = { 0 };
-Bitboard BBS::EvalBitMasks::outpost_masks[2][64] = { {0} };
-Bitboard BBS::EvalBitMasks::rear_span_masks[2][64] = { {0} };
-Bitboard BBS::EvalBitMasks::backwards_masks[2][64] = { {0} };
-Bitboard BBS::EvalBitMasks::outer_kingring[64] = { 0 };
-
-void BBS::EvalBitMasks::initBitMasks() {
-	Bitboard bitmask = 0;
-	/*
-	Passed pawn bitmasks
-	*/
-	for (int sq = 0; sq < 64; sq++) {
-		bitmask = 0;
-
-		int r = sq / 8;
-		int f = sq % 8;
-
-
-		Bitboard flankmask = 0;
-
-		flankmask |= FileMasks8[f];
-
-		if (f > FILE_A) {
-			flankmask |= FileMasks8[f - 1];
-		}
-		if (f < FILE_H) {
-			flankmask |= FileMasks8[f + 1];
-		}
-
-		// Create the bitmask for the white pawns
-		for (int i = r + 1; i <= RANK_8; i++) {
-			bitmask |= (flankmask & RankMasks8[i]);
-		}
-		passed_pawn_masks[WHITE][sq] = bitmask;
-
-		// Now do it for the black ones.
-		bitmask = 0;
-		for (int i = r - 1; i >= RANK_1; i--) {
-			bitmask |= (flankmask & RankMasks8[i]);
-		}
-		passed_pawn_masks[BLACK][sq] = bitmask;
-	}
-
-
-
-	/*
-	Isolated bitmasks
-	*/
-	
-	for (int f = FILE_A; f <= FILE_H; f++) {
-		bitmask = 0;
-
-		// If a pawn is isolated, there are no pawns on the files directly next to it.
-		// We shouln't include the file that the pawn is on itself, since we'd not be able to recognize it as isolated if it were doubled.
-		bitmask = ((f > FILE_A) ? FileMasks8[f - 1] : 0) | ((f < FILE_H) ? FileMasks8[f + 1] : 0);
-
-		isolated_bitmasks[f] = bitmask;
-	}
-
-	/*
-	
-	Outpost masks -> these can just be made by AND'ing the isolated bitmasks and passed pawn bitmasks.
-	
-	*/
-	for (int sq = 0; sq < 64; sq++) {
-
-		outpost_masks[WHITE][sq] = (passed_pawn_masks[WHITE][sq] & isolated_bitmasks[sq % 8]);
-		outpost_masks[BLACK][sq] = (passed_pawn_masks[BLACK][sq] & isolated_bitmasks[sq % 8]);
-
-	}
-
-
-	/*
-	
-	Rearspan bitmasks. The squares behind pawns.
-	
-	*/
-
-	for (int sq = 0; sq < 64; sq++) {
-		rear_span_masks[WHITE][sq] = (passed_pawn_masks[BLACK][sq] & BBS::FileMasks8[sq % 8]);
-		rear_span_masks[BLACK][sq] = (passed_pawn_masks[WHITE][sq] & BBS::FileMasks8[sq % 8]);
-	}
-
-
-	/*
-	
-	Backwards bitmasks. These are the squares on the current rank and all others behind it, on the adjacent files if a square.
-	
-	*/
-
-	for (int sq = 0; sq < 64; sq++) {
-
-		backwards_masks[WHITE][sq] = (passed_pawn_masks[BLACK][sq] & ~BBS::FileMasks8[sq % 8]);
-		backwards_masks[BLACK][sq] = (passed_pawn_masks[WHITE][sq] & ~BBS::FileMasks8[sq % 8]);
-
-		if (sq % 8 != FILE_H) {
-			backwards_masks[WHITE][sq] |= (uint64_t(1) << (sq + 1));
-			backwards_masks[BLACK][sq] |= (uint64_t(1) << (sq + 1));
-		}
-		if (sq % 8 != FILE_A) {
-			backwards_masks[WHITE][sq] |= (uint64_t(1) << (sq - 1));
-			backwards_masks[BLACK][sq] |= (uint64_t(1) << (sq - 1));
-		}
-	}
-
-
-	/*
-	
-	Outer king-rings. These are just the 16 squares on the outside of the ring, that the king would be able to move to on an empty board.
-	
-	*/
-	for (int sq = 0; sq < 64; sq++) {
-
-		Bitboard ring = 0;
-		int rnk = sq / 8;
-		int fl = sq % 8;
-
-		for (int r = std::max(0, rnk - 2); r <= std::min(7, rnk + 2); r++) {
-
-			for (int f = std::max(0, fl - 2); f <= std::min(7, fl + 2); f++) {
-
-				ring |= (BBS::FileMasks8[f] & BBS::RankMasks8[r]);
-
-			}
-		}
-
-		ring ^= BBS::king_attacks[sq];
-		ring ^= (uint64_t(1) << sq);
-
-		outer_kingring[sq] = ring;
-	}
-
-}
-
-
-
 void BBS::INIT() {
-	init_knightAttacks();
-	init_kingAttacks();
-
 	Zobrist::init_zobrist();
-
-	EvalBitMasks::initBitMasks();
-
 }
 
 
 
 void Magics::INIT() {
-	_initialize_slider_tables(true);
-	_initialize_slider_tables(false);
+	set_backend(CPU::has_fast_pext() ? PEXT_BACKEND : MAGIC_BACKEND);
 }
 
 
 
 namespace Magics {
 
-	Bitboard _bishopAttacks[64][512] = { {0} };
-	Bitboard _rookAttacks[64][4096] = { {0} };
-
-	Bitboard magic_rook_masks[64] = { 0 };
-	Bitboard magic_bishop_masks[64] = { 0 };
-
-
-	Bitboard set_occupancy(int index, int bit_cnt, Bitboard mask) {
-		Bitboard occupancy = 0;
-
-		for (int count = 0; count < bit_cnt; count++) {
-
-			int square = bitScanForward(mask);
+	SquareMagic rook_square_magics[64];
+	SquareMagic bishop_square_magics[64];
 
-			mask ^= (uint64_t(1) << square);
+	alignas(64) Bitboard attack_table[ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE] = { 0 };
 
-			if (index & (uint64_t(1) << count)) {
-				occupancy |= (uint64_t(1) << square);
-			}
+	SliderBackend backend = MAGIC_BACKEND;
 
-		}
-		return occupancy;
+	namespace {
+		// Whether or not attack_table has been filled for the current backend.
+		bool table_initialized = false;
 	}
 
-	template<>
-	Bitboard _getSlowAttack<BISHOP>(int sq, Bitboard occupied) {
-		Bitboard attackBrd = 0;
-
-		/*
-		NORTH WEST
-		*/
-
-		int r = (sq / 8) + 1;
-		int f = (sq % 8) - 1;
-
-		int cnt = 0;
-
-		while ((r <= RANK_8 && f >= FILE_A) && cnt < 1) {
-			attackBrd |= uint64_t(1) << (r * 8 + f);
-
-			if (((uint64_t(1) << (r * 8 + f)) & occupied) != 0) {
-				cnt++;
-			}
-
-			r++;
-			f--;
-		}
-
-		/*
-		NORTH EAST
-		*/
-
-
-		r = (sq / 8) + 1;
-		f = (sq % 8) + 1;
-
-		cnt = 0;
-
-		while ((r <= RANK_8 && f <= FILE_H) && cnt < 1) {
-			attackBrd |= uint64_t(1) << (r * 8 + f);
-
-			if (((uint64_t(1) << (r * 8 + f)) & occupied) != 0) {
-				cnt++;
-			}
-
-			r++;
-			f++;
-		}
-
-		/*
-		SOUTH WEST
-		*/
-
-		r = (sq / 8) - 1;
-		f = (sq % 8) - 1;
-
-		cnt = 0;
-
-		while ((r >= RANK_1 && f >= FILE_A) && cnt < 1) {
-			attackBrd |= uint64_t(1) << (r * 8 + f);
-
-			if (((uint64_t(1) << (r * 8 + f)) & occupied) != 0) {
-				cnt++;
-			}
 
-			r--;
-			f--;
-		}
-
-		/*
-		SOUTH EAST
-		*/
-
-		r = (sq / 8) - 1;
-		f = (sq % 8) + 1;
+	bool backend_available(SliderBackend b) {
+#if defined(HAS_PEXT_INSTRUCTION)
+		return b == MAGIC_BACKEND || CPU::has_bmi2();
+#else
+		return b == MAGIC_BACKEND;
+#endif
+	}
 
-		cnt = 0;
 
-		while ((r >= RANK_1 && f <= FILE_H) && cnt < 1) {
-			attackBrd |= uint64_t(1) << (r * 8 + f);
+	void set_backend(SliderBackend b) {
+		assert(backend_available(b));
 
-			if (((uint64_t(1) << (r * 8 + f)) & occupied) != 0) {
-				cnt++;
-			}
+		if (!table_initialized || b != backend) {
+			_initialize_slider_tables(true, b);
+			_initialize_slider_tables(false, b);
 
-			r--;
-			f++;
+			table_initialized = true;
 		}
 
-
-
-		return attackBrd;
+		backend = b;
 	}
 
-	template<>
-	Bitboard _getSlowAttack<ROOK>(int sq, Bitboard occupied) {
-		Bitboard attackBrd = 0;
-
-		/*
-		NORTH
-		*/
-		int r = (sq / 8) + 1;
-		int f = sq % 8;
-
-		int cnt = 0;
 
-		while (r <= RANK_8 && cnt < 1) {
-			attackBrd |= uint64_t(1) << (r * 8 + f);
+	std::string backend_name(SliderBackend b) {
+		return (b == PEXT_BACKEND) ? "pext" : "magic";
+	}
 
-			if (((uint64_t(1) << (r * 8 + f)) & occupied) != 0) {
-				cnt++;
-			}
-
-			r++;
-		}
 
+	namespace {
 
 		/*
-		SOUTH
+		The squares from sq to the edge of the board in the direction (dr, df).
 		*/
+		Bitboard ray(int sq, int dr, int df) {
+			Bitboard squares = 0;
 
-		r = (sq / 8) - 1;
-		f = sq % 8;
-
-		cnt = 0;
-
-		while (r >= RANK_1 && cnt < 1) {
-			attackBrd |= uint64_t(1) << (r * 8 + f);
-
-			if (((uint64_t(1) << (r * 8 + f)) & occupied) != 0) {
-				cnt++;
+			for (int r = sq / 8 + dr, f = sq % 8 + df; r >= RANK_1 && r <= RANK_8 && f >= FILE_A && f <= FILE_H; r += dr, f += df) {
+				squares |= uint64_t(1) << (r * 8 + f);
 			}
 
-			r--;
+			return squares;
 		}
 
 
 		/*
-		EAST
+		The attacks along a ray, which stop at the first blocker. For rays pointing towards higher squares this is the lowest blocker, and for the
+		others it is the highest.
 		*/
+		inline Bitboard ray_attacks(int sq, Bitboard ray, bool increasing, Bitboard occupied) {
+			Bitboard blockers = ray & occupied;
 
-		f = (sq % 8) + 1;
-		r = sq / 8;
-
-		cnt = 0;
-
-		while (f <= FILE_H && cnt < 1) {
-			attackBrd |= uint64_t(1) << (r * 8 + f);
-
-			if (((uint64_t(1) << (r * 8 + f)) & occupied) != 0) {
-				cnt++;
+			if (blockers == 0) {
+				return ray;
 			}
 
-			f++;
-		}
-
-
-		/*
-		WEST
-		*/
-
-		f = (sq % 8) - 1;
-		r = sq / 8;
-
-		cnt = 0;
+			int blocker = (increasing) ? bitScanForward(blockers) : bitScanReverse(blockers);
 
-		while (f >= FILE_A && cnt < 1) {
-			attackBrd |= uint64_t(1) << (r * 8 + f);
-
-			if (((uint64_t(1) << (r * 8 + f)) & occupied) != 0) {
-				cnt++;
-			}
-
-			f--;
+			return BBS::between_squares[sq][blocker] | (uint64_t(1) << blocker);
 		}
-	
-		
-		return attackBrd;
 	}
 
 
-
 	namespace {
 
 		// mask bishop attacks
@@ -509,58 +193,99 @@ namespace Magics {
 	}
 
 
-	void _initialize_slider_tables(bool is_rook) {
+	void _initialize_slider_tables(bool is_rook, SliderBackend b) {
+		SquareMagic* square_magics = (is_rook) ? rook_square_magics : bishop_square_magics;
+
+		// The rook attacks come first in attack_table, followed by the bishop attacks.
+		Bitboard* table = (is_rook) ? attack_table : attack_table + ROOK_TABLE_SIZE;
+
+		// The directions of the piece as (rank, file) steps.
+		const int directions[2][4][2] = {
+			{ {1, 1}, {1, -1}, {-1, 1}, {-1, -1} },
+			{ {1, 0}, {0, 1}, {-1, 0}, {0, -1} }
+		};
 
 		// Loop through each square.
 		for (int sq = 0; sq < 64; sq++) {
+			SquareMagic& m = square_magics[sq];
 
-			magic_bishop_masks[sq] = bishopMask(sq);
-			magic_rook_masks[sq] = rookMask(sq);
+			m.mask = (is_rook) ? rookMask(sq) : bishopMask(sq);
+			m.magic = (is_rook) ? rook_magics[sq] : bishop_magics[sq];
+			m.shift = 64 - ((is_rook) ? rook_relevant_bits[sq] : bishop_relevant_bits[sq]);
+			m.attacks = table;
 
-			Bitboard mask = (is_rook) ? rookMask(sq) : bishopMask(sq);
+			Bitboard rays[4] = { 0 };
+			bool increasing[4] = { false };
 
-			int bit_count = countBits(mask);
+			for (int d = 0; d < 4; d++) {
+				rays[d] = ray(sq, directions[is_rook][d][0], directions[is_rook][d][1]);
+				increasing[d] = 8 * directions[is_rook][d][0] + directions[is_rook][d][1] > 0;
+			}
 
-			int occupancy_variations = uint64_t(1) << bit_count;
+			// The occupancies are enumerated with the Carry-Rippler trick, which visits the subsets of the mask in increasing order. This is also the
+			//	order of their PEXT indices, so the PEXT index of an occupancy is just the count.
+			Bitboard occupancy = 0;
+			int count = 0;
 
-			for (int count = 0; count < occupancy_variations; count++) {
-				Bitboard occupancy = set_occupancy(count, bit_count, mask);
+			do {
+				unsigned int index = (b == PEXT_BACKEND) ? unsigned(count) : m.index(occupancy);
 
-				if (is_rook) {
-					uint64_t magic_index = occupancy * rook_magics[sq] >> (64 - rook_relevant_bits[sq]);
-					_rookAttacks[sq][magic_index] = _getSlowAttack<ROOK>(sq, occupancy);
+				Bitboard attacks = 0;
+				for (int d = 0; d < 4; d++) {
+					attacks |= ray_attacks(sq, rays[d], increasing[d], occupancy);
 				}
 
-				else {
-					uint64_t magic_index = occupancy * bishop_magics[sq] >> (64 - bishop_relevant_bits[sq]);
-					_bishopAttacks[sq][magic_index] = _getSlowAttack<BISHOP>(sq, occupancy);
-				}
-			}
+				m.attacks[index] = attacks;
 
+				count++;
+				occupancy = (occupancy - m.mask) & m.mask;
+			} while (occupancy != 0);
+
+			table += count;
 		}
 
+		assert(table == ((is_rook) ? attack_table + ROOK_TABLE_SIZE : attack_table + ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE));
 	}
 
 
+#if defined(HAS_PEXT_INSTRUCTION)
+	namespace {
+		/*
+		The PEXT lookup. This is kept out of attacks_bb so that the rest of the engine is never compiled with BMI2 instructions, unless the build
+		targets BMI2 anyways.
+		*/
+		TARGET_BMI2 Bitboard pext_attacks(const SquareMagic& m, Bitboard occ) {
+			return m.attacks[_pext_u64(occ, m.mask)];
+		}
+	}
+#endif
+
+
 
 	template <>
 	Bitboard attacks_bb<ROOK>(int sq, Bitboard occ) {
-		//return _rookAttacks[sq][(occ & magic_rook_masks[sq]) * rook_magics[sq] >> 64 - rook_relevant_bits[sq]];
-		occ &= magic_rook_masks[sq];
-		occ *= rook_magics[sq];
-		occ >>= (64 - rook_relevant_bits[sq]);
+		const SquareMagic& m = rook_square_magics[sq];
+
+#if defined(HAS_PEXT_INSTRUCTION)
+		if (backend == PEXT_BACKEND) {
+			return pext_attacks(m, occ);
+		}
+#endif
 
-		return _rookAttacks[sq][occ];
+		return m.attacks[m.index(occ)];
 	}
 
 	template <>
 	Bitboard attacks_bb<BISHOP>(int sq, Bitboard occ) {
-		//return _bishopAttacks[sq][(occ & magic_bishop_masks[sq]) * bishop_magics[sq] >> 64 - bishop_relevant_bits[sq]];
-		occ &= magic_bishop_masks[sq];
-		occ *= bishop_magics[sq];
-		occ >>= (64 - bishop_relevant_bits[sq]);
+		const SquareMagic& m = bishop_square_magics[sq];
+
+#if defined(HAS_PEXT_INSTRUCTION)
+		if (backend == PEXT_BACKEND) {
+			return pext_attacks(m, occ);
+		}
+#endif
 
-		return _bishopAttacks[sq][occ];
+		return m.attacks[m.index(occ)];
 	}
 
 	template <>
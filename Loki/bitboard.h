@@ -19,6 +19,8 @@
 #define BITBOARD_H
 
 #include "defs.h"
+#include "cpu.h"
+#include <array>
 #include <string>
 
 
@@ -30,8 +32,8 @@
 #endif
 
 namespace BBS {
-	const Bitboard EMPTY = std::stoull("0000000000000000000000000000000000000000000000000000000000000000", nullptr, 2);
-	const Bitboard UNIVERSE = std::stoull("1111111111111111111111111111111111111111111111111111111111111111", nullptr, 2);
+	constexpr Bitboard EMPTY = 0ULL;
+	constexpr Bitboard UNIVERSE = ~0ULL;
 
 	constexpr Bitboard DARK_SQUARES = 12273903644374837845ULL;
 	constexpr Bitboard LIGHT_SQUARES = ~DARK_SQUARES;
@@ -101,11 +103,82 @@ namespace BBS {
 	};
 
 
+	/*
+	The tables below are generated by constexpr functions, so they are computed by the compiler and placed in read-only data instead of being
+	initialized on startup.
+	*/
+
+	constexpr std::array<Bitboard, 64> make_knight_attacks() {
+		std::array<Bitboard, 64> attacks = {};
+
+		for (int sq = 0; sq < 64; sq++) {
+			Bitboard sqBrd = uint64_t(1) << sq;
+
+			attacks[sq] = ((sqBrd & ~FileMasks8[FILE_H]) << 17)
+				| ((sqBrd & ~FileMasks8[FILE_A]) << 15)
+				| ((sqBrd & ~(FileMasks8[FILE_G] | FileMasks8[FILE_H])) << 10)
+				| ((sqBrd & ~(FileMasks8[FILE_G] | FileMasks8[FILE_H])) >> 6)
+				| ((sqBrd & ~FileMasks8[FILE_H]) >> 15)
+				| ((sqBrd & ~FileMasks8[FILE_A]) >> 17)
+				| ((sqBrd & ~(FileMasks8[FILE_A] | FileMasks8[FILE_B])) << 6)
+				| ((sqBrd & ~(FileMasks8[FILE_A] | FileMasks8[FILE_B])) >> 10);
+		}
+
+		return attacks;
+	}
+
+	constexpr std::array<Bitboard, 64> make_king_attacks() {
+		std::array<Bitboard, 64> attacks = {};
+
+		for (int sq = 0; sq < 64; sq++) {
+			Bitboard sqBrd = uint64_t(1) << sq;
+
+			attacks[sq] = ((sqBrd & ~RankMasks8[RANK_8]) << 8)
+				| ((sqBrd & ~RankMasks8[RANK_1]) >> 8)
+				| ((sqBrd & ~FileMasks8[FILE_H]) << 1)
+				| ((sqBrd & ~FileMasks8[FILE_A]) >> 1)
+				| ((sqBrd & ~(RankMasks8[RANK_8] | FileMasks8[FILE_A])) << 7)
+				| ((sqBrd & ~(RankMasks8[RANK_8] | FileMasks8[FILE_H])) << 9)
+				| ((sqBrd & ~(RankMasks8[RANK_1] | FileMasks8[FILE_A])) >> 9)
+				| ((sqBrd & ~(RankMasks8[RANK_1] | FileMasks8[FILE_H])) >> 7);
+		}
+
+		return attacks;
+	}
+
+	// From every square we'll walk in all eight directions, and each square reached gets the squares walked over so far.
+	constexpr std::array<std::array<Bitboard, 64>, 64> make_between_squares() {
+		std::array<std::array<Bitboard, 64>, 64> between = {};
+		const int directions[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+		for (int sq = 0; sq < 64; sq++) {
+			for (int d = 0; d < 8; d++) {
+				Bitboard squares = 0;
+				int r = sq / 8 + directions[d][0];
+				int f = sq % 8 + directions[d][1];
+
+				while (r >= RANK_1 && r <= RANK_8 && f >= FILE_A && f <= FILE_H) {
+					between[sq][r * 8 + f] = squares;
+					squares |= uint64_t(1) << (r * 8 + f);
+
+					r += directions[d][0];
+					f += directions[d][1];
+				}
+			}
+		}
+
+		return between;
+	}
+
+
 	// knight_attacks[fromSq]
-	extern Bitboard knight_attacks[64];
+	inline constexpr std::array<Bitboard, 64> knight_attacks = make_knight_attacks();
 
 	// king_attacks[fromSq]
-	extern Bitboard king_attacks[64];
+	inline constexpr std::array<Bitboard, 64> king_attacks = make_king_attacks();
+
+	// between_squares[sq1][sq2] holds the squares strictly between sq1 and sq2 if they share a rank, file or diagonal, and is empty otherwise.
+	inline constexpr std::array<std::array<Bitboard, 64>, 64> between_squares = make_between_squares();
 
 
 	namespace Zobrist {
@@ -126,23 +199,113 @@ namespace BBS {
 
 
 	namespace EvalBitMasks {
-		extern Bitboard passed_pawn_masks[2][64];
-		extern Bitboard isolated_bitmasks[8];
+		typedef std::array<std::array<Bitboard, 64>, 2> ColoredMasks;
 
-		extern Bitboard outpost_masks[2][64];
+		// The squares in front of a pawn on its own and the adjacent files.
+		constexpr ColoredMasks make_passed_pawn_masks() {
+			ColoredMasks masks = {};
 
-		extern Bitboard rear_span_masks[2][64];
+			for (int sq = 0; sq < 64; sq++) {
+				int r = sq / 8;
+				int f = sq % 8;
 
-		extern Bitboard backwards_masks[2][64];
+				Bitboard flankmask = FileMasks8[f] | ((f > FILE_A) ? FileMasks8[f - 1] : 0) | ((f < FILE_H) ? FileMasks8[f + 1] : 0);
 
-		extern Bitboard outer_kingring[64];
+				for (int i = r + 1; i <= RANK_8; i++) {
+					masks[WHITE][sq] |= (flankmask & RankMasks8[i]);
+				}
+				for (int i = r - 1; i >= RANK_1; i--) {
+					masks[BLACK][sq] |= (flankmask & RankMasks8[i]);
+				}
+			}
 
-		void initBitMasks();
-	}
+			return masks;
+		}
+
+		// If a pawn is isolated, there are no pawns on the files directly next to it. We shouln't include the file that the pawn is on itself, since
+		// we'd not be able to recognize it as isolated if it were doubled.
+		constexpr std::array<Bitboard, 8> make_isolated_bitmasks() {
+			std::array<Bitboard, 8> masks = {};
+
+			for (int f = FILE_A; f <= FILE_H; f++) {
+				masks[f] = ((f > FILE_A) ? FileMasks8[f - 1] : 0) | ((f < FILE_H) ? FileMasks8[f + 1] : 0);
+			}
+
+			return masks;
+		}
+
+		// Outpost masks are the passed pawn masks without the pawn's own file.
+		constexpr ColoredMasks make_outpost_masks(const ColoredMasks& passed, const std::array<Bitboard, 8>& isolated) {
+			ColoredMasks masks = {};
+
+			for (int sq = 0; sq < 64; sq++) {
+				masks[WHITE][sq] = (passed[WHITE][sq] & isolated[sq % 8]);
+				masks[BLACK][sq] = (passed[BLACK][sq] & isolated[sq % 8]);
+			}
+
+			return masks;
+		}
 
+		// Rearspan bitmasks. The squares behind pawns.
+		constexpr ColoredMasks make_rear_span_masks(const ColoredMasks& passed) {
+			ColoredMasks masks = {};
+
+			for (int sq = 0; sq < 64; sq++) {
+				masks[WHITE][sq] = (passed[BLACK][sq] & FileMasks8[sq % 8]);
+				masks[BLACK][sq] = (passed[WHITE][sq] & FileMasks8[sq % 8]);
+			}
+
+			return masks;
+		}
+
+		// Backwards bitmasks. These are the squares on the current rank and all others behind it, on the adjacent files if a square.
+		constexpr ColoredMasks make_backwards_masks(const ColoredMasks& passed) {
+			ColoredMasks masks = {};
+
+			for (int sq = 0; sq < 64; sq++) {
+				Bitboard neighbours = ((sq % 8 != FILE_H) ? (uint64_t(1) << (sq + 1)) : 0) | ((sq % 8 != FILE_A) ? (uint64_t(1) << (sq - 1)) : 0);
+
+				masks[WHITE][sq] = (passed[BLACK][sq] & ~FileMasks8[sq % 8]) | neighbours;
+				masks[BLACK][sq] = (passed[WHITE][sq] & ~FileMasks8[sq % 8]) | neighbours;
+			}
+
+			return masks;
+		}
+
+		// Outer king-rings. These are just the 16 squares on the outside of the ring, that the king would be able to move to on an empty board.
+		constexpr std::array<Bitboard, 64> make_outer_kingring() {
+			std::array<Bitboard, 64> rings = {};
+
+			for (int sq = 0; sq < 64; sq++) {
+				int rnk = sq / 8;
+				int fl = sq % 8;
+
+				for (int r = ((rnk - 2 > 0) ? rnk - 2 : 0); r <= ((rnk + 2 < 7) ? rnk + 2 : 7); r++) {
+					for (int f = ((fl - 2 > 0) ? fl - 2 : 0); f <= ((fl + 2 < 7) ? fl + 2 : 7); f++) {
+						rings[sq] |= (FileMasks8[f] & RankMasks8[r]);
+					}
+				}
+
+				rings[sq] ^= king_attacks[sq];
+				rings[sq] ^= (uint64_t(1) << sq);
+			}
+
+			return rings;
+		}
+
+
+		inline constexpr ColoredMasks passed_pawn_masks = make_passed_pawn_masks();
+		inline constexpr std::array<Bitboard, 8> isolated_bitmasks = make_isolated_bitmasks();
+
+		inline constexpr ColoredMasks outpost_masks = make_outpost_masks(passed_pawn_masks, isolated_bitmasks);
+
+		inline constexpr ColoredMasks rear_span_masks = make_rear_span_masks(passed_pawn_masks);
+
+		inline constexpr ColoredMasks backwards_masks = make_backwards_masks(passed_pawn_masks);
+
+		inline constexpr std::array<Bitboard, 64> outer_kingring = make_outer_kingring();
+	}
 
-	void init_knightAttacks();
-	void init_kingAttacks();
 
 	void INIT();
 }
@@ -157,19 +320,51 @@ namespace Magics {
 	extern const int rook_relevant_bits[64];
 	extern const int bishop_relevant_bits[64];
 
-	// All attack masks of rooks and bishops excluding edges.
-	extern Bitboard magic_rook_masks[64];
-	extern Bitboard magic_bishop_masks[64];
+	// Everything needed to look up the attacks of a slider on one square, packed into 32 bytes so two squares share a cache line.
+	struct alignas(32) SquareMagic {
+		// The attack mask excluding edges.
+		Bitboard mask = 0;
+		Bitboard magic = 0;
+
+		// The first of the 2^relevant_bits attack boards of the square in attack_table.
+		Bitboard* attacks = nullptr;
+
+		// 64 - relevant_bits.
+		unsigned int shift = 0;
+
+		// The index of an occupancy with the multiplication magics.
+		inline unsigned int index(Bitboard occ) const {
+			return unsigned(((occ & mask) * magic) >> shift);
+		}
+	};
+
+	extern SquareMagic rook_square_magics[64];
+	extern SquareMagic bishop_square_magics[64];
+
+
+	// One contiguous table holding the attacks of all squares for both rooks and bishops. Each square only gets the 2^relevant_bits entries it
+	// needs, which is ~840KB instead of the 2.3MB needed to reserve the worst case for every square.
+	constexpr int ROOK_TABLE_SIZE = 102400;
+	constexpr int BISHOP_TABLE_SIZE = 5248;
+
+	extern Bitboard attack_table[ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE];
+
+
+	// The implementations of attacks_bb. PEXT computes the table index directly from the occupancy with a BMI2 instruction, and is selected at
+	// startup if the processor has a fast implementation of it.
+	enum SliderBackend :int { MAGIC_BACKEND = 0, PEXT_BACKEND = 1 };
+	extern SliderBackend backend;
+
+	// Returns true if the backend can be used on this processor.
+	bool backend_available(SliderBackend b);
 
+	// Uses the backend in attacks_bb from now on. Both backends share attack_table, but index it differently, so it is refilled on a change.
+	void set_backend(SliderBackend b);
 
-	// These are the tables holding all attacks to different occupancies on each square.
-	extern Bitboard _bishopAttacks[64][512];
-	extern Bitboard _rookAttacks[64][4096];
+	std::string backend_name(SliderBackend b);
 
-	// These functios are only used to initialize _bishopAttacks and _rookAttacks
-	template<piece PCE> Bitboard _getSlowAttack(int sq, Bitboard occupied);
-	void _initialize_slider_tables(bool is_rook);
-	Bitboard set_occupancy(int index, int bit_cnt, Bitboard mask);
+	// Fills attack_table and the SquareMagic records of rooks or bishops for a backend.
+	void _initialize_slider_tables(bool is_rook, SliderBackend b);
 
 	// To initialize the bishopMagics, rookMagics and all attack tables.
 	void INIT();
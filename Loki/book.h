@@ -0,0 +1,50 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef BOOK_H
+#define BOOK_H
+#include "movegen.h"
+
+#include <string>
+
+
+/*
+
+Polyglot opening books. A book is a file of 16-byte entries sorted by the Polyglot hash key of their positions, so the moves of a position are
+found by a binary search. The file is memory-mapped, and the key is computed from scratch since it doesn't use Loki's own zobrist keys.
+
+*/
+namespace Book {
+
+	// Maps a book into memory and returns false if it couldn't be opened or isn't a Polyglot book. "<empty>" or an empty string unloads the book.
+	bool load(const std::string& path);
+
+	bool is_loaded();
+
+	// The number of entries in the loaded book.
+	size_t size();
+
+	// The Polyglot hash key of a position.
+	uint64_t polyglot_key(const GameState_t* pos);
+
+	// Picks one of the book moves of the position with a probability proportional to its weight. Returns NOMOVE if the position isn't in the
+	//	book.
+	unsigned int probe(GameState_t* pos);
+}
+
+
+#endif
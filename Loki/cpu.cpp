@@ -0,0 +1,168 @@
+/*
+    Loki, a UCI-compliant chess playing software
+    Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+    Loki is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Loki is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "cpu.h"
+
+#if defined(HAS_PEXT_INSTRUCTION)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+
+namespace CPU {
+
+	namespace {
+
+		/*
+		Run the cpuid instruction for a leaf and subleaf. The registers are returned in the order eax, ebx, ecx, edx. On other architectures than
+		x86-64, everything is zero.
+		*/
+		void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+			regs[0] = regs[1] = regs[2] = regs[3] = 0;
+
+#if defined(HAS_PEXT_INSTRUCTION)
+#if defined(_MSC_VER)
+			int r[4] = { 0 };
+			__cpuidex(r, int(leaf), int(subleaf));
+
+			for (int i = 0; i < 4; i++) {
+				regs[i] = (unsigned int)r[i];
+			}
+#else
+			__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+#endif
+		}
+
+
+		// The highest standard leaf supported.
+		unsigned int max_leaf() {
+			unsigned int regs[4];
+			cpuid(0, 0, regs);
+
+			return regs[0];
+		}
+
+
+		// The vendor string is held in ebx, edx and ecx of leaf 0. "AuthenticAMD" is "Auth", "enti" and "cAMD".
+		bool is_amd() {
+			unsigned int regs[4];
+			cpuid(0, 0, regs);
+
+			return regs[1] == 0x68747541 && regs[3] == 0x69746e65 && regs[2] == 0x444d4163;
+		}
+
+
+		// The processor family from leaf 1. The extended family is only added if the base family is 0xF.
+		unsigned int family() {
+			unsigned int regs[4];
+			cpuid(1, 0, regs);
+
+			unsigned int base_family = (regs[0] >> 8) & 0xF;
+
+			return (base_family == 0xF) ? base_family + ((regs[0] >> 20) & 0xFF) : base_family;
+		}
+	}
+
+
+	bool has_bmi2() {
+		if (max_leaf() < 7) {
+			return false;
+		}
+
+		// BMI2 is bit 8 of ebx in leaf 7.
+		unsigned int regs[4];
+		cpuid(7, 0, regs);
+
+		return (regs[1] >> 8) & 1;
+	}
+
+
+	bool has_avx2() {
+#if defined(HAS_PEXT_INSTRUCTION) && defined(__GNUC__)
+		__builtin_cpu_init();
+
+		return __builtin_cpu_supports("avx2");
+#elif defined(HAS_PEXT_INSTRUCTION) && defined(_MSC_VER)
+		if (max_leaf() < 7) {
+			return false;
+		}
+
+		// OSXSAVE is bit 27 of ecx in leaf 1, and the OS has to have enabled both the SSE and AVX state in XCR0.
+		unsigned int regs[4];
+		cpuid(1, 0, regs);
+
+		if (!((regs[2] >> 27) & 1) || (_xgetbv(0) & 6) != 6) {
+			return false;
+		}
+
+		// AVX2 is bit 5 of ebx in leaf 7.
+		cpuid(7, 0, regs);
+
+		return (regs[1] >> 5) & 1;
+#else
+		return false;
+#endif
+	}
+
+
+	bool has_fast_pext() {
+		// Zen 3 is family 0x19.
+		return has_bmi2() && !(is_amd() && family() < 0x19);
+	}
+
+
+	InstructionSet instruction_set() {
+#if defined(USE_TARGET_CLONES)
+		// Ask the same way as the ifunc resolvers do, so the answer is always the version that actually runs.
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("x86-64-v4")) {
+			return AVX512;
+		}
+		if (__builtin_cpu_supports("x86-64-v3")) {
+			return AVX2;
+		}
+		if (__builtin_cpu_supports("x86-64-v2")) {
+			return SSE42;
+		}
+		return GENERIC;
+#elif defined(__AVX512F__) && defined(__AVX512BW__)
+		return AVX512;
+#elif defined(__AVX2__) && defined(__BMI2__)
+		return AVX2;
+#elif defined(__SSE4_2__) && defined(__POPCNT__)
+		return SSE42;
+#else
+		return GENERIC;
+#endif
+	}
+
+
+	std::string instruction_set_name(InstructionSet is) {
+		switch (is) {
+		case AVX512: return "avx512";
+		case AVX2: return "avx2-bmi2";
+		case SSE42: return "sse4.2-popcnt";
+		default: return "generic";
+		}
+	}
+}
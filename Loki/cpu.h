@@ -0,0 +1,83 @@
+/*
+    Loki, a UCI-compliant chess playing software
+    Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+    Loki is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Loki is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef CPU_H
+#define CPU_H
+
+#include <string>
+
+
+// The PEXT instruction only exists on x86-64. SSE2 is part of the x86-64 baseline, so it can always be used there.
+#if defined(__x86_64__) || defined(_M_X64)
+#define HAS_PEXT_INSTRUCTION
+#define HAS_SSE2_INSTRUCTIONS
+#endif
+
+// GCC and Clang only allow BMI2 and AVX2 intrinsics in functions that are marked as using them when the build itself doesn't target these. Such
+// functions may only be called after checking that the processor supports it.
+#if defined(__GNUC__)
+#define TARGET_BMI2 __attribute__((target("bmi2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_BMI2
+#define TARGET_AVX2
+#endif
+
+/*
+GCC can compile a function once for every instruction set in a list and select the best version for the processor when the program is loaded. This
+lets a single portable binary use POPCNT, BMI2 and AVX-512 in the hottest functions. Everything they call within the same translation unit is
+flattened into them, since a function that is not inlined would only exist in its baseline version. It relies on ifuncs, so it is only available
+for ELF targets, and it is pointless if the build itself already targets AVX2.
+*/
+#if defined(__GNUC__) && !defined(__clang__) && defined(HAS_PEXT_INSTRUCTION) && defined(__ELF__) && !defined(__AVX2__)
+#define USE_TARGET_CLONES
+#define TARGET_CLONES __attribute__((target_clones("arch=x86-64-v4", "arch=x86-64-v3", "arch=x86-64-v2", "default"), flatten))
+#else
+#define TARGET_CLONES
+#endif
+
+
+namespace CPU {
+
+	// The x86-64 microarchitecture levels that hot functions are compiled for.
+	enum InstructionSet : int {
+		GENERIC = 0,	// Baseline x86-64 or any other architecture.
+		SSE42 = 1,		// x86-64-v2: SSE4.2 and POPCNT.
+		AVX2 = 2,		// x86-64-v3: AVX2, BMI1, BMI2 and LZCNT.
+		AVX512 = 3		// x86-64-v4: AVX-512 F, BW, CD, DQ and VL.
+	};
+
+	// Returns the instruction set of the function versions that are used. With target clones this is decided by the processor, otherwise by
+	// the compiler flags.
+	InstructionSet instruction_set();
+
+	std::string instruction_set_name(InstructionSet is);
+
+	// Returns true if the processor supports the BMI2 instruction set.
+	bool has_bmi2();
+
+	// Returns true if the processor supports AVX2 and the operating system saves the 256-bit registers.
+	bool has_avx2();
+
+	// Returns true if PEXT is worth using. AMD processors before Zen 3 implement it in microcode with a latency of hundreds of cycles, so on these
+	// a magic multiplication is much faster.
+	bool has_fast_pext();
+}
+
+
+
+#endif
@@ -64,6 +64,11 @@ enum DIRECTION:int{NORTH = 0, SOUTH = 1, EAST = 2, WEST = 3, NORTHWEST = 4, NORT
 constexpr int MAXDEPTH = 100;
 constexpr int INF = 40000;
 constexpr int MATE = INF - MAXDEPTH;
+
+// Tablebase wins are scored TB_WIN - ply. They are above the known wins of the evaluation and below the mate scores, so the search still prefers
+//	a mate it can see, and they fit in the 16 bits of a transposition table score.
+constexpr int TB_WIN = 20000 - MAXDEPTH;
+constexpr int TB_WIN_IN_MAX_PLY = TB_WIN - MAXDEPTH;
 constexpr int VALUE_NONE = 50000;
 
 
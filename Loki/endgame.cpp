@@ -0,0 +1,366 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "endgame.h"
+#include "evaluation.h"
+#include "bitbase.h"
+
+#include <map>
+
+
+
+namespace Endgame {
+
+	namespace {
+
+		// All registered endgames, indexed by material key. It is only read after INIT, so it can be shared between the search threads.
+		std::map<uint64_t, EndgameEvaluator> endgames;
+
+
+		/* --------------------------------------------------------------- */
+		/* --------------------------- Helpers --------------------------- */
+		/* --------------------------------------------------------------- */
+
+		// The number of king moves between two squares.
+		int distance(int sq1, int sq2) {
+			return std::max(std::abs(sq1 / 8 - sq2 / 8), std::abs(sq1 % 8 - sq2 % 8));
+		}
+
+		// A bonus for driving a king to the edge of the board. It is 90 in the corners and 6 in the center.
+		int push_to_edge(int sq) {
+			int rd = std::min(sq / 8, 7 - sq / 8);
+			int fd = std::min(sq % 8, 7 - sq % 8);
+
+			return 90 - (7 * fd * fd / 2 + 7 * rd * rd / 2);
+		}
+
+		// A bonus for keeping two kings close to each other.
+		int push_close(int sq1, int sq2) {
+			return 140 - 20 * distance(sq1, sq2);
+		}
+
+		// The distance of a square from the a8-h1 diagonal, which is the largest in the dark corners A1 and H8.
+		int push_to_corner(int sq) {
+			return std::abs(7 - sq / 8 - sq % 8);
+		}
+
+		// The side with more than a king in an endgame where the other side only has its king.
+		SIDE strong_side(const GameState_t* pos) {
+			return (pos->all_pieces[WHITE] != pos->pieceBBS[KING][WHITE]) ? WHITE : BLACK;
+		}
+
+		int non_pawn_material(const GameState_t* pos, SIDE side) {
+			return countBits(pos->pieceBBS[KNIGHT][side]) * knight_value.eg() + countBits(pos->pieceBBS[BISHOP][side]) * bishop_value.eg()
+				+ countBits(pos->pieceBBS[ROOK][side]) * rook_value.eg() + countBits(pos->pieceBBS[QUEEN][side]) * queen_value.eg();
+		}
+
+		// True if the side to move is a lone king that can't move without being captured, but isn't in check.
+		bool lone_king_stalemated(const GameState_t* pos) {
+			SIDE weak = pos->side_to_move;
+			int ksq = pos->king_squares[weak];
+
+			if (pos->in_check()) {
+				return false;
+			}
+
+			Bitboard occupied = (pos->all_pieces[WHITE] | pos->all_pieces[BLACK]) ^ (uint64_t(1) << ksq);
+			Bitboard moves = BBS::king_attacks[ksq];
+
+			while (moves) {
+				int to = PopBit(&moves);
+
+				if ((pos->attackers_to(to, occupied) & pos->all_pieces[(weak == WHITE) ? BLACK : WHITE]) == 0) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+
+		/* --------------------------------------------------------------- */
+		/* ------------------------- Evaluators -------------------------- */
+		/* --------------------------------------------------------------- */
+
+		/// <summary>
+		/// Endgames where neither side has enough material to force checkmate.
+		/// </summary>
+		int material_draw(const GameState_t*) {
+			return 0;
+		}
+
+
+		/// <summary>
+		/// A lone king against enough material to mate. The weak king is driven to the edge, and the strong king is brought close to it.
+		/// </summary>
+		int KXK(const GameState_t* pos) {
+			SIDE strong = strong_side(pos);
+			SIDE weak = (strong == WHITE) ? BLACK : WHITE;
+
+			// Step 1. The general search doesn't see stalemates with only a king left, so they are detected here.
+			if (pos->side_to_move == weak && lone_king_stalemated(pos)) {
+				return 0;
+			}
+
+			int strong_king = pos->king_squares[strong];
+			int weak_king = pos->king_squares[weak];
+
+			// Step 2. Count the material and the positions of the kings.
+			int v = non_pawn_material(pos, strong) + countBits(pos->pieceBBS[PAWN][strong]) * pawn_value.eg()
+				+ push_to_edge(weak_king) + push_close(strong_king, weak_king);
+
+			// Step 3. A queen, a rook, a bishop and knight or two bishops on different colors can force mate.
+			Bitboard bishops = pos->pieceBBS[BISHOP][strong];
+
+			if (pos->pieceBBS[QUEEN][strong] || pos->pieceBBS[ROOK][strong] || (bishops && pos->pieceBBS[KNIGHT][strong])
+				|| ((bishops & BBS::DARK_SQUARES) && (bishops & BBS::LIGHT_SQUARES))) {
+				v += KNOWN_WIN;
+			}
+
+			return (strong == WHITE) ? v : -v;
+		}
+
+
+		/// <summary>
+		/// King, bishop and knight against a lone king. The weak king has to be driven to a corner of the bishop's color.
+		/// </summary>
+		int KBNK(const GameState_t* pos) {
+			SIDE strong = strong_side(pos);
+			SIDE weak = (strong == WHITE) ? BLACK : WHITE;
+
+			int strong_king = pos->king_squares[strong];
+			int weak_king = pos->king_squares[weak];
+
+			// push_to_corner rewards the dark corners, so the board is mirrored if the bishop is light-squared.
+			if (pos->pieceBBS[BISHOP][strong] & BBS::LIGHT_SQUARES) {
+				weak_king ^= 7;
+			}
+
+			int v = KNOWN_WIN + 3520 + push_close(strong_king, pos->king_squares[weak]) + 420 * push_to_corner(weak_king);
+
+			return (strong == WHITE) ? v : -v;
+		}
+
+
+		/// <summary>
+		/// King and pawn against king. The result is looked up in the bitbase.
+		/// </summary>
+		int KPK(const GameState_t* pos) {
+			SIDE strong = strong_side(pos);
+			SIDE weak = (strong == WHITE) ? BLACK : WHITE;
+
+			// Step 1. Normalize the position so the pawn is white and on one of the files A-D.
+			int strong_king = pos->king_squares[strong];
+			int weak_king = pos->king_squares[weak];
+			int pawn = bitScanForward(pos->pieceBBS[PAWN][strong]);
+
+			if (strong == BLACK) {
+				strong_king ^= 56; weak_king ^= 56; pawn ^= 56;
+			}
+			if (pawn % 8 > FILE_D) {
+				strong_king ^= 7; weak_king ^= 7; pawn ^= 7;
+			}
+
+			SIDE stm = (pos->side_to_move == strong) ? WHITE : BLACK;
+
+			// Step 2. Probe the bitbase. A won position is scored higher the further the pawn has advanced.
+			if (!Bitbase::probe_kpk(strong_king, pawn, weak_king, stm)) {
+				return 0;
+			}
+
+			int v = KNOWN_WIN + pawn_value.eg() + pawn / 8;
+
+			return (strong == WHITE) ? v : -v;
+		}
+
+
+		/// <summary>
+		/// King and two or more pawns against a lone king. If a pawn can't be caught by the weak king, the endgame is won. Otherwise the pawns are
+		/// scored by how far they have advanced.
+		/// </summary>
+		int KPsK(const GameState_t* pos) {
+			SIDE strong = strong_side(pos);
+			SIDE weak = (strong == WHITE) ? BLACK : WHITE;
+
+			int strong_king = pos->king_squares[strong];
+			int weak_king = pos->king_squares[weak];
+			Bitboard pawns = pos->pieceBBS[PAWN][strong];
+
+			// Step 1. Pawns on a single rook file can't win if the weak king reaches the queening corner.
+			if ((pawns & ~BBS::FileMasks8[FILE_A]) == 0 || (pawns & ~BBS::FileMasks8[FILE_H]) == 0) {
+				int queening_sq = (strong == WHITE) ? 56 + bitScanForward(pawns) % 8 : bitScanForward(pawns) % 8;
+
+				if (distance(weak_king, queening_sq) <= 1) {
+					return 0;
+				}
+			}
+
+			// Step 2. Score the material and the advancement of the pawns, and look for a pawn outside the square of the weak king.
+			int v = countBits(pawns) * pawn_value.eg() + push_close(strong_king, weak_king) / 4;
+			bool unstoppable = false;
+
+			while (pawns) {
+				int sq = PopBit(&pawns);
+				int relative_rank = (strong == WHITE) ? sq / 8 : 7 - sq / 8;
+				int queening_sq = (strong == WHITE) ? 56 + sq % 8 : sq % 8;
+
+				v += 4 * relative_rank * relative_rank;
+
+				// A pawn on its starting rank can push two squares, so it never needs more than five moves.
+				int pawn_moves = std::min(7 - relative_rank, 5);
+				int king_moves = distance(weak_king, queening_sq) - ((pos->side_to_move == weak) ? 1 : 0);
+
+				if (pawn_moves < king_moves && !(BBS::between_squares[sq][queening_sq] & (uint64_t(1) << strong_king))
+					&& strong_king != queening_sq) {
+					unstoppable = true;
+				}
+			}
+
+			if (unstoppable) {
+				v += KNOWN_WIN;
+			}
+
+			return (strong == WHITE) ? v : -v;
+		}
+
+
+		/* --------------------------------------------------------------- */
+		/* --------------------------- Scalers --------------------------- */
+		/* --------------------------------------------------------------- */
+
+		/// <summary>
+		/// King, bishop and pawns against a lone king. If all the pawns are on a rook file and the bishop doesn't control the queening square, the
+		/// weak king can't be driven out of the corner.
+		/// </summary>
+		int KBPsK(const GameState_t* pos) {
+			SIDE strong = strong_side(pos);
+			SIDE weak = (strong == WHITE) ? BLACK : WHITE;
+
+			Bitboard pawns = pos->pieceBBS[PAWN][strong];
+
+			if ((pawns & ~BBS::FileMasks8[FILE_A]) && (pawns & ~BBS::FileMasks8[FILE_H])) {
+				return SCALE_NONE;
+			}
+
+			int queening_sq = (strong == WHITE) ? 56 + bitScanForward(pawns) % 8 : bitScanForward(pawns) % 8;
+			Bitboard queening_color = ((uint64_t(1) << queening_sq) & BBS::DARK_SQUARES) ? BBS::DARK_SQUARES : BBS::LIGHT_SQUARES;
+
+			if ((pos->pieceBBS[BISHOP][strong] & queening_color) == 0 && distance(pos->king_squares[weak], queening_sq) <= 1) {
+				return SCALE_DRAW;
+			}
+
+			return SCALE_NONE;
+		}
+
+
+		/// <summary>
+		/// Register an endgame for both colors.
+		/// </summary>
+		/// <param name="code">The endgame with white as the first side, e.g. "KNK".</param>
+		/// <param name="evaluator">The evaluation function.</param>
+		void add(const std::string& code, EndgameEvaluator evaluator) {
+			size_t second_king = code.find('K', 1);
+
+			endgames[material_key(code)] = evaluator;
+			endgames[material_key(code.substr(second_king) + code.substr(0, second_king))] = evaluator;
+		}
+	}
+
+
+	EndgameEvaluator probe(const GameState_t* pos) {
+		// Step 1. Look for the exact material configuration.
+		auto it = endgames.find(pos->materialKey);
+
+		if (it != endgames.end()) {
+			return it->second;
+		}
+
+		// Step 2. Look for a lone king against either enough material to mate or only pawns.
+		for (SIDE weak : { WHITE, BLACK }) {
+			SIDE strong = (weak == WHITE) ? BLACK : WHITE;
+
+			if (pos->all_pieces[weak] != pos->pieceBBS[KING][weak]) {
+				continue;
+			}
+
+			if (non_pawn_material(pos, strong) >= rook_value.eg()) {
+				return &KXK;
+			}
+			if (non_pawn_material(pos, strong) == 0 && countBits(pos->pieceBBS[PAWN][strong]) >= 2) {
+				return &KPsK;
+			}
+		}
+
+		return nullptr;
+	}
+
+
+	EndgameScaler probe_scaler(const GameState_t* pos, SIDE strong_side) {
+		SIDE weak = (strong_side == WHITE) ? BLACK : WHITE;
+
+		// A single bishop and pawns against a lone king.
+		if (pos->all_pieces[weak] == pos->pieceBBS[KING][weak] && countBits(pos->pieceBBS[BISHOP][strong_side]) == 1
+			&& pos->pieceBBS[PAWN][strong_side] && non_pawn_material(pos, strong_side) == bishop_value.eg()) {
+			return &KBPsK;
+		}
+
+		return nullptr;
+	}
+
+
+	uint64_t material_key(const std::string& code) {
+		const std::string pieces = "PNBRQK";
+
+		uint64_t key = 0;
+		int count[2][6] = { {0} };
+
+		// Step 1. The pieces after the first king are white's and the pieces after the second king are black's.
+		SIDE side = BLACK;
+
+		for (size_t i = 0; i < code.size(); i++) {
+			int pce = int(pieces.find(code[i]));
+
+			assert(pce >= PAWN && pce <= KING);
+
+			if (pce == KING) {
+				side = (i == 0) ? WHITE : BLACK;
+			}
+
+			// Step 2. Add the key for the n'th piece of this type, just like GameState_t::generate_material_key.
+			key ^= BBS::Zobrist::piece_keys[side][pce][count[side][pce]++];
+		}
+
+		return key;
+	}
+
+
+	void INIT() {
+		endgames.clear();
+
+		// Insufficient material. KBKB with same-colored bishops is also a draw, but that isn't decided by the material alone.
+		add("KK", &material_draw);
+		add("KNK", &material_draw);
+		add("KBK", &material_draw);
+		add("KNNK", &material_draw);
+
+		// Endgames that are won with correct play.
+		add("KQK", &KXK);
+		add("KRK", &KXK);
+		add("KBNK", &KBNK);
+		add("KPK", &KPK);
+	}
+}
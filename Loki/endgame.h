@@ -0,0 +1,54 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef ENDGAME_H
+#define ENDGAME_H
+#include "position.h"
+#include "evaltable.h"
+
+#include <string>
+
+
+/*
+
+Specialized evaluation functions for endgames where the general evaluation is known to be wrong. They are looked up by material key when a
+material hash table entry is computed, so they cost nothing for the positions they don't apply to. Endgames that are defined by the material of
+one side only, like a lone king against enough material to mate, are recognized after the lookup.
+
+Scaling functions work the same way, but only adjust the scale factor of the general evaluation.
+
+*/
+namespace Endgame {
+
+	// The score of an endgame that is won. It is far above any normal evaluation, but below the tablebase and mate scores.
+	constexpr int KNOWN_WIN = 10000;
+
+	// Returns the evaluation function for the material configuration of the position, or a null pointer if it isn't a known endgame.
+	EndgameEvaluator probe(const GameState_t* pos);
+
+	// Returns the scaling function for strong_side in the material configuration of the position, or a null pointer if there is none.
+	EndgameScaler probe_scaler(const GameState_t* pos, SIDE strong_side);
+
+	// Returns the material key of an endgame code like "KRKN", where the first king and its pieces are white's and the second are black's.
+	uint64_t material_key(const std::string& code);
+
+	// Registers all known endgames. Must be called after the zobrist keys have been initialized.
+	void INIT();
+}
+
+
+#endif
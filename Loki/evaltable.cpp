@@ -65,4 +65,36 @@ const EvalEntry_t* EvaluationTable::probe(uint64_t key, bool& hit) {
 	// Step 2. Otherwise, return a null pointer.
 	hit = false;
 	return nullptr;
+}
+
+
+
+/// <summary>
+/// Default constructor for the material table. It allocates memory for the entries.
+/// </summary>
+MaterialTable::MaterialTable() {
+	num_slots = MATERIAL_TABLE_SIZE / sizeof(MaterialEntry_t);
+	entries = new MaterialEntry_t[num_slots];
+}
+
+/// <summary>
+/// Destructor. Frees the memory allocated during construction.
+/// </summary>
+MaterialTable::~MaterialTable() {
+	if (entries != nullptr) { delete[] entries; }
+}
+
+
+/// <summary>
+/// Probe the table for a material configuration.
+/// </summary>
+/// <param name="key">The position's material key.</param>
+/// <param name="hit">A reference to a flag signalling if the got a hit.</param>
+/// <returns>The entry for the key. In case of a miss, it is the entry that should be overwritten.</returns>
+MaterialEntry_t* MaterialTable::probe(uint64_t key, bool& hit) {
+	MaterialEntry_t* entry = &entries[key & (num_slots - 1)];
+
+	hit = (entry->key == key);
+
+	return entry;
 }
\ No newline at end of file
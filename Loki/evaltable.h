@@ -18,12 +18,42 @@
 #ifndef EVALTABLE_H
 #define EVALTABLE_H
 #include <cstdint>
+#include <cstddef>
 
 /// <summary>
 /// The default size of the evaluation hash table in bytes. It is 128KB.
 /// </summary>
 constexpr size_t EVAL_TABLE_SIZE = 128 << 10;
 
+/// <summary>
+/// The default size of the material hash table in bytes. It is 256KB.
+/// </summary>
+constexpr size_t MATERIAL_TABLE_SIZE = 256 << 10;
+
+/// <summary>
+/// Scale factors are applied to the endgame score of the stronger side as scale / SCALE_NORMAL.
+/// </summary>
+constexpr int SCALE_NORMAL = 64;
+constexpr int SCALE_DRAW = 0;
+
+/// <summary>
+/// Returned by a scaling function if it doesn't apply to the position, so the scale factor of the material hash table entry is used.
+/// </summary>
+constexpr int SCALE_NONE = 255;
+
+
+class GameState_t;
+
+/// <summary>
+/// An evaluation function for a specific material configuration. It returns the score from white's point of view.
+/// </summary>
+typedef int (*EndgameEvaluator)(const GameState_t* pos);
+
+/// <summary>
+/// A scaling function for a specific material configuration. It returns the scale factor of the stronger side, or SCALE_NONE.
+/// </summary>
+typedef int (*EndgameScaler)(const GameState_t* pos);
+
 
 
 /// <summary>
@@ -43,6 +73,51 @@ private:
 
 
 
+/// <summary>
+/// MaterialEntry_t holds all evaluation terms that only depend on the material on the board. They are computed once for every material configuration
+/// and then re-used from the material hash table.
+/// </summary>
+class MaterialEntry_t {
+public:
+	uint64_t key = 0;
+
+	// The material values and imbalances from white's point of view.
+	int mg = 0;
+	int eg = 0;
+
+	// The game phase between 0 (only pawns and kings) and 24 (all pieces on the board).
+	uint8_t phase = 0;
+
+	// Indexed by scale[side]. Used when side is ahead in the endgame score.
+	uint8_t scale[2] = { SCALE_NORMAL, SCALE_NORMAL };
+
+	// If the material configuration is a known endgame, this is its specialized evaluation function. Otherwise it is a null pointer.
+	EndgameEvaluator endgame = nullptr;
+
+	// Indexed by scaler[side]. If it isn't a null pointer, it replaces scale[side] for the positions where it applies.
+	EndgameScaler scaler[2] = { nullptr, nullptr };
+};
+
+
+
+/// <summary>
+/// MaterialTable is the class responsible for managing the material hash table. Unlike the evaluation hash table, it always returns an entry and
+/// it is up to the caller to fill it in if the keys don't match.
+/// </summary>
+class MaterialTable {
+public:
+	MaterialTable();
+	~MaterialTable();
+
+	MaterialEntry_t* probe(uint64_t key, bool& hit);
+
+private:
+	size_t num_slots = 0;
+	MaterialEntry_t* entries;
+};
+
+
+
 /// <summary>
 /// EvaluationTable is the class responsible for managing the evaluation hash table.
 /// </summary>
@@ -24,26 +24,26 @@ Initialization of constants. (PSQT are handled in psqt.cpp)
 #define S(m, e) Score(m, e) // Inspired by Stockfish/Ethereal. Just a nice and clean way of initializing the constants.
 
 // Material values.
-const Score pawn_value(98, 108);
-const Score knight_value(405, 393);
-const Score bishop_value(415, 381);
-const Score rook_value(526, 625);
-const Score queen_value(1120, 1306);
+TUNABLE_DEF Score pawn_value(98, 108);
+TUNABLE_DEF Score knight_value(405, 393);
+TUNABLE_DEF Score bishop_value(415, 381);
+TUNABLE_DEF Score rook_value(526, 625);
+TUNABLE_DEF Score queen_value(1120, 1306);
 
 
 // Material imbalances.
-const Score bishop_pair(18, 55);
-const Score knight_pawn_penaly(1, 1);
-const Score rook_pawn_bonus(3, 1);
+TUNABLE_DEF Score bishop_pair(18, 55);
+TUNABLE_DEF Score knight_pawn_penaly(1, 1);
+TUNABLE_DEF Score rook_pawn_bonus(3, 1);
 
 
 // Pawn evaluation values.
-const Score doubled_penalty(5, 22);
-const Score doubled_isolated_penalty(16, 15);
-const Score isolated_penalty(11, 6);
-const Score backwards_penalty(7, 1);
+TUNABLE_DEF Score doubled_penalty(5, 22);
+TUNABLE_DEF Score doubled_isolated_penalty(16, 15);
+TUNABLE_DEF Score isolated_penalty(11, 6);
+TUNABLE_DEF Score backwards_penalty(7, 1);
 
-const Score passedPawnTable[64] = {
+TUNABLE_DEF Score passedPawnTable[64] = {
 		S(34, 26)	, S(52, 11)	,	S(20, 5)	,	S(13, 50)	,	S(3, 27)	,	S(0, 66)	,	S(4, 66)	,	S(16, 4)	,
 		S(0, 0)		, S(2, 0)	,	S(4, 1)		,	S(12, 19)	,	S(0, 23)	,	S(17, 1)	,	S(1, 1)		,	S(1, 2)		,
 		S(0, 1)		, S(0, 6)	,	S(1, 0)		,	S(2, 3)		,	S(1, 3)		,	S(9, 0)		,	S(16, 2)	,	S(9, 0)		,
@@ -56,7 +56,7 @@ const Score passedPawnTable[64] = {
 
 
 // Space evaluation values
-const Score space_bonus[32] = {
+TUNABLE_DEF Score space_bonus[32] = {
 		S(-40, 0)	,	S(-21, 0)	,	S(66, 0)	,	S(41, 0)	,	S(36, 0)	,	S(35, 0)	,	S(23, 0)	, S(18, 0),
 		S(5, 0)		,	S(2, 0)		,	S(-1, 0)	,	S(0, 0)		,	S(1, 0)		,	S(12, 0)	,	S(13, 0)	, S(20, 0),
 		S(31, 0)	,	S(40, 0)	,	S(39, 0)	,	S(74, 0)	,	S(69, 0)	,	S(68, 0)	,	S(99, 0)	, S(144, 0),
@@ -65,18 +65,18 @@ const Score space_bonus[32] = {
 
 
 // Mobility evaluation values
-const Score knightMobility[9] = { S(-69, -76), S(-36, -68), S(-17, -30), S(-2, -14), S(4, -6), S(11, 8), // Knight
+TUNABLE_DEF Score knightMobility[9] = { S(-69, -76), S(-36, -68), S(-17, -30), S(-2, -14), S(4, -6), S(11, 8), // Knight
 		S(20, 9), S(33, 12), S(42, 5)
 };
-const Score bishopMobility[14] = { S(-46, -54), S(-21, -30), S(11, -13), S(28, 13), S(36, 28), S(50, 37),
+TUNABLE_DEF Score bishopMobility[14] = { S(-46, -54), S(-21, -30), S(11, -13), S(28, 13), S(36, 28), S(50, 37),
 	S(54, 51), S(59, 51), S(59, 62), S(66, 59), S(83, 57), S(102, 56),
 	S(82, 69), S(91, 73)
 };
-const Score rookMobility[15] = { S(-60,-82), S(-24,-15), S(0, 17) ,S(3, 43), S(4, 72), S(14,100), // Rook. TODO: Re-tune this
+TUNABLE_DEF Score rookMobility[15] = { S(-60,-82), S(-24,-15), S(0, 17) ,S(3, 43), S(4, 72), S(14,100), // Rook. TODO: Re-tune this
   S(20,102), S(30,122), S(41,133), S(41 ,139), S(41,153), S(45,160),
   S(57,165), S(58,170), S(67,175)
 };
-const Score queenMobility[28] = {
+TUNABLE_DEF Score queenMobility[28] = {
 	S(-38, -66), S(-25, -14), S(-1, -21), S(21, 6), S(31, 34), S(30, 39), S(36, 46), S(40, 46), S(46, 61), // Queen
 	S(45, 70), S(52, 80), S(53, 92), S(54, 107), S(61, 107), S(69, 109),
 	S(71, 118), S(66, 131), S(69, 137), S(67, 144), S(69, 156), S(97, 138),
@@ -92,32 +92,32 @@ const std::array<const Score*, 4> mobility_bonus = {
 
 
 // Piece evaluation values.
-const Score outpost(31, 13);
-const Score reachable_outpost(18, -2);
-const Score knight_on_kingring(8, -13);
-const Score defended_knight(0, 10);
-const Score bishop_on_kingring(11, 4);
-const Score bishop_on_queen(32, 24);
-const Score bad_bishop_coeff(0, 5);
-const Score doubled_rooks(31, 9);
-const Score rook_on_queen(6, 49);
-const Score rook_on_kingring(34, -20);
-const Score rook_open_file(43, -11);
-const Score rook_semi_open_file(11, 19);
-const Score rook_behind_passer(0, 10);
-const Score queen_on_kingring(3, 19);
-const Score threatened_queen(52, 70);
+TUNABLE_DEF Score outpost(31, 13);
+TUNABLE_DEF Score reachable_outpost(18, -2);
+TUNABLE_DEF Score knight_on_kingring(8, -13);
+TUNABLE_DEF Score defended_knight(0, 10);
+TUNABLE_DEF Score bishop_on_kingring(11, 4);
+TUNABLE_DEF Score bishop_on_queen(32, 24);
+TUNABLE_DEF Score bad_bishop_coeff(0, 5);
+TUNABLE_DEF Score doubled_rooks(31, 9);
+TUNABLE_DEF Score rook_on_queen(6, 49);
+TUNABLE_DEF Score rook_on_kingring(34, -20);
+TUNABLE_DEF Score rook_open_file(43, -11);
+TUNABLE_DEF Score rook_semi_open_file(11, 19);
+TUNABLE_DEF Score rook_behind_passer(0, 10);
+TUNABLE_DEF Score queen_on_kingring(3, 19);
+TUNABLE_DEF Score threatened_queen(52, 70);
 
 // Penalties for early queen development in the middlegame.
-const Score queen_development_penalty[5] = { S(0, 0), S(0, 0), S(0, 0), S(3, 0), S(12, 0) };
+TUNABLE_DEF Score queen_development_penalty[5] = { S(0, 0), S(0, 0), S(0, 0), S(3, 0), S(12, 0) };
 
 
 // King pawn shield evaluation
-const Score minimum_kp_distance[15] = { S(15, 3), S(3, 7), S(-7, 3), S(-15, -3), S(-19, -11), S(-7, -19), S(-3, -17),
+TUNABLE_DEF Score minimum_kp_distance[15] = { S(15, 3), S(3, 7), S(-7, 3), S(-15, -3), S(-19, -11), S(-7, -19), S(-3, -17),
 								S(-3, -3), S(5, 3), S(-7, 3), S(-1, -3), S(-1, -5), S(23, 1), S(-1, 7), S(15, 13) }; // Indexed by manhattan distance - 1
 
 // Indexed such that if the king is on the king-side it is [0][sq] and if it's on the queen-side it's [1][sq]
-const Score king_shelter[2][64] = {
+TUNABLE_DEF Score king_shelter[2][64] = {
 	{
 		S(10, 4)	,	S(16, -14)	,	S(-2, 6)	,	S(22, 22)	,	S(-4, -6)	,	S(-10, 6)	,	S(2, 8)		,	S(-14, -2)	,
 		S(-8, 10)	,	S(4, 0)		,	S(8, -8)	,	S(16, -2)	,	S(8, 0)		,	S(12, -6)	,	S(14, -16)	,	S(0, -10)	,
@@ -143,14 +143,14 @@ const Score king_shelter[2][64] = {
 
 
 // Both of the below arrays are indexed by file number.
-const Score open_file[8] = { S(8, -28), S(-10, -16), S(0, -16), S(-6, -10), S(-12, -6), S(0, -14), S(-14, -10), S(-12, -12) };
-const Score semi_open_file[8] = { S(-1, 9), S(3, 15), S(-7, 13), S(-11, 11), S(-5, 1), S(-11, 11), S(-11, 21), S(-5, 21) };
+TUNABLE_DEF Score open_file[8] = { S(8, -28), S(-10, -16), S(0, -16), S(-6, -10), S(-12, -6), S(0, -14), S(-14, -10), S(-12, -12) };
+TUNABLE_DEF Score semi_open_file[8] = { S(-1, 9), S(3, 15), S(-7, 13), S(-11, 11), S(-5, 1), S(-11, 11), S(-11, 21), S(-5, 21) };
 
 
 
 
 // King safety evaluation
-const Score weighted_attacks[7] = { S(0, 0), S(53, 51), S(84, 70), S(97, 87), S(87, 97), S(90, 102), S(96, 100) }; // Indexed by number of attackers.
+TUNABLE_DEF Score weighted_attacks[7] = { S(0, 0), S(53, 51), S(84, 70), S(97, 87), S(87, 97), S(90, 102), S(96, 100) }; // Indexed by number of attackers.
 
 
 
@@ -159,8 +159,8 @@ const Score weighted_attacks[7] = { S(0, 0), S(53, 51), S(84, 70), S(97, 87), S(
 /*
 Other
 */
-const int max_material[2] = { queen_value.mg + 2 * rook_value.mg + 2 * bishop_value.mg + 2 * knight_value.mg,
-							queen_value.eg + 2 * rook_value.eg + 2 * bishop_value.eg + 2 * knight_value.eg };
+TUNABLE_DEF int max_material[2] = { queen_value.mg() + 2 * rook_value.mg() + 2 * bishop_value.mg() + 2 * knight_value.mg(),
+							queen_value.eg() + 2 * rook_value.eg() + 2 * bishop_value.eg() + 2 * knight_value.eg() };
 
 
 
@@ -173,48 +173,101 @@ namespace Eval {
 	/// <returns>A numerical score for the position, relative to the side to move.</returns>
 	template<EvalType T>
 	int Evaluate<T>::score(const GameState_t* _pos, bool use_table) {
+		return evaluate<false>(_pos, -INF, INF, use_table);
+	}
+
+
+	/// <summary>
+	/// Evaluate a position with a side-relative score, stopping early if it is far outside the search window.
+	/// </summary>
+	/// <param name="_pos">The position object that is to be evaluated.</param>
+	/// <param name="alpha">The lower bound of the search window, relative to the side to move.</param>
+	/// <param name="beta">The upper bound of the search window, relative to the side to move.</param>
+	/// <returns>A numerical score for the position, relative to the side to move. If it is outside the window by more than lazy_margin, it is
+	/// only an approximation.</returns>
+	template<EvalType T>
+	int Evaluate<T>::score(const GameState_t* _pos, int alpha, int beta, bool use_table) {
+		lazy_calls++;
+
+		return evaluate<true>(_pos, alpha, beta, use_table);
+	}
+
+
+	/// <summary>
+	/// The evaluation function itself.
+	/// </summary>
+	template<EvalType T> template<bool Lazy>
+	TARGET_CLONES int Evaluate<T>::evaluate(const GameState_t* _pos, int alpha, int beta, bool use_table) {
 		// Step 1. Clear the object and store the position object.
 		clear();
 		pos = _pos;
 		int v = 0;
 
-		// Step 2. Probe the evaluation hash table for an entry.
+		// Step 2. Look up the material configuration. Known endgames have their own evaluation functions.
+		const MaterialEntry_t* material_entry = probe_material(use_table);
+
+		if (material_entry->endgame != nullptr) {
+			v = material_entry->endgame(pos);
+
+			return (pos->side_to_move == WHITE) ? v : -v;
+		}
+
+		// Step 3. Probe the evaluation hash table for an entry.
 		bool hit = false;
 		const EvalEntry_t* entry = eval_table.probe(pos->posKey, hit);
 
+#if defined(SEARCH_STATS)
+		table_probes += use_table;
+		table_hits += (use_table && hit);
+#endif
+
 		if (use_table && hit) {
 			v = entry->get_score();
 		}
+		else if (NNUE::is_loaded() && std::abs(material_entry->mg) < nnue_threshold) {
+			// Step 3A. Evaluate balanced positions with the network. Its score is stored from white's point of view like the classical one.
+			v = NNUE::evaluate(pos);
+			v *= (pos->side_to_move == WHITE) ? 1 : -1;
+
+			eval_table.store(pos->posKey, v);
+		}
 		else {
-			// Step 3. Evaluate material
-			material<WHITE>();
-			material<BLACK>();
+			// Step 4. Add material and imbalances from the material hash table entry.
+			total += Score(material_entry->mg, material_entry->eg);
 
-			// Step 4. Evaluate piece placements
+			// Step 5. Evaluate piece placements
 			psqt<WHITE>(); psqt<BLACK>();
 
-			// Step 5. Material imbalances
-			imbalance<WHITE>(); imbalance<BLACK>();
-
 			// Step 6. Pawn structure evaluation
 			pawns<WHITE>(); pawns<BLACK>();
 
-			// Step 7. Space evaluation
+			// Step 6A. If the evaluation so far is far enough outside the window, the remaining terms are not going to bring it back. The
+			//	approximation is not stored in the hash table.
+			if (Lazy) {
+				v = interpolate(material_entry) + ((pos->side_to_move == WHITE) ? tempo : -tempo);
+				v *= (pos->side_to_move == WHITE) ? 1 : -1;
+
+				if (v - lazy_margin >= beta || v + lazy_margin <= alpha) {
+					lazy_exits++;
+					return v;
+				}
+			}
+
+			// Step 7. Generate the attack maps for all pieces. These are used by the remaining terms.
+			attack_maps<WHITE>(); attack_maps<BLACK>();
+
+			// Step 7A. Space evaluation
 			space<WHITE>(); space<BLACK>();
 
 			// Step 8. Mobility
-			mobility<WHITE, KNIGHT>(); mobility<BLACK, KNIGHT>();
-			mobility<WHITE, BISHOP>(); mobility<BLACK, BISHOP>();
-			mobility<WHITE, ROOK>(); mobility<BLACK, ROOK>();
-			mobility<WHITE, QUEEN>(); mobility<BLACK, QUEEN>();
+			mobility<WHITE>(); mobility<BLACK>();
 
 			// Step 9. King safety evaluation.
 			king_safety<WHITE>(); king_safety<BLACK>();
 
-			// Step 10. Compute the phase and interpolate the middle game and endgame scores.
-			int phase = game_phase();
-
-			v = (phase * mg_score + (24 - phase) * eg_score) / 24;
+			// Step 10. Scale down the endgame score if the stronger side will have a hard time winning, and interpolate the middle game and
+			//	endgame scores by the phase.
+			v = interpolate(material_entry);
 
 			// Step 11. Store the evaluation in the hash table (white's POV)
 			eval_table.store(pos->posKey, v);
@@ -228,6 +281,33 @@ namespace Eval {
 	}
 
 
+	/// <summary>
+	/// Interpolate between the middlegame and endgame scores by the game phase. The endgame score is scaled by the scale factor of the side that is
+	/// ahead in it.
+	/// </summary>
+	/// <param name="material_entry">The material hash table entry with the phase and scale factors.</param>
+	/// <returns>The score from white's point of view.</returns>
+	template<EvalType T>
+	int Evaluate<T>::interpolate(const MaterialEntry_t* material_entry) const {
+		int phase = material_entry->phase;
+		int mg = total.mg();
+		int eg = total.eg();
+
+		// WHITE == 1, so the scale factor is picked without a branch. A scaling function for the material configuration overrides it.
+		int strong = eg > 0;
+		int scale = material_entry->scale[strong];
+
+		if (material_entry->scaler[strong] != nullptr) {
+			int s = material_entry->scaler[strong](pos);
+			scale = (s != SCALE_NONE) ? s : scale;
+		}
+
+		eg = eg * scale / SCALE_NORMAL;
+
+		return (phase * mg + (24 - phase) * eg) / 24;
+	}
+
+
 	/// <summary>
 	/// Calculate the game phase based on the amount of material left on the board.
 	/// </summary>
@@ -247,6 +327,76 @@ namespace Eval {
 	}
 
 
+	/// <summary>
+	/// Find the material hash table entry for the position, and compute it if it isn't there.
+	/// </summary>
+	/// <param name="use_table">If false, the entry is always computed from scratch and the table is left untouched.</param>
+	/// <returns>The material entry for the position.</returns>
+	template<EvalType T>
+	const MaterialEntry_t* Evaluate<T>::probe_material(bool use_table) {
+		bool hit = false;
+		MaterialEntry_t* entry = (use_table) ? material_table.probe(pos->materialKey, hit) : &material_scratch;
+
+		if (hit) {
+			return entry;
+		}
+
+		// Step 1. Compute the material values and imbalances. These are the only terms that have been added to the scores yet, so they can be
+		//	read off and reset afterwards.
+		material<WHITE>(); material<BLACK>();
+		imbalance<WHITE>(); imbalance<BLACK>();
+
+		entry->mg = total.mg();
+		entry->eg = total.eg();
+		total = Score();
+
+		// Step 2. Compute the phase and the scale factors.
+		entry->phase = uint8_t(game_phase());
+		entry->scale[WHITE] = uint8_t(scale_factor<WHITE>());
+		entry->scale[BLACK] = uint8_t(scale_factor<BLACK>());
+
+		// Step 3. Look for specialized evaluation and scaling functions.
+		entry->endgame = Endgame::probe(pos);
+		entry->scaler[WHITE] = Endgame::probe_scaler(pos, WHITE);
+		entry->scaler[BLACK] = Endgame::probe_scaler(pos, BLACK);
+		entry->key = pos->materialKey;
+
+		return entry;
+	}
+
+
+	/// <summary>
+	/// Compute the endgame scale factor for side S. It is used when S is ahead in the endgame score, and is lowered when S has few or no pawns
+	/// and only a small advantage in piece material, since such endgames are often drawn.
+	/// </summary>
+	/// <returns>A scale factor between SCALE_DRAW and SCALE_NORMAL.</returns>
+	template<EvalType T> template<SIDE S>
+	int Evaluate<T>::scale_factor() {
+		constexpr SIDE Them = (S == WHITE) ? BLACK : WHITE;
+
+		auto non_pawn_material = [this](SIDE side) {
+			return countBits(pos->pieceBBS[KNIGHT][side]) * knight_value.mg() + countBits(pos->pieceBBS[BISHOP][side]) * bishop_value.mg()
+				+ countBits(pos->pieceBBS[ROOK][side]) * rook_value.mg() + countBits(pos->pieceBBS[QUEEN][side]) * queen_value.mg();
+		};
+
+		int npm_us = non_pawn_material(S);
+		int npm_them = non_pawn_material(Them);
+		int pawns = countBits(pos->pieceBBS[PAWN][S]);
+
+		// Step 1. Without pawns, S needs at least a rook to win, and more than a minor piece of advantage.
+		if (pawns == 0 && npm_us - npm_them <= bishop_value.mg()) {
+			return (npm_us < rook_value.mg()) ? SCALE_DRAW : ((npm_them <= bishop_value.mg()) ? 4 : 14);
+		}
+
+		// Step 2. With a single pawn, the weaker side can often sacrifice a piece for it.
+		if (pawns == 1 && npm_us - npm_them <= bishop_value.mg()) {
+			return 48;
+		}
+
+		return SCALE_NORMAL;
+	}
+
+
 	/// <summary>
 	/// Clear the Evaluate object.
 	/// </summary>
@@ -256,7 +406,7 @@ namespace Eval {
 		Data = ZeroData;
 
 		// Clear the scores and the position pointer.
-		mg_score = eg_score = 0;
+		total = Score();
 		pos = nullptr;
 	}
 
@@ -270,9 +420,6 @@ namespace Eval {
 	/// </summary>
 	template<EvalType T> template<SIDE S>
 	void Evaluate<T>::material() {
-		int mg = 0;
-		int eg = 0;
-
 		// Step 1. Get the number of each material type
 		int pawnCnt = countBits(pos->pieceBBS[PAWN][S]);
 		int knightCnt = countBits(pos->pieceBBS[KNIGHT][S]);
@@ -280,24 +427,11 @@ namespace Eval {
 		int rookCnt = countBits(pos->pieceBBS[ROOK][S]);
 		int queenCnt = countBits(pos->pieceBBS[QUEEN][S]);
 
-		// Step 2. Add middlegame values
-		mg += pawnCnt * pawn_value.mg;
-		mg += knightCnt * knight_value.mg;
-		mg += bishopCnt * bishop_value.mg;
-		mg += rookCnt * rook_value.mg;
-		mg += queenCnt * queen_value.mg;
-
-		// Step 3. Add endgame values
-		eg += pawnCnt * pawn_value.eg;
-		eg += knightCnt * knight_value.eg;
-		eg += bishopCnt * bishop_value.eg;
-		eg += rookCnt * rook_value.eg;
-		eg += queenCnt * queen_value.eg;
-
+		// Step 2. Add the middlegame and endgame values together.
+		Score s = pawn_value * pawnCnt + knight_value * knightCnt + bishop_value * bishopCnt + rook_value * rookCnt + queen_value * queenCnt;
 
-		// Step 4. Add the values to eval and make it side-dependent
-		mg_score += (S == WHITE) ? mg : -mg;
-		eg_score += (S == WHITE) ? eg : -eg;
+		// Step 3. Add the values to eval and make it side-dependent
+		apply<S>(s);
 	}
 
 
@@ -306,24 +440,19 @@ namespace Eval {
 		const Score* tables[6] = { &PSQT::PawnTable[0], &PSQT::KnightTable[0], &PSQT::BishopTable[0], &PSQT::RookTable[0], &PSQT::QueenTable[0], &PSQT::KingTable[0] };
 
 		/// <summary>
-		/// 
+		/// Look up the piece-square table value of a piece.
 		/// </summary>
-		/// <param name="pce"></param>
-		/// <param name="sq"></param>
-		/// <returns></returns>
-		template<SIDE side, GamePhase p>
-		int addPsqtVal(int pce, int sq) {
-			int v = 0;
-
-			assert(p == MG || p == EG);
+		/// <param name="pce">The piece type.</param>
+		/// <param name="sq">The square of the piece.</param>
+		/// <returns>The middlegame and endgame values of the piece on the square.</returns>
+		template<SIDE side>
+		Score addPsqtVal(int pce, int sq) {
 			assert(side == WHITE || side == BLACK);
 			assert(sq >= 0 && sq <= 63);
 			assert(pce >= PAWN && pce < NO_TYPE);
 			assert(PSQT::Mirror64[PSQT::Mirror64[sq]] == sq);
 
-			v += (p == MG) ? tables[pce][(side == WHITE) ? sq : PSQT::Mirror64[sq]].mg : tables[pce][(side == WHITE) ? sq : PSQT::Mirror64[sq]].eg;
-
-			return v;
+			return tables[pce][(side == WHITE) ? sq : PSQT::Mirror64[sq]];
 		}
 	} // namespace
 
@@ -334,8 +463,7 @@ namespace Eval {
 	/// </summary>
 	template<EvalType T> template<SIDE S>
 	void Evaluate<T>::psqt() {
-		int mg = 0;
-		int eg = 0;
+		Score s;
 
 		Bitboard pceBoard = 0;
 		int sq = NO_SQ;
@@ -346,14 +474,12 @@ namespace Eval {
 			while (pceBoard) {
 				sq = PopBit(&pceBoard);
 
-				mg += addPsqtVal<S, MG>(pce, sq);
-				eg += addPsqtVal<S, EG>(pce, sq);
+				s += addPsqtVal<S>(pce, sq);
 			}
 		}
 
 		// Add the side-relative scores.
-		mg_score += (S == WHITE) ? mg : -mg;
-		eg_score += (S == WHITE) ? eg : -eg;
+		apply<S>(s);
 	}
 
 
@@ -363,13 +489,11 @@ namespace Eval {
 	/// </summary>
 	template<EvalType T> template<SIDE S>
 	void Evaluate<T>::imbalance() {
-		int mg = 0;
-		int eg = 0;
+		Score s;
 
 		// Step 1. Bishop pair bonus. FIXME: Should we also have the square-colors of the bishops as a requirement?
 		if (countBits(pos->pieceBBS[BISHOP][S]) >= 2) {
-			mg += bishop_pair.mg;
-			eg += bishop_pair.eg;
+			s += bishop_pair;
 		}
 
 		int pawns_removed = 8 - countBits(pos->pieceBBS[PAWN][S]);
@@ -377,18 +501,15 @@ namespace Eval {
 		// Step 2. Give rooks bonuses as pawns disappear.
 		int rook_count = countBits(pos->pieceBBS[ROOK][S]);
 
-		mg += rook_count * pawns_removed * rook_pawn_bonus.mg;
-		eg += rook_count * pawns_removed * rook_pawn_bonus.eg;
+		s += rook_pawn_bonus * (rook_count * pawns_removed);
 
 		// Step 3. Give the knights penalties as pawns dissapear.
 		int knight_count = countBits(pos->pieceBBS[KNIGHT][S]);
 
-		mg -= knight_count * pawns_removed * knight_pawn_penaly.mg;
-		eg -= knight_count * pawns_removed * knight_pawn_penaly.eg;
+		s -= knight_pawn_penaly * (knight_count * pawns_removed);
 
 		// Step 4. Store the side-relative scores.
-		mg_score += (S == WHITE) ? mg : -mg;
-		eg_score += (S == WHITE) ? eg : -eg;
+		apply<S>(s);
 	}
 
 
@@ -398,11 +519,10 @@ namespace Eval {
 	/// </summary>
 	template<EvalType T> template<SIDE S>
 	void Evaluate<T>::pawns() {
-		int mg = 0;
-		int eg = 0;
+		Score s;
 
 		// Declare some side-relative constants
-		constexpr Bitboard* passedBitmask = (S == WHITE) ? BBS::EvalBitMasks::passed_pawn_masks[WHITE] : BBS::EvalBitMasks::passed_pawn_masks[BLACK];
+		constexpr const Bitboard* passedBitmask = BBS::EvalBitMasks::passed_pawn_masks[S].data();
 
 		constexpr int relative_ranks[8] = { (S == WHITE) ? RANK_1 : RANK_8, (S == WHITE) ? RANK_2 : RANK_7,
 			(S == WHITE) ? RANK_3 : RANK_6, (S == WHITE) ? RANK_4 : RANK_5, (S == WHITE) ? RANK_5 : RANK_4,
@@ -427,8 +547,7 @@ namespace Eval {
 			doubled_count += (countBits(BBS::FileMasks8[f] & pos->pieceBBS[PAWN][S]) > 1) ? 1 : 0;
 		}
 
-		mg -= doubled_count * doubled_penalty.mg;
-		eg -= doubled_count * doubled_penalty.eg;
+		s -= doubled_penalty * doubled_count;
 
 
 		// Now evaluate each individual pawn
@@ -441,8 +560,7 @@ namespace Eval {
 
 			// Passed pawn bonus
 			if ((passedBitmask[sq] & pos->pieceBBS[PAWN][Them]) == 0) { // No enemy pawns in front
-				mg += passedPawnTable[relative_sq].mg;
-				eg += passedPawnTable[relative_sq].eg;
+				s += passedPawnTable[relative_sq];
 
 				// Save the passed pawn's position such that we can give a bonus if it is defended by pieces later.
 				Data.passed_pawns[S] |= (uint64_t(1) << sq);
@@ -453,25 +571,22 @@ namespace Eval {
 			bool isolated = ((BBS::EvalBitMasks::isolated_bitmasks[f] & pos->pieceBBS[PAWN][S]) == 0) ? true : false;
 
 			if (doubled && isolated) {
-				mg -= doubled_isolated_penalty.mg;
-				eg -= doubled_isolated_penalty.eg;
+				s -= doubled_isolated_penalty;
 			}
 			else if (isolated) {
-				mg -= isolated_penalty.mg;
-				eg -= isolated_penalty.eg;
+				s -= isolated_penalty;
 			}
 		}
 
 		// Populate the attacks bitboard with pawn attacks. This will be used in the evaluation of pieces.
-		Data.attacked_by_two[S] = attacked_by_all<S>() & (shift<upRight>(pos->pieceBBS[PAWN][S]) | shift<upLeft>(pos->pieceBBS[PAWN][S]));
+		Data.attacked_by_two[S] = king_ring(pos->king_squares[S]) & (shift<upRight>(pos->pieceBBS[PAWN][S]) | shift<upLeft>(pos->pieceBBS[PAWN][S]));
 		Data.attacks[S][PAWN] = (shift<upRight>(pos->pieceBBS[PAWN][S]) | shift<upLeft>(pos->pieceBBS[PAWN][S]));
 
 		// Lastly, evaluate the kings pawn shelter
 		king_pawns<S>();
 
 		// Apply the scores.
-		mg_score += (S == WHITE) ? mg : -mg;
-		eg_score += (S == WHITE) ? eg : -eg;
+		apply<S>(s);
 	}
 
 
@@ -544,8 +659,7 @@ namespace Eval {
 		}
 
 		// Lastly, add the eval scores.
-		mg_score += (S == WHITE) ? kp_eval.mg : -kp_eval.mg;
-		eg_score += (S == WHITE) ? kp_eval.eg : -kp_eval.eg;
+		apply<S>(kp_eval);
 	}
 
 
@@ -580,155 +694,100 @@ namespace Eval {
 		points += 2 * countBits(rearSpanBrd & space_zone);
 		
 		// Apply the scores based on our space points
-		mg_score += (S == WHITE) ? space_bonus[std::min(31, points)].mg : -space_bonus[std::min(31, points)].mg;
-		eg_score += (S == WHITE) ? space_bonus[std::min(31, points)].eg : -space_bonus[std::min(31, points)].eg;
+		apply<S>(space_bonus[std::min(31, points)]);
 	}
 
 
 
 	/// <summary>
-	/// Mobility evaluation. If our pieces have a lot of squares to move to, it is usually a sign that we have a good position.
+	/// Generate the attacks of all of side S's pieces in a single pass. Besides the per-piece attacks, this fills the attack maps by piece type,
+	/// the squares attacked twice and the king attack counters.
 	/// </summary>
-	template<EvalType T> template<SIDE S, piece pce>
-	void Evaluate<T>::mobility() {
-		int mg = 0;
-		int eg = 0;
-
+	template<EvalType T> template<SIDE S>
+	void Evaluate<T>::attack_maps() {
 		constexpr SIDE Them = (S == WHITE) ? BLACK : WHITE;
-		constexpr DIRECTION Down = (S == WHITE) ? SOUTH : NORTH;
 
+		Bitboard occupied = pos->all_pieces[WHITE] | pos->all_pieces[BLACK];
 		Bitboard enemy_king_ring = king_ring(pos->king_squares[Them]);
-		Bitboard enemy_outer_king_ring = outer_kingRing(pos->king_squares[Them]);
 
-		Bitboard friendly_outer_king_ring = outer_kingRing(pos->king_squares[S]);
+		// The pawn attacks have been added in pawns(), so the king is the only other attacker so far.
+		Data.all_attacks[S] = Data.attacks[S][PAWN] | king_ring(pos->king_squares[S]);
 
-		Bitboard piece_attacks = 0; // Individual piece attacks.
-
-		Bitboard pceBoard = pos->pieceBBS[pce][S];
-		int sq = 0;
+		add_piece_attacks<S, KNIGHT>(occupied, enemy_king_ring);
+		add_piece_attacks<S, BISHOP>(occupied, enemy_king_ring);
+		add_piece_attacks<S, ROOK>(occupied, enemy_king_ring);
+		add_piece_attacks<S, QUEEN>(occupied, enemy_king_ring);
+	}
 
 
-		if (pce < KNIGHT || pce > QUEEN || pceBoard == 0) {
-			return;
-		}
+	/// <summary>
+	/// Add the attacks of all of side S's pieces of type pce to the attack maps.
+	/// </summary>
+	template<EvalType T> template<SIDE S, piece pce>
+	void Evaluate<T>::add_piece_attacks(Bitboard occupied, Bitboard enemy_king_ring) {
+		constexpr SIDE Them = (S == WHITE) ? BLACK : WHITE;
 
-		// For mobility, we'll only score moves to squares not attacked by pawns, and not to pawns that are blocked.
-		Bitboard good_squares = ~(Data.attacks[Them][PAWN] | pos->pieceBBS[KING][S] |
-			(shift<Down>(pos->all_pieces[WHITE] | pos->all_pieces[BLACK]) & pos->pieceBBS[PAWN][S]));
+		Bitboard pceBoard = pos->pieceBBS[pce][S];
+		Bitboard piece_attacks = 0;
+		int sq = 0;
 
-		int attack_cnt = 0;
-		while (pceBoard != 0) {
+		while (pceBoard) {
 			sq = PopBit(&pceBoard);
 
 			if constexpr (pce == KNIGHT) {
-				// Calculate attacks and update the EvalData object.
 				piece_attacks = BBS::knight_attacks[sq];
-
-				Data.attacked_by_two[S] |= attacked_by_all<S>() & piece_attacks;
-				Data.attacks[S][pce] |= piece_attacks;
-
-
-				if ((piece_attacks & enemy_king_ring) != 0) { // If the piece attacks the enemy king area
-					Data.king_attackers[Them]++; // Increment attackers
-
-					// Add the attacker's corresponding value.
-					//Data.king_attack_value[Them] += ks_attack_value[pce];
-					Data.king_attack_value[Them] += ks_attack_value[pce] * countBits(piece_attacks & enemy_king_ring);
-				}
-
-				piece_attacks &= good_squares; // Only score mobility to good squares.
-
-				attack_cnt = countBits(piece_attacks);
-				assert(attack_cnt < 9);
-
-				mg += mobility_bonus[pce - 1][attack_cnt].mg;
-				eg += mobility_bonus[pce - 1][attack_cnt].eg;
 			}
-
-			else if constexpr (pce == BISHOP) {
-				// Calculate attacks and update the EvalData object.
-				piece_attacks = Magics::attacks_bb<BISHOP>(sq, (pos->all_pieces[WHITE] | pos->all_pieces[BLACK]));
-				
-				Data.attacked_by_two[S] |= attacked_by_all<S>() & piece_attacks;
-				Data.attacks[S][pce] |= piece_attacks;
-
-				if ((piece_attacks & enemy_king_ring) != 0) { // If the piece attacks the enemy king area
-					Data.king_attackers[Them]++; // Increment attackers
-
-					// Add the attacker's corresponding value.
-					//Data.king_attack_value[Them] += ks_attack_value[pce];
-					Data.king_attack_value[Them] += ks_attack_value[pce] * countBits(piece_attacks & enemy_king_ring);
-				}
-
-
-
-				piece_attacks &= good_squares; // Only score mobility to good squares.
-
-				attack_cnt = countBits(piece_attacks);
-				assert(attack_cnt < 15);
-
-				mg += mobility_bonus[pce - 1][attack_cnt].mg;
-				eg += mobility_bonus[pce - 1][attack_cnt].eg;
+			else {
+				piece_attacks = Magics::attacks_bb<pce>(sq, occupied);
 			}
 
-			else if constexpr (pce == ROOK) {
-				// Calculate attacks and update the EvalData object.
-				piece_attacks = Magics::attacks_bb<ROOK>(sq, (pos->all_pieces[WHITE] | pos->all_pieces[BLACK]));
+			// Step 1. Update the attack maps.
+			Data.attacked_by_two[S] |= Data.all_attacks[S] & piece_attacks;
+			Data.all_attacks[S] |= piece_attacks;
+			Data.attacks[S][pce] |= piece_attacks;
 
-				Data.attacked_by_two[S] |= attacked_by_all<S>() & piece_attacks;
-				Data.attacks[S][pce] |= piece_attacks;
+			assert(Data.piece_count[S] < 16);
+			Data.piece_attacks[S][Data.piece_count[S]] = piece_attacks;
+			Data.piece_types[S][Data.piece_count[S]] = uint8_t(pce);
+			Data.piece_count[S]++;
 
-				if ((piece_attacks & enemy_king_ring) != 0) { // If the piece attacks the enemy king area
-					Data.king_attackers[Them]++; // Increment attackers
+			// Step 2. If the piece attacks the enemy king area, increment the attackers and add the attacker's corresponding value.
+			if ((piece_attacks & enemy_king_ring) != 0) {
+				Data.king_attackers[Them]++;
 
-					// Add the attacker's corresponding value.
-					//Data.king_attack_value[Them] += ks_attack_value[pce];
-					Data.king_attack_value[Them] += ks_attack_value[pce] * countBits(piece_attacks & enemy_king_ring);
-				}
-
-
-				piece_attacks &= good_squares; // Only score mobility to good squares.
-
-				attack_cnt = countBits(piece_attacks);
-
-				mg += mobility_bonus[pce - 1][attack_cnt].mg;
-				eg += mobility_bonus[pce - 1][attack_cnt].eg;
+				//Data.king_attack_value[Them] += ks_attack_value[pce];
+				Data.king_attack_value[Them] += ks_attack_value[pce] * countBits(piece_attacks & enemy_king_ring);
 			}
+		}
+	}
 
-			else if constexpr (pce == QUEEN) {
-				// Calculate attacks and update the EvalData object.
-				piece_attacks = Magics::attacks_bb<QUEEN>(sq, (pos->all_pieces[WHITE] | pos->all_pieces[BLACK]));
 
-				Data.attacked_by_two[S] |= attacked_by_all<S>() & piece_attacks;
-				Data.attacks[S][pce] |= piece_attacks;
 
-				if ((piece_attacks & enemy_king_ring) != 0) { // If the piece attacks the enemy king area
-					Data.king_attackers[Them]++; // Increment attackers
+	/// <summary>
+	/// Mobility evaluation. If our pieces have a lot of squares to move to, it is usually a sign that we have a good position.
+	/// </summary>
+	template<EvalType T> template<SIDE S>
+	void Evaluate<T>::mobility() {
+		Score s;
 
-					// Add the attacker's corresponding value.
-					//Data.king_attack_value[Them] += ks_attack_value[pce];
-					Data.king_attack_value[Them] += ks_attack_value[pce] * countBits(piece_attacks & enemy_king_ring);
-				}
+		constexpr SIDE Them = (S == WHITE) ? BLACK : WHITE;
+		constexpr DIRECTION Down = (S == WHITE) ? SOUTH : NORTH;
 
+		// For mobility, we'll only score moves to squares not attacked by pawns, and not to pawns that are blocked.
+		Bitboard good_squares = ~(Data.attacks[Them][PAWN] | pos->pieceBBS[KING][S] |
+			(shift<Down>(pos->all_pieces[WHITE] | pos->all_pieces[BLACK]) & pos->pieceBBS[PAWN][S]));
 
-				piece_attacks &= good_squares; // Only score mobility to good squares.
+		for (int n = 0; n < Data.piece_count[S]; n++) {
+			int pce = Data.piece_types[S][n];
+			int attack_cnt = countBits(Data.piece_attacks[S][n] & good_squares);
 
-				attack_cnt = countBits(piece_attacks);
-				assert(attack_cnt < 29);
+			assert(pce >= KNIGHT && pce <= QUEEN);
+			assert(attack_cnt < 28);
 
-				mg += mobility_bonus[pce - 1][attack_cnt].mg;
-				eg += mobility_bonus[pce - 1][attack_cnt].eg;
-			}
-
-			else { // Just in case we went into the loop without a proper piece-type.
-				assert(pce >= KNIGHT && pce <= QUEEN); // Raise an error.
-				return;
-			}
+			s += mobility_bonus[pce - 1][attack_cnt];
 		}
 
-		
-		mg_score += (S == WHITE) ? mg : -mg;
-		eg_score += (S == WHITE) ? eg : -eg;
+		apply<S>(s);
 	}
 	
 
@@ -741,64 +800,34 @@ namespace Eval {
 		// Constants
 		constexpr SIDE Them = (S == WHITE) ? BLACK : WHITE;
 
-		Score safety(0, 0), eval(0, 0);
+		int safety_mg = 0, safety_eg = 0;
 
 		// Step 1. Only evaluate king safety when there are more than two attackers
 		if (Data.king_attackers[S] > 2 || (Data.king_attackers[S] > 1 && pos->pieceBBS[QUEEN][Them] != 0)) {
+			const Score weight = weighted_attacks[std::clamp(Data.king_attackers[S], 0, 6)];
 
-			safety.mg += (Data.king_attack_value[S] * weighted_attacks[std::clamp(Data.king_attackers[S], 0, 6)].mg) / 100;
-			safety.eg += (Data.king_attack_value[S] * weighted_attacks[std::clamp(Data.king_attackers[S], 0, 6)].eg) / 100;
+			safety_mg += (Data.king_attack_value[S] * weight.mg()) / 100;
+			safety_eg += (Data.king_attack_value[S] * weight.eg()) / 100;
 		}
 
 		// Step 2. Now convert the safety score to CP.
 		// Note: We do this since very few attackers isn't really a problem, whereas it rises greatly even if one attacker is added.
-		eval = Score(-1 * safety.mg * std::max(0, safety.mg) / 256, -1 * std::max(0, safety.eg) / 64);
-
-		mg_score += (S == WHITE) ? eval.mg : -eval.mg;
-		eg_score += (S == WHITE) ? eval.eg : -eval.eg;
+		apply<S>(Score(-1 * safety_mg * std::max(0, safety_mg) / 256, -1 * std::max(0, safety_eg) / 64));
 	}
 
 
 	/// <summary>
-	/// Return a bitboard of all (currently calculated) attacks by one of the sides.
+	/// Return a bitboard of all attacks by one of the sides. Only complete after attack_maps() has been called.
 	/// </summary>
 	/// <returns>Bitboard with all known attacks.</returns>
 	template<EvalType T> template<SIDE S>
 	Bitboard Evaluate<T>::attacked_by_all() {
-		return (Data.attacks[S][PAWN] | Data.attacks[S][KNIGHT] | Data.attacks[S][BISHOP]
-			| Data.attacks[S][ROOK] | Data.attacks[S][QUEEN] | king_ring(pos->king_squares[S]));
-	}
-
-	Bitboard king_flanks[8] = { 0 };
-
-	/// <summary>
-	/// Initialize the king_flanks array.
-	/// </summary>
-	void initKingFlanks() {
-		for (int f = FILE_A; f <= FILE_H; f++) {
-			if (f < FILE_D) {
-				king_flanks[f] = (BBS::FileMasks8[FILE_A] | BBS::FileMasks8[FILE_B] | BBS::FileMasks8[FILE_C]);
-			}
-			else if (f == FILE_D) {
-				king_flanks[f] = (BBS::FileMasks8[FILE_C] | BBS::FileMasks8[FILE_D] | BBS::FileMasks8[FILE_E]);
-			}
-			else if (f == FILE_E) {
-				king_flanks[f] = (BBS::FileMasks8[FILE_D] | BBS::FileMasks8[FILE_E] | BBS::FileMasks8[FILE_F]);
-			}
-			else if (f > FILE_E) {
-				king_flanks[f] = (BBS::FileMasks8[FILE_F] | BBS::FileMasks8[FILE_G] | BBS::FileMasks8[FILE_H]);
-			}
-		}
+		return Data.all_attacks[S];
 	}
 
 	// Explicit Evaluate<> instantiations.
 	template class Evaluate<NORMAL>;
 	template class Evaluate<TRACE>;
-
-	// Initialize the evaulation function. At the moment this is just the king flanks.
-	void INIT() {
-		initKingFlanks();
-	}
 }
 
 
@@ -22,6 +22,8 @@
 #include "movegen.h"
 #include "test_positions.h"
 #include "evaltable.h"
+#include "endgame.h"
+#include "bitbase.h"
 
 
 /*
@@ -30,30 +32,57 @@ Type definitions
 enum GamePhase :int { MG = 0, EG = 1 };
 enum EvalType :int { NORMAL = 0, TRACE = 1 };
 
+/*
+A Score holds a middlegame and an endgame value packed into one 32-bit integer, with the endgame value in the upper 16 bits. Adding two Scores
+is then a single integer addition, which lets the evaluation accumulate both phases at once. The arithmetic is done on unsigned integers, since the
+lower half borrows from the upper one when it is negative. Both values have to stay within the range of an int16_t.
+*/
 class Score {
 public:
-	Score(int m, int e) { mg = m; eg = e; }
-	Score(const Score& s) { mg = s.mg; eg = s.eg; }
-	Score() { mg = 0; eg = 0; }
-	
+	constexpr Score() : value(0) {}
+	constexpr Score(int m, int e) : value(int32_t(uint32_t(e) * 0x10000u + uint32_t(m))) {}
+
+	constexpr int mg() const { return int16_t(uint16_t(uint32_t(value))); }
+	constexpr int eg() const { return int16_t(uint16_t((uint32_t(value) + 0x8000u) >> 16)); }
+
 	// Some operators.
-	Score& operator+=(const Score& rhs) { this->mg += rhs.mg; this->eg += rhs.eg; return *this;}
-	Score& operator-=(const Score& rhs) { this->mg -= rhs.mg; this->eg -= rhs.eg; return *this;}
-	Score operator+(const Score& rhs) { 
-		Score s;
-		s.mg = mg + rhs.mg; s.eg = eg + rhs.eg;
-		return s;
-	}
-	Score operator-(const Score& rhs) {
+	constexpr Score operator+(const Score rhs) const { return from_value(uint32_t(value) + uint32_t(rhs.value)); }
+	constexpr Score operator-(const Score rhs) const { return from_value(uint32_t(value) - uint32_t(rhs.value)); }
+	constexpr Score operator-() const { return from_value(0u - uint32_t(value)); }
+	constexpr Score operator*(const int i) const { return from_value(uint32_t(value) * uint32_t(i)); }
+
+	constexpr Score& operator+=(const Score rhs) { return *this = *this + rhs; }
+	constexpr Score& operator-=(const Score rhs) { return *this = *this - rhs; }
+
+	constexpr bool operator==(const Score rhs) const { return value == rhs.value; }
+	constexpr bool operator!=(const Score rhs) const { return value != rhs.value; }
+
+private:
+	int32_t value;
+
+	static constexpr Score from_value(uint32_t v) {
 		Score s;
-		s.mg = mg - rhs.mg; s.eg = eg - rhs.eg;
+		s.value = int32_t(v);
 		return s;
 	}
-
-	int mg = 0;
-	int eg = 0;
 };
 
+static_assert(sizeof(Score) == 4);
+static_assert(Score(-3, 5).mg() == -3 && Score(-3, 5).eg() == 5 && (Score(-3, 5) - Score(4, -7)).eg() == 12);
+
+
+/*
+The evaluation parameters are compile-time constants. Tuning builds (make tune=yes) need to change them at runtime, so there they are ordinary
+variables instead.
+*/
+#if defined(TUNE)
+#define TUNABLE
+#define TUNABLE_DEF
+#else
+#define TUNABLE const
+#define TUNABLE_DEF constexpr
+#endif
+
 
 
 namespace Eval {
@@ -67,6 +96,20 @@ namespace Eval {
 	public:
 		int score(const GameState_t* _pos, bool use_table = true);
 
+		// Evaluate against a search window. If the score of the cheap terms is outside [alpha, beta] by more than lazy_margin, it is returned
+		//	without evaluating space, mobility and king safety.
+		int score(const GameState_t* _pos, int alpha, int beta, bool use_table = true);
+
+		// The number of windowed evaluations and how many of them exited early.
+		uint64_t lazy_calls = 0;
+		uint64_t lazy_exits = 0;
+
+#if defined(SEARCH_STATS)
+		// The probes and hits of the evaluation hash table.
+		uint64_t table_probes = 0;
+		uint64_t table_hits = 0;
+#endif
+
 	private:
 		// The position object that we get when score is called. This is just stored such that all member methods can access it without it being passed as a parameter.
 		const GameState_t* pos = nullptr;
@@ -78,6 +121,15 @@ namespace Eval {
 			Bitboard attacks[2][6] = { {0} };
 			Bitboard attacked_by_two[2] = { 0 };
 
+			// Attacks by all pieces of a side, including the king ring. Indexed by [side]
+			Bitboard all_attacks[2] = { 0 };
+
+			// The attacks of every knight, bishop, rook and queen, stored as parallel arrays indexed by [side][n] for the n'th piece. They are
+			//	generated once by attack_maps() and re-used by the other terms.
+			Bitboard piece_attacks[2][16] = { {0} };
+			uint8_t piece_types[2][16] = { {0} };
+			int piece_count[2] = { 0 };
+
 			// Passed pawns
 			Bitboard passed_pawns[2] = { 0 };
 
@@ -91,18 +143,32 @@ namespace Eval {
 		const EvalData ZeroData;
 		EvalData Data;
 
-		// Scores for middlegame and endgame respectively
-		int mg_score = 0;
-		int eg_score = 0;
+		// The middlegame and endgame scores from white's point of view.
+		Score total;
+
+		// Add a score for side S to the total.
+		template<SIDE S> void apply(const Score s) {
+			total += (S == WHITE) ? s : -s;
+		}
 
 		// Clear all data from the previous evaluation.
 		void clear();
 
+		template<bool Lazy> int evaluate(const GameState_t* _pos, int alpha, int beta, bool use_table);
+
+		// Scale the endgame score and interpolate between the middlegame and endgame scores. The result is from white's point of view.
+		int interpolate(const MaterialEntry_t* material_entry) const;
+
 		/*
 		Evaluation sub-methods.
 		*/
 		int game_phase();
 
+		// Looks up the material hash table entry for the position. On a miss, the material terms are computed and stored.
+		const MaterialEntry_t* probe_material(bool use_table);
+
+		template<SIDE S> int scale_factor();
+
 		template<SIDE S> void material();
 
 		template<SIDE S> void psqt();
@@ -113,7 +179,10 @@ namespace Eval {
 
 		template<SIDE S> void space();
 
-		template<SIDE S, piece pce> void mobility();
+		template<SIDE S> void attack_maps();
+		template<SIDE S, piece pce> void add_piece_attacks(Bitboard occupied, Bitboard enemy_king_ring);
+
+		template<SIDE S> void mobility();
 
 		template<SIDE S> void king_safety();
 		template<SIDE S> void king_pawns(); // Called in pawns().
@@ -121,21 +190,26 @@ namespace Eval {
 		// An evaluation hash table to re-use recently calculated evaluations.
 		EvaluationTable eval_table;
 
+		// A material hash table to re-use the terms that only depend on material.
+		MaterialTable material_table;
+		MaterialEntry_t material_scratch;
+
 		//template<SIDE S> Bitboard weak_squares();
 		template<SIDE S> Bitboard attacked_by_all();
 	};
 	
 	
 	// The king flanks array is used to determine which pawns to analyze depending on the king's file.
-	extern Bitboard king_flanks[8];
-	
-
-	/*
-	Initialization functions
-	*/
-	void initKingFlanks();
-
-	void INIT();
+	inline constexpr Bitboard king_flanks[8] = {
+		BBS::FileMasks8[FILE_A] | BBS::FileMasks8[FILE_B] | BBS::FileMasks8[FILE_C],
+		BBS::FileMasks8[FILE_A] | BBS::FileMasks8[FILE_B] | BBS::FileMasks8[FILE_C],
+		BBS::FileMasks8[FILE_A] | BBS::FileMasks8[FILE_B] | BBS::FileMasks8[FILE_C],
+		BBS::FileMasks8[FILE_C] | BBS::FileMasks8[FILE_D] | BBS::FileMasks8[FILE_E],
+		BBS::FileMasks8[FILE_D] | BBS::FileMasks8[FILE_E] | BBS::FileMasks8[FILE_F],
+		BBS::FileMasks8[FILE_F] | BBS::FileMasks8[FILE_G] | BBS::FileMasks8[FILE_H],
+		BBS::FileMasks8[FILE_F] | BBS::FileMasks8[FILE_G] | BBS::FileMasks8[FILE_H],
+		BBS::FileMasks8[FILE_F] | BBS::FileMasks8[FILE_G] | BBS::FileMasks8[FILE_H]
+	};
 
 	/// <summary>
 	/// Used to check that the eval works and doesn't give different values for black and white.
@@ -149,11 +223,11 @@ namespace Eval {
 /*
 Material values.
 */
-extern const Score pawn_value;
-extern const Score knight_value;
-extern const Score bishop_value;
-extern const Score rook_value;
-extern const Score queen_value;
+extern TUNABLE Score pawn_value;
+extern TUNABLE Score knight_value;
+extern TUNABLE Score bishop_value;
+extern TUNABLE Score rook_value;
+extern TUNABLE Score queen_value;
 
 
 /*
@@ -161,51 +235,67 @@ Piece-square tables (defined in psqt.cpp)
 */
 namespace PSQT {
 
-	extern const Score PawnTable[64];
+	extern TUNABLE Score PawnTable[64];
 
-	extern const Score KnightTable[64];
+	extern TUNABLE Score KnightTable[64];
 
-	extern const Score BishopTable[64];
+	extern TUNABLE Score BishopTable[64];
 
-	extern const Score RookTable[64];
+	extern TUNABLE Score RookTable[64];
 
-	extern const Score QueenTable[64];
+	extern TUNABLE Score QueenTable[64];
 
-	extern const Score KingTable[64];
+	extern TUNABLE Score KingTable[64];
 
 	// Other psqt's
 	extern const int Mirror64[64];
-	extern int ManhattanDistance[64][64];
 
-	// Initializer methods.
-	void initManhattanDistance();
-	extern void INIT();
+	/// <summary>
+	/// Generate the Manhattan Distance table, which holds the amount of moves it would take a king to get from one square to another if it
+	/// couldn't move diagonally.
+	/// </summary>
+	constexpr std::array<std::array<int, 64>, 64> make_manhattan_distance() {
+		std::array<std::array<int, 64>, 64> distance{};
+
+		for (int sq1 = 0; sq1 < 64; sq1++) {
+			for (int sq2 = 0; sq2 < 64; sq2++) {
+				int rank_distance = (sq1 / 8 > sq2 / 8) ? sq1 / 8 - sq2 / 8 : sq2 / 8 - sq1 / 8;
+				int file_distance = (sq1 % 8 > sq2 % 8) ? sq1 % 8 - sq2 % 8 : sq2 % 8 - sq1 % 8;
+
+				distance[sq1][sq2] = rank_distance + file_distance;
+			}
+		}
+
+		return distance;
+	}
+
+	inline constexpr std::array<std::array<int, 64>, 64> ManhattanDistance = make_manhattan_distance();
 }
 
 
 /*
 Imbalance
 */
-extern const Score bishop_pair;
-extern const Score knight_pawn_penaly;
-extern const Score rook_pawn_bonus;
+extern TUNABLE Score bishop_pair;
+extern TUNABLE Score knight_pawn_penaly;
+extern TUNABLE Score rook_pawn_bonus;
 
 
 /*
 Pawn evaluation
 */
-extern const Score doubled_penalty;
-extern const Score doubled_isolated_penalty;
-extern const Score isolated_penalty;
-extern const Score backwards_penalty;
+extern TUNABLE Score doubled_penalty;
+extern TUNABLE Score doubled_isolated_penalty;
+extern TUNABLE Score isolated_penalty;
+extern TUNABLE Score backwards_penalty;
 
-extern const Score passedPawnTable[64];
+extern TUNABLE Score passedPawnTable[64];
 
 
 /*
 Space evaluation
 */
-extern const Score space_bonus[32];
+extern TUNABLE Score space_bonus[32];
 
 
 /*
@@ -217,44 +307,55 @@ extern const std::array<const Score*, 4> mobility_bonus;
 /*
 Piece evaluation
 */
-extern const Score outpost;
-extern const Score reachable_outpost;
-extern const Score knight_on_kingring;
-extern const Score defended_knight;
-extern const Score bishop_on_kingring;
-extern const Score bishop_on_queen;
-extern const Score bad_bishop_coeff;
-extern const Score doubled_rooks;
-extern const Score rook_on_queen;
-extern const Score rook_on_kingring;
-extern const Score rook_open_file;
-extern const Score rook_semi_open_file;
-extern const Score rook_behind_passer;
-extern const Score queen_on_kingring;
-extern const Score threatened_queen;
-extern const Score queen_development_penalty[5];
+extern TUNABLE Score outpost;
+extern TUNABLE Score reachable_outpost;
+extern TUNABLE Score knight_on_kingring;
+extern TUNABLE Score defended_knight;
+extern TUNABLE Score bishop_on_kingring;
+extern TUNABLE Score bishop_on_queen;
+extern TUNABLE Score bad_bishop_coeff;
+extern TUNABLE Score doubled_rooks;
+extern TUNABLE Score rook_on_queen;
+extern TUNABLE Score rook_on_kingring;
+extern TUNABLE Score rook_open_file;
+extern TUNABLE Score rook_semi_open_file;
+extern TUNABLE Score rook_behind_passer;
+extern TUNABLE Score queen_on_kingring;
+extern TUNABLE Score threatened_queen;
+extern TUNABLE Score queen_development_penalty[5];
 
 
 /*
 King pawn shield eval.
 */
-extern const Score minimum_kp_distance[15];
-extern const Score king_shelter[2][64];
-extern const Score open_file[8];
-extern const Score semi_open_file[8];
+extern TUNABLE Score minimum_kp_distance[15];
+extern TUNABLE Score king_shelter[2][64];
+extern TUNABLE Score open_file[8];
+extern TUNABLE Score semi_open_file[8];
 
 /*
 King safety evaluation
 */
 constexpr int ks_attack_value[5] = { 0, 20, 20, 40, 80 }; // Values for attacking the king zone (pawn, knight, bishop, rook, queen)
-extern const Score weighted_attacks[7];
+extern TUNABLE Score weighted_attacks[7];
 
 
 /*
 Other constants
 */
 constexpr int tempo = 18;
-extern const int max_material[2];
+
+/*
+Lazy evaluation. Space, mobility and king safety are skipped if the rest of the evaluation is this far outside the search window.
+*/
+constexpr int lazy_margin = 500;
+
+/*
+NNUE. When a network is loaded, it evaluates the positions where the material and imbalance terms are within this margin. The classical evaluation
+is kept for lopsided positions, where it is both cheaper and good enough.
+*/
+constexpr int nnue_threshold = 1200;
+extern TUNABLE int max_material[2];
 
 
 
@@ -317,8 +418,9 @@ template<GamePhase P, SIDE S> inline int non_pawn_material(const GameState_t* po
 	int queenCnt = countBits(pos->pieceBBS[QUEEN][S]);
 
 	// Step 2. Return the non-pawn material.
-	return (P == MG) ? (knightCnt * knight_value.mg + bishopCnt * bishop_value.mg + rookCnt * rook_value.mg + queenCnt * queen_value.mg)
-		: (knightCnt * knight_value.eg + bishopCnt * bishop_value.eg + rookCnt * rook_value.eg + queenCnt * queen_value.eg);
+	Score npm = knight_value * knightCnt + bishop_value * bishopCnt + rook_value * rookCnt + queen_value * queenCnt;
+
+	return (P == MG) ? npm.mg() : npm.eg();
 }
 
 #endif
\ No newline at end of file
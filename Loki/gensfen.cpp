@@ -0,0 +1,347 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "gensfen.h"
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <iomanip>
+
+
+namespace Gensfen {
+
+	// The number of positions a thread collects before writing them to its file.
+	constexpr size_t WRITE_BUFFER = 8192;
+
+	const char PIECE_CHARS[2][7] = { "pnbrqk", "PNBRQK" };
+
+
+	/*
+
+	Pack a position. The score is relative to the side to move and is stored from white's point of view.
+
+	*/
+	PackedPosition pack(const GameState_t* pos, int score, unsigned int move) {
+		PackedPosition p;
+		std::memset(&p, 0, sizeof(PackedPosition));
+
+		p.occupied = pos->all_pieces[WHITE] | pos->all_pieces[BLACK];
+
+		// Step 1. Store the pieces in the order of their squares.
+		Bitboard occupied = p.occupied;
+		int n = 0;
+		while (occupied) {
+			int sq = PopBit(&occupied);
+			SIDE side = (pos->piece_list[WHITE][sq] != NO_TYPE) ? WHITE : BLACK;
+			int code = piece_index(side, pos->piece_list[side][sq]);
+
+			p.pieces[n / 2] |= uint8_t(code << (4 * (n % 2)));
+			n++;
+		}
+
+		// Step 2. Store the score, move and state.
+		score = (pos->side_to_move == WHITE) ? score : -score;
+		p.score = int16_t(std::clamp(score, -32000, 32000));
+		p.move = uint16_t(move);
+
+		p.result = 1;
+		p.flags = uint8_t(((pos->side_to_move == WHITE) ? 1 : 0) | (pos->castleRights << 1));
+		p.ep_square = uint8_t(pos->enPasSq);
+		p.fifty_move = uint8_t(std::min(pos->fiftyMove, 255));
+
+		return p;
+	}
+
+
+	/*
+
+	Unpack a position into a FEN string. The move number isn't stored, so it is always 1.
+
+	*/
+	std::string to_fen(const PackedPosition& p) {
+		std::ostringstream fen;
+
+		// Step 1. Find the piece on each square.
+		int board[64];
+		std::fill(board, board + 64, -1);
+
+		Bitboard occupied = p.occupied;
+		int n = 0;
+		while (occupied) {
+			int sq = PopBit(&occupied);
+			board[sq] = (p.pieces[n / 2] >> (4 * (n % 2))) & 15;
+			n++;
+		}
+
+		// Step 2. Write the board from the eighth rank and down.
+		for (int rank = 7; rank >= 0; rank--) {
+			int empty = 0;
+
+			for (int file = 0; file < 8; file++) {
+				int code = board[8 * rank + file];
+
+				if (code < 0) {
+					empty++;
+					continue;
+				}
+				if (empty > 0) {
+					fen << empty;
+					empty = 0;
+				}
+				fen << PIECE_CHARS[code / 6][code % 6];
+			}
+			if (empty > 0) {
+				fen << empty;
+			}
+			if (rank > 0) {
+				fen << '/';
+			}
+		}
+
+		// Step 3. Write the side to move, castling rights, en-passant square and fifty-move counter.
+		fen << ((p.flags & 1) ? " w " : " b ");
+
+		int castling = p.flags >> 1;
+		if (castling == 0) {
+			fen << '-';
+		}
+		if (castling & (1 << WKCA)) { fen << 'K'; }
+		if (castling & (1 << WQCA)) { fen << 'Q'; }
+		if (castling & (1 << BKCA)) { fen << 'k'; }
+		if (castling & (1 << BQCA)) { fen << 'q'; }
+
+		fen << ' ' << ((p.ep_square < 64) ? index_to_uci(p.ep_square) : std::string("-"));
+		fen << ' ' << int(p.fifty_move) << " 1";
+
+		return fen.str();
+	}
+
+
+
+	/*
+
+	The state shared by the generating threads. Each thread writes to its own file, so only the counters are shared.
+
+	*/
+	struct SharedState {
+		std::atomic<long long> positions{ 0 };
+		std::atomic<long long> games{ 0 };
+	};
+
+
+	/*
+
+	Make a move at the root and reset the ply, like it is done for the moves of the "position" command.
+
+	*/
+	static void play(GameState_t* pos, unsigned int move) {
+		Move_t m; m.move = move;
+
+		bool legal = pos->make_move(&m);
+		assert(legal);
+		(void)legal;
+
+		pos->ply = 0;
+	}
+
+
+	/*
+
+	Play one game on a thread and return its quiet positions with the result filled in. The game is restarted if the random opening ends it.
+
+	*/
+	static void play_game(SearchThread_t* thread, const Settings& settings, std::mt19937_64& rng, std::vector<PackedPosition>& game) {
+		GameState_t* pos = thread->pos;
+		game.clear();
+
+		// The shared table is aged once per game, so the entries of the earlier games can be replaced.
+		thread->table()->increment_age();
+
+		// Step 1. Play the random opening moves.
+		std::vector<unsigned int> moves;
+		bool opening_done = false;
+
+		while (!opening_done) {
+			pos->parseFen(START_FEN);
+			opening_done = true;
+
+			for (int p = 0; p < settings.random_plies; p++) {
+				moves = moveGen::legal_moves(pos);
+
+				if (moves.empty()) {
+					opening_done = false;
+					break;
+				}
+				play(pos, moves[rng() % moves.size()]);
+			}
+		}
+
+		// Step 2. Search and play moves until the game ends. The result is from white's point of view.
+		int result = 1;
+
+		for (int game_ply = 0; game_ply < settings.max_plies; game_ply++) {
+
+			// Step 2A. Checkmate, stalemate or a draw by rule ends the game.
+			moves = moveGen::legal_moves(pos);
+
+			if (moves.empty()) {
+				if (pos->in_check()) {
+					result = (pos->side_to_move == WHITE) ? 0 : 2;
+				}
+				break;
+			}
+			if (pos->is_draw()) {
+				break;
+			}
+
+			// Step 2B. Search the position.
+			thread->info->clear();
+			thread->info->starttime = getTimeMs();
+			thread->info->depth = (settings.nodes > 0) ? MAXDEPTH : settings.depth;
+			thread->info->node_limit = settings.nodes;
+
+			Search::searchPosition(thread);
+
+			unsigned int move = thread->best_move;
+			int score = thread->best_score;
+
+			if (move == NOMOVE) {
+				break;
+			}
+
+			// Step 2C. Adjudicate the game if one side is clearly winning.
+			if (std::abs(score) >= settings.adjudicate) {
+				result = ((score > 0) == (pos->side_to_move == WHITE)) ? 2 : 0;
+				break;
+			}
+
+			// Step 2D. Only keep the quiet positions, where the static evaluation should be close to the search score.
+			SIDE Them = (pos->side_to_move == WHITE) ? BLACK : WHITE;
+			bool quiet_move = SPECIAL(move) == NOT_SPECIAL && pos->piece_list[Them][TOSQ(move)] == NO_TYPE;
+
+			if (!pos->in_check() && quiet_move) {
+				game.push_back(pack(pos, score, move));
+			}
+
+			play(pos, move);
+		}
+
+		// Step 3. Fill in the result.
+		for (auto& p : game) {
+			p.result = uint8_t(result);
+		}
+	}
+
+
+	/*
+
+	The work of a single thread. It plays games until the shared position count reaches the requested number.
+
+	*/
+	static void worker(int id, const Settings& settings, SharedState& shared) {
+		SearchThread_t* thread = new SearchThread_t;
+		thread->thread_id = id;
+		thread->standalone = true;
+
+		std::mt19937_64 rng(settings.seed + uint64_t(id));
+
+		std::ofstream file(settings.output + "_" + std::to_string(id) + ".bin", std::ios::binary);
+
+		std::vector<PackedPosition> buffer;
+		std::vector<PackedPosition> game;
+		buffer.reserve(WRITE_BUFFER + 2 * settings.max_plies);
+
+		while (shared.positions.load(std::memory_order_relaxed) < settings.positions) {
+			play_game(thread, settings, rng, game);
+
+			buffer.insert(buffer.end(), game.begin(), game.end());
+			shared.positions += game.size();
+			shared.games++;
+
+			if (buffer.size() >= WRITE_BUFFER) {
+				file.write(reinterpret_cast<const char*>(buffer.data()), std::streamsize(buffer.size() * sizeof(PackedPosition)));
+				buffer.clear();
+			}
+		}
+
+		file.write(reinterpret_cast<const char*>(buffer.data()), std::streamsize(buffer.size() * sizeof(PackedPosition)));
+
+		delete thread;
+	}
+
+
+	/*
+
+	Generate the positions on settings.threads threads, printing the progress every few seconds. The number of positions is a minimum, since
+	every thread finishes the game it is playing.
+
+	*/
+	void run(const Settings& settings) {
+		SharedState shared;
+
+		tt->clear_table();
+
+		long long start = getTimeMs();
+		long long last_report = start;
+
+		run_parallel(settings.threads,
+			[&](int id) { worker(id, settings, shared); },
+			[&]() {
+				if (getTimeMs() - last_report >= 5000) {
+					last_report = getTimeMs();
+					std::cout << "info string gensfen " << shared.positions.load() << "/" << settings.positions << " positions, "
+						<< shared.games.load() << " games" << std::endl;
+				}
+			});
+
+		double seconds = std::max(getTimeMs() - start, 1LL) / 1000.0;
+		double rate = shared.positions.load() / seconds;
+
+		std::cout << "info string gensfen done: " << shared.positions.load() << " positions from " << shared.games.load() << " games in "
+			<< std::fixed << std::setprecision(1) << seconds << "s, " << std::setprecision(0) << rate << " positions/s ("
+			<< rate / settings.threads << " per thread)" << std::endl;
+	}
+
+
+	void parse(const std::string& command) {
+		Settings settings;
+
+		std::istringstream ss(command);
+		std::string token;
+		ss >> token; // "gensfen"
+
+		while (ss >> token) {
+			if (token == "depth") { ss >> settings.depth; }
+			else if (token == "nodes") { ss >> settings.nodes; }
+			else if (token == "positions") { ss >> settings.positions; }
+			else if (token == "threads") { ss >> settings.threads; }
+			else if (token == "random_plies") { ss >> settings.random_plies; }
+			else if (token == "max_plies") { ss >> settings.max_plies; }
+			else if (token == "adjudicate") { ss >> settings.adjudicate; }
+			else if (token == "seed") { ss >> settings.seed; }
+			else if (token == "output") { ss >> settings.output; }
+		}
+
+		settings.depth = std::clamp(settings.depth, 1, MAXDEPTH - 1);
+		settings.threads = std::clamp(settings.threads, THREADS_MIN_NUM, THREADS_MAX_NUM);
+		settings.random_plies = std::clamp(settings.random_plies, 0, 100);
+		settings.max_plies = std::clamp(settings.max_plies, 1, MAXGAMEMOVES - settings.random_plies - 1);
+
+		run(settings);
+	}
+}
@@ -0,0 +1,86 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef GENSFEN_H
+#define GENSFEN_H
+#include "search.h"
+
+#include <string>
+
+
+/*
+
+Self-play data generation. Every thread plays its own games from a few random opening moves with a fixed depth or node limit per move, and writes
+the quiet positions with their search scores and the game results to its own file. The files have no header, so the files of several threads or
+runs can simply be concatenated.
+
+*/
+namespace Gensfen {
+
+	/// <summary>
+	/// A position with its search score and game result, packed into 32 bytes. The integers are little-endian.
+	/// </summary>
+	struct PackedPosition {
+		// The occupied squares.
+		uint64_t occupied;
+
+		// A 4-bit code, side * 6 + piece type, for each occupied square from A1 to H8. The first piece is in the low bits of the first byte.
+		uint8_t pieces[16];
+
+		// The search score from white's point of view and the move that was played.
+		int16_t score;
+		uint16_t move;
+
+		// 0 if black won, 1 for a draw and 2 if white won.
+		uint8_t result;
+
+		// Bit 0 is set if white is to move, and bits 1-4 are the castling rights.
+		uint8_t flags;
+
+		uint8_t ep_square;
+		uint8_t fifty_move;
+	};
+
+	static_assert(sizeof(PackedPosition) == 32);
+
+
+	PackedPosition pack(const GameState_t* pos, int score, unsigned int move);
+
+	// Returns the FEN of a packed position.
+	std::string to_fen(const PackedPosition& p);
+
+
+	struct Settings {
+		int depth = 8;				// The depth of each search. Ignored if nodes is set.
+		long long nodes = 0;		// The node limit of each search.
+		long long positions = 100000;
+		int threads = 1;
+		int random_plies = 8;		// The number of random moves played from the starting position.
+		int max_plies = 400;		// Games that get this long are scored as draws.
+		int adjudicate = 2000;		// Games are scored as won when the search score gets this high.
+		uint64_t seed = 0;
+		std::string output = "gensfen";	// Thread n writes to <output>_<n>.bin.
+	};
+
+	void run(const Settings& settings);
+
+	// Parses a "gensfen [depth d] [nodes n] [positions p] [threads t] [random_plies r] [seed s] [output name]" command and runs it.
+	void parse(const std::string& command);
+}
+
+
+#endif
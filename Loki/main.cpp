@@ -22,13 +22,23 @@ int main(int argc, char* argv[]) {
 	BBS::INIT();
 	Magics::INIT();
 	Search::INIT();
-	Eval::INIT();
-	PSQT::INIT();
+	Endgame::INIT();
+	NNUE::INIT();
+	Syzygy::INIT();
 
 
-	// If "bench" has been added as an argument, just run this and quit.
+	// If "bench" has been added as an argument, just run this and quit. "bench sliders" and "bench eval" time the slider attack lookups and
+	//	the static evaluation instead.
 	if (argc > 1 && !strncmp(argv[1], "bench", 5)) {
-		Bench::run_benchmark();
+		if (argc > 2 && !strncmp(argv[2], "sliders", 7)) {
+			Bench::run_slider_benchmark();
+		}
+		else if (argc > 2 && !strncmp(argv[2], "eval", 4)) {
+			Bench::run_eval_benchmark();
+		}
+		else {
+			Bench::run_benchmark();
+		}
 		return 0;
 	}
 	
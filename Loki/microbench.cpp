@@ -0,0 +1,316 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "uci.h" // Include all of the engine
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+
+#if defined(HAS_PEXT_INSTRUCTION)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+
+/*
+
+Microbenchmarks of the primitives the search spends most of its time in. This is a separate executable, built with "make microbench", so the
+numbers of a single subsystem can be compared between two builds when the nps of "bench" changes.
+
+Every primitive is run over the positions of Bench::benchmarks. After a warm-up run, it is timed a number of times and the fastest and median
+time per call are printed, both in nanoseconds and in processor cycles (zero where the time stamp counter isn't available). The output is CSV
+with one line per primitive, following a header line after the startup messages of the engine:
+
+	primitive,calls,ns_min,ns_median,cycles_min,cycles_median,checksum
+
+The checksum depends on the results of all calls, so they can't be optimized away, and it should be the same for every build with the same number of
+repetitions.
+
+Usage: Loki3-microbench [repetitions] [primitive ...]
+
+*/
+namespace {
+
+	constexpr int DEFAULT_REPETITIONS = 10;
+
+	inline uint64_t cycles() {
+#if defined(HAS_PEXT_INSTRUCTION)
+		return __rdtsc();
+#else
+		return 0;
+#endif
+	}
+
+
+	/*
+
+	A bench position with its pseudo-legal moves.
+
+	*/
+	struct BenchPosition {
+		GameState_t* pos = nullptr;
+		std::vector<Move_t> moves;
+		std::vector<Move_t> captures;
+	};
+
+
+	struct Timing {
+		long long calls = 0;
+		double ns_min = 0.0, ns_median = 0.0;
+		double cycles_min = 0.0, cycles_median = 0.0;
+	};
+
+
+	/*
+
+	Time a primitive. run does one pass over the positions, adds its results to the checksum and returns the number of calls it made.
+
+	*/
+	template<typename F>
+	Timing measure(F run, int repetitions, uint64_t& checksum) {
+		std::vector<double> ns, cyc;
+		Timing t;
+
+		// Step 1. Warm up the caches and branch predictors.
+		run(checksum);
+
+		// Step 2. Time the repetitions.
+		for (int r = 0; r < repetitions; r++) {
+			auto start = std::chrono::steady_clock::now();
+			uint64_t start_cycles = cycles();
+
+			long long calls = run(checksum);
+
+			uint64_t end_cycles = cycles();
+			auto end = std::chrono::steady_clock::now();
+
+			t.calls = calls;
+			ns.push_back(std::chrono::duration<double, std::nano>(end - start).count() / double(std::max(calls, 1LL)));
+			cyc.push_back(double(end_cycles - start_cycles) / double(std::max(calls, 1LL)));
+		}
+
+		// Step 3. Take the fastest and median repetitions.
+		std::sort(ns.begin(), ns.end());
+		std::sort(cyc.begin(), cyc.end());
+
+		t.ns_min = ns.front();
+		t.ns_median = ns[ns.size() / 2];
+		t.cycles_min = cyc.front();
+		t.cycles_median = cyc[cyc.size() / 2];
+
+		return t;
+	}
+
+
+	template<MoveType T>
+	long long generate(std::vector<BenchPosition>& positions, int iterations, uint64_t& checksum) {
+		long long calls = 0;
+
+		for (int i = 0; i < iterations; i++) {
+			for (BenchPosition& bp : positions) {
+				// The evasions are only generated in check, and the other types only when not in check.
+				if ((T == EVASIONS) != bp.pos->in_check()) {
+					continue;
+				}
+
+				MoveList ml; moveGen::generate<T>(bp.pos, &ml);
+				checksum += ml.size();
+				calls++;
+			}
+		}
+
+		return calls;
+	}
+}
+
+
+int main(int argc, char* argv[]) {
+	BBS::INIT();
+	Magics::INIT();
+	Search::INIT();
+	Endgame::INIT();
+	Bitbase::INIT();
+	NNUE::INIT();
+	Syzygy::INIT();
+
+	// Step 1. Parse the arguments.
+	int repetitions = DEFAULT_REPETITIONS;
+	std::vector<std::string> selected;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::isdigit(argv[i][0])) {
+			repetitions = std::max(std::atoi(argv[i]), 1);
+		}
+		else {
+			selected.push_back(argv[i]);
+		}
+	}
+
+	// Step 2. Set up the positions, and the keys of their children for the transposition table.
+	std::vector<BenchPosition> positions;
+	std::vector<uint64_t> keys;
+
+	tt->clear_table();
+
+	for (const std::string& fen : Bench::benchmarks) {
+		BenchPosition bp;
+		bp.pos = new GameState_t;
+		bp.pos->parseFen(fen);
+
+		MoveList ml; moveGen::generate<ALL>(bp.pos, &ml);
+		for (Move_t& m : ml) {
+			bp.moves.push_back(m);
+
+			if (!bp.pos->make_move(&m)) {
+				continue;
+			}
+
+			// Half of the keys are stored, so the probes are a mix of hits and misses.
+			keys.push_back(uint64_t(bp.pos->posKey));
+			if (keys.size() % 2 == 0) {
+				tt->store_entry(bp.pos, uint16_t(m.move), 0, 1, 0);
+			}
+			bp.pos->undo_move();
+		}
+
+		// The capture generator also gives the quiet promotions, which SEE doesn't take.
+		MoveList caps; moveGen::generate<CAPTURES>(bp.pos, &caps);
+		SIDE Them = (bp.pos->side_to_move == WHITE) ? BLACK : WHITE;
+
+		for (Move_t& m : caps) {
+			if (bp.pos->piece_list[Them][TOSQ(m.move)] != NO_TYPE) {
+				bp.captures.push_back(m);
+			}
+		}
+
+		positions.push_back(bp);
+	}
+
+	Eval::Evaluate<NORMAL>* eval = new Eval::Evaluate<NORMAL>;
+
+	// Step 3. The primitives. Each does one pass of roughly the same length, so every repetition takes a few milliseconds.
+	struct Primitive {
+		std::string name;
+		std::function<long long(uint64_t&)> run;
+	};
+
+	std::vector<Primitive> primitives = {
+		{ "make_undo", [&](uint64_t& checksum) {
+			long long calls = 0;
+
+			for (int i = 0; i < 300; i++) {
+				for (BenchPosition& bp : positions) {
+					for (Move_t& m : bp.moves) {
+						if (bp.pos->make_move(&m)) {
+							checksum += bp.pos->posKey;
+							bp.pos->undo_move();
+						}
+						calls++;
+					}
+				}
+			}
+			return calls;
+		} },
+		{ "generate_all", [&](uint64_t& checksum) { return generate<ALL>(positions, 500, checksum); } },
+		{ "generate_captures", [&](uint64_t& checksum) { return generate<CAPTURES>(positions, 1000, checksum); } },
+		{ "generate_quiet", [&](uint64_t& checksum) { return generate<QUIET>(positions, 500, checksum); } },
+		{ "generate_quiet_checks", [&](uint64_t& checksum) { return generate<QUIET_CHECKS>(positions, 500, checksum); } },
+		{ "generate_evasions", [&](uint64_t& checksum) { return generate<EVASIONS>(positions, 5000, checksum); } },
+		{ "attacks_bb", [&](uint64_t& checksum) {
+			long long calls = 0;
+
+			for (int i = 0; i < 100; i++) {
+				for (BenchPosition& bp : positions) {
+					Bitboard occ = bp.pos->all_pieces[WHITE] | bp.pos->all_pieces[BLACK];
+
+					for (int sq = 0; sq < 64; sq++) {
+						checksum += Magics::attacks_bb<ROOK>(sq, occ) ^ Magics::attacks_bb<BISHOP>(sq, occ);
+					}
+					calls += 128;
+				}
+			}
+			return calls;
+		} },
+		{ "see", [&](uint64_t& checksum) {
+			long long calls = 0;
+
+			for (int i = 0; i < 1000; i++) {
+				for (BenchPosition& bp : positions) {
+					for (Move_t& m : bp.captures) {
+						checksum += bp.pos->see(m.move);
+						calls++;
+					}
+				}
+			}
+			return calls;
+		} },
+		{ "evaluate", [&](uint64_t& checksum) {
+			long long calls = 0;
+
+			for (int i = 0; i < 1000; i++) {
+				for (BenchPosition& bp : positions) {
+					checksum += eval->score(bp.pos, false);
+					calls++;
+				}
+			}
+			return calls;
+		} },
+		{ "probe_tt", [&](uint64_t& checksum) {
+			long long calls = 0;
+
+			for (int i = 0; i < 200; i++) {
+				for (uint64_t key : keys) {
+					bool hit = false;
+					tt->probe_tt(key, hit);
+					checksum += hit;
+					calls++;
+				}
+			}
+			return calls;
+		} },
+	};
+
+	// Step 4. Run the selected primitives and print the results.
+	std::cout << "primitive,calls,ns_min,ns_median,cycles_min,cycles_median,checksum" << std::endl;
+
+	for (Primitive& p : primitives) {
+		if (!selected.empty() && std::find(selected.begin(), selected.end(), p.name) == selected.end()) {
+			continue;
+		}
+
+		uint64_t checksum = 0;
+		Timing t = measure(p.run, repetitions, checksum);
+
+		if (t.calls == 0) {
+			continue;
+		}
+
+		std::cout << p.name << "," << t.calls << "," << std::fixed << std::setprecision(2) << t.ns_min << "," << t.ns_median << ","
+			<< std::setprecision(1) << t.cycles_min << "," << t.cycles_median << "," << checksum << std::endl;
+	}
+
+	delete eval;
+	for (BenchPosition& bp : positions) {
+		delete bp.pos;
+	}
+
+	return 0;
+}
@@ -17,6 +17,11 @@
 */
 #include "misc.h"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 
 
 // I have lost the original link to the source of this function, but I have it from Vice.
@@ -90,4 +95,72 @@ void ReadInput(bool& isStop, bool& isQuit) {
 		}
 		return;
 	}
-}
\ No newline at end of file
+}
+
+
+
+void run_parallel(int threads, const std::function<void(int)>& work, const std::function<void()>& poll) {
+	std::atomic<int> running{ threads };
+	std::vector<std::thread> workers;
+
+	for (int id = 0; id < threads; id++) {
+		workers.push_back(std::thread([&, id]() {
+			work(id);
+			running--;
+		}));
+	}
+
+	// The last poll is after all threads are done, so it sees all of their work.
+	bool done = false;
+	while (!done) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		done = running.load() == 0;
+
+		if (poll) {
+			poll();
+		}
+	}
+
+	for (auto& w : workers) {
+		w.join();
+	}
+}
+
+
+void run_ordered(size_t count, int threads, const std::function<void(int, size_t)>& work, const std::function<void(size_t)>& report,
+	const std::function<void()>& poll) {
+	std::atomic<size_t> next{ 0 };
+	std::vector<bool> finished(count, false);
+	std::mutex finished_mutex;
+	size_t reported = 0;
+
+	auto worker = [&](int id) {
+		for (size_t i = next++; i < count; i = next++) {
+			work(id, i);
+
+			std::lock_guard<std::mutex> lock(finished_mutex);
+			finished[i] = true;
+		}
+	};
+
+	// The results are reported without holding the lock, so the threads don't wait for the printing.
+	auto report_finished = [&]() {
+		size_t last = reported;
+		{
+			std::lock_guard<std::mutex> lock(finished_mutex);
+			while (last < count && finished[last]) {
+				last++;
+			}
+		}
+
+		for (; reported < last; reported++) {
+			report(reported);
+		}
+
+		if (poll) {
+			poll();
+		}
+	};
+
+	run_parallel(threads, worker, report_finished);
+}
@@ -20,6 +20,7 @@
 
 #include <stdio.h>
 #include <chrono>
+#include <functional>
 #include <iostream>
 #include <sstream>
 
@@ -52,6 +53,22 @@ inline long long getTimeMs() {
 }
 
 
+/*
+
+Helpers for the commands that spread their work over several threads. The calling thread doesn't do any of the work, but waits for the others and
+calls poll every 20 milliseconds, and once more after they are all done.
+
+*/
+
+// Runs work(id) on the threads, where id is from 0 to threads - 1.
+void run_parallel(int threads, const std::function<void(int)>& work, const std::function<void()>& poll);
+
+// Runs work(id, index) for every index below count. The threads take the next index from a shared counter, and report(index) is called on the
+//	calling thread for the finished indices in increasing order, so the results can be printed in the order of the input.
+void run_ordered(size_t count, int threads, const std::function<void(int, size_t)>& work, const std::function<void(size_t)>& report,
+	const std::function<void()>& poll = nullptr);
+
+
 
 
 #endif // ifndef MISC_H
\ No newline at end of file
@@ -29,9 +29,10 @@
 	CASTLE: All castling moves.
 	ALL: All pseudo-legal moves in the position.
 	EVASIONS: If we're in check, we'll only generate the legal check evasion moves
+	QUIET_CHECKS: All moves that give check without capturing or promoting (castling excluded). Used in the first ply of quiescence search.
 
 */
-enum MoveType :int { CAPTURES = 0, QUIET = 1, CASTLE = 2, ALL = 3};
+enum MoveType :int { CAPTURES = 0, QUIET = 1, CASTLE = 2, ALL = 3, EVASIONS = 4, QUIET_CHECKS = 5 };
 
 /*
 With these commands we can get information about a Move_t.move.
@@ -42,9 +43,11 @@ enum SpecialMoves :int { PROMOTION = 0, ENPASSANT = 1, CASTLING = 2, NOT_SPECIAL
 #define PROMTO(m) (((m) >> (2)) & (3))
 #define SPECIAL(m) ((m) & (3))
 
+// Move_t deliberately has no default member initializers: every MoveList holds MAXPOSITIONMOVES of them, and these would otherwise all be
+// written on construction of the list in every node.
 struct Move_t {
-	unsigned int move = NOMOVE;
-	int score = 0;
+	unsigned int move;
+	int score;
 };
 
 // The moveList class is inspired a lot by Stockfish
@@ -66,6 +69,11 @@ public:
 		last = moveList;
 	}
 
+	// Keeps only the first n moves.
+	void resize(size_t n) {
+		last = moveList + n;
+	}
+
 	bool contains(unsigned int move);
 private:
 	Move_t moveList[MAXPOSITIONMOVES];
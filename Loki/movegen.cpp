@@ -478,7 +478,7 @@ namespace moveGen {
 
 	
 	template <MoveType type, SIDE me>
-	void generate_all(GameState_t* pos, MoveList* move_list) {		
+	TARGET_CLONES void generate_all(GameState_t* pos, MoveList* move_list) {		
 		generate_pawn_moves<type, me>(pos, move_list);
 		generate_knight_moves<type, me>(pos, move_list);
 
@@ -494,19 +494,312 @@ namespace moveGen {
 
 
 
+	/// <summary>
+	/// Add pawn moves to all the squares in a bitboard. The moves reaching the last rank are split into the four promotions.
+	/// </summary>
+	/// <param name="to_squares">The destination squares.</param>
+	/// <param name="origin">The difference between the destination and origin square of the moves.</param>
+	/// <param name="move_list">The list to add the moves to.</param>
+	template<SIDE me>
+	void add_pawn_moves(Bitboard to_squares, int origin, MoveList* move_list) {
+		constexpr Bitboard LastRank = (me == WHITE) ? BBS::RankMasks8[RANK_8] : BBS::RankMasks8[RANK_1];
+
+		while (to_squares) {
+			int index = PopBit(&to_squares);
+
+			if ((uint64_t(1) << index) & LastRank) {
+				move_list->add_move(index, index - origin, 0, PROMOTION);
+				move_list->add_move(index, index - origin, 1, PROMOTION);
+				move_list->add_move(index, index - origin, 2, PROMOTION);
+				move_list->add_move(index, index - origin, 3, PROMOTION);
+			}
+			else {
+				move_list->add_move(index, index - origin, 0, NOT_SPECIAL);
+			}
+		}
+	}
+
+
+	/// <summary>
+	/// Generate the check evasions. These are the king moves to squares that aren't attacked and, if there is only one checker, the captures of it
+	/// and the interpositions between it and the king. Pinned pieces are left out since they can never resolve a check. The only illegal moves this
+	/// can leave in the list are en-passant captures exposing the king along the rank, which make_move will reject.
+	/// </summary>
+	/// <param name="pos">The position, in which the side to move is in check.</param>
+	/// <param name="move_list">The list to add the moves to.</param>
+	template<SIDE me>
+	TARGET_CLONES void generate_evasions(GameState_t* pos, MoveList* move_list) {
+		constexpr SIDE Them = (me == WHITE) ? BLACK : WHITE;
+		constexpr DIRECTION Up = (me == WHITE) ? NORTH : SOUTH;
+		constexpr DIRECTION upLeft = (me == WHITE) ? NORTHWEST : SOUTHWEST;
+		constexpr DIRECTION upRight = (me == WHITE) ? NORTHEAST : SOUTHEAST;
+		constexpr int up_origin = (me == WHITE) ? 8 : -8;
+		constexpr int right_attack_origin = (me == WHITE) ? 9 : -7;
+		constexpr int left_attack_origin = (me == WHITE) ? 7 : -9;
+		constexpr Bitboard RankThree = (me == WHITE) ? BBS::RankMasks8[RANK_3] : BBS::RankMasks8[RANK_6];
+
+		int king_sq = pos->king_squares[me];
+		Bitboard occupied = pos->all_pieces[WHITE] | pos->all_pieces[BLACK];
+		Bitboard checkers = pos->attackers_to(king_sq, occupied) & pos->all_pieces[Them];
+
+		assert(checkers != 0);
+
+		// Step 1. King moves. The king is removed from the occupancy, so it can't step backwards along the ray of a checking slider.
+		Bitboard without_king = occupied ^ (uint64_t(1) << king_sq);
+		Bitboard king_moves = BBS::king_attacks[king_sq] & ~pos->all_pieces[me];
+
+		while (king_moves) {
+			int sq = PopBit(&king_moves);
+
+			if ((pos->attackers_to(sq, without_king) & pos->all_pieces[Them]) == 0) {
+				move_list->add_move(sq, king_sq, 0, NOT_SPECIAL);
+			}
+		}
+
+		// Step 2. In a double check, only the king can move.
+		if (countBits(checkers) > 1) {
+			return;
+		}
+
+		// Step 3. Otherwise we can capture the checker or block its path to the king.
+		int checker_sq = bitScanForward(checkers);
+		Bitboard target = checkers | BBS::between_squares[king_sq][checker_sq];
+		Bitboard pinned = pos->pinned_pieces<me>();
+
+		// Step 4. Pawn pushes, captures and en-passant.
+		Bitboard pawns = pos->pieceBBS[PAWN][me] & ~pinned;
+
+		Bitboard one_up = shift<Up>(pawns) & ~occupied;
+		Bitboard two_up = shift<Up>(one_up & RankThree) & ~occupied & target;
+
+		add_pawn_moves<me>(one_up & target, up_origin, move_list);
+		add_pawn_moves<me>(shift<upLeft>(pawns) & checkers, left_attack_origin, move_list);
+		add_pawn_moves<me>(shift<upRight>(pawns) & checkers, right_attack_origin, move_list);
+
+		while (two_up) {
+			int index = PopBit(&two_up);
+
+			move_list->add_move(index, index - 2 * up_origin, 0, NOT_SPECIAL);
+		}
+
+		// En-passant can only evade the check if the pawn that just moved two squares is the checker.
+		if (pos->enPasSq != NO_SQ && checker_sq == pos->enPasSq - up_origin) {
+			Bitboard epBrd = uint64_t(1) << pos->enPasSq;
+
+			if (shift<upLeft>(pawns) & epBrd) {
+				move_list->add_move(pos->enPasSq, pos->enPasSq - left_attack_origin, 0, ENPASSANT);
+			}
+			if (shift<upRight>(pawns) & epBrd) {
+				move_list->add_move(pos->enPasSq, pos->enPasSq - right_attack_origin, 0, ENPASSANT);
+			}
+		}
+
+		// Step 5. Knights and sliders.
+		Bitboard pieces = pos->pieceBBS[KNIGHT][me] & ~pinned;
+		Bitboard attacks = 0;
+
+		while (pieces) {
+			int sq = PopBit(&pieces);
+			attacks = BBS::knight_attacks[sq] & target;
+
+			while (attacks) {
+				move_list->add_move(PopBit(&attacks), sq, 0, NOT_SPECIAL);
+			}
+		}
+
+		pieces = (pos->pieceBBS[BISHOP][me] | pos->pieceBBS[QUEEN][me]) & ~pinned;
+		while (pieces) {
+			int sq = PopBit(&pieces);
+			attacks = Magics::attacks_bb<BISHOP>(sq, occupied) & target;
+
+			// The queen's rook moves are added below.
+			while (attacks) {
+				move_list->add_move(PopBit(&attacks), sq, 0, NOT_SPECIAL);
+			}
+		}
+
+		pieces = (pos->pieceBBS[ROOK][me] | pos->pieceBBS[QUEEN][me]) & ~pinned;
+		while (pieces) {
+			int sq = PopBit(&pieces);
+			attacks = Magics::attacks_bb<ROOK>(sq, occupied) & target;
+
+			while (attacks) {
+				move_list->add_move(PopBit(&attacks), sq, 0, NOT_SPECIAL);
+			}
+		}
+	}
+
+
+	/// <summary>
+	/// Add the quiet checks of one piece type. A move gives check if it lands on one of the piece type's checking squares, or if the piece is a
+	/// discoverer and it leaves the line between the opponent's king and our slider behind it.
+	/// </summary>
+	/// <param name="pos">The position.</param>
+	/// <param name="check_squares">The squares from which this piece type attacks the opponent's king.</param>
+	/// <param name="discoverers">Our pieces that are the only blocker between the opponent's king and one of our sliders.</param>
+	/// <param name="lines">For each discoverer, the line it has to leave to discover the check.</param>
+	/// <param name="move_list">The list to add the moves to.</param>
+	template<piece pce, SIDE me>
+	void add_quiet_checks(GameState_t* pos, Bitboard check_squares, Bitboard discoverers, const Bitboard* lines, MoveList* move_list) {
+		Bitboard occupied = pos->all_pieces[WHITE] | pos->all_pieces[BLACK];
+		Bitboard pieces = pos->pieceBBS[pce][me];
+
+		while (pieces) {
+			int sq = PopBit(&pieces);
+
+			Bitboard attacks = 0;
+			if constexpr (pce == KNIGHT) {
+				attacks = BBS::knight_attacks[sq];
+			}
+			else if constexpr (pce == KING) {
+				attacks = BBS::king_attacks[sq];
+			}
+			else {
+				attacks = Magics::attacks_bb<pce>(sq, occupied);
+			}
+
+			Bitboard gives_check = check_squares;
+
+			if (discoverers & (uint64_t(1) << sq)) {
+				gives_check |= ~lines[sq];
+			}
+
+			attacks &= ~occupied & gives_check;
+
+			while (attacks) {
+				move_list->add_move(PopBit(&attacks), sq, 0, NOT_SPECIAL);
+			}
+		}
+	}
+
+
+	/// <summary>
+	/// Generate all quiet moves that give check, either directly or by discovering an attack from a slider. Promotions are generated as captures,
+	/// and castling is left out since castling checks are very rare.
+	/// </summary>
+	/// <param name="pos">The position, in which the side to move isn't in check.</param>
+	/// <param name="move_list">The list to add the moves to.</param>
+	template<SIDE me>
+	TARGET_CLONES void generate_quiet_checks(GameState_t* pos, MoveList* move_list) {
+		constexpr SIDE Them = (me == WHITE) ? BLACK : WHITE;
+		constexpr DIRECTION themLeft = (me == WHITE) ? SOUTHWEST : NORTHWEST;
+		constexpr DIRECTION themRight = (me == WHITE) ? SOUTHEAST : NORTHEAST;
+		constexpr int up_origin = (me == WHITE) ? 8 : -8;
+		constexpr Bitboard RankTwo = (me == WHITE) ? BBS::RankMasks8[RANK_2] : BBS::RankMasks8[RANK_7];
+		constexpr Bitboard LastRank = (me == WHITE) ? BBS::RankMasks8[RANK_8] : BBS::RankMasks8[RANK_1];
+
+		int king_sq = pos->king_squares[Them];
+		Bitboard king_brd = uint64_t(1) << king_sq;
+		Bitboard occupied = pos->all_pieces[WHITE] | pos->all_pieces[BLACK];
+
+		// Step 1. Find the discoverers. These are our pieces that are the only blocker between the opponent's king and one of our sliders.
+		Bitboard snipers = (Magics::attacks_bb<BISHOP>(king_sq, 0) & (pos->pieceBBS[BISHOP][me] | pos->pieceBBS[QUEEN][me]))
+			| (Magics::attacks_bb<ROOK>(king_sq, 0) & (pos->pieceBBS[ROOK][me] | pos->pieceBBS[QUEEN][me]));
+
+		Bitboard discoverers = 0;
+		Bitboard lines[64];
+
+		while (snipers) {
+			int sniper_sq = PopBit(&snipers);
+			Bitboard blockers = BBS::between_squares[king_sq][sniper_sq] & occupied;
+
+			if (blockers != 0 && countBits(blockers) == 1 && (blockers & pos->all_pieces[me])) {
+				discoverers |= blockers;
+				lines[bitScanForward(blockers)] = BBS::between_squares[king_sq][sniper_sq];
+			}
+		}
+
+		// Step 2. Pawn pushes. The squares a pawn gives check from are the ones an opponent pawn on the king's square would attack.
+		Bitboard pawn_checks = shift<themLeft>(king_brd) | shift<themRight>(king_brd);
+		Bitboard pawns = pos->pieceBBS[PAWN][me];
+
+		while (pawns) {
+			int sq = PopBit(&pawns);
+			Bitboard gives_check = pawn_checks;
+
+			if (discoverers & (uint64_t(1) << sq)) {
+				gives_check |= ~lines[sq];
+			}
+
+			int one_up = sq + up_origin;
+			if ((occupied & (uint64_t(1) << one_up)) || (LastRank & (uint64_t(1) << one_up))) {
+				continue;
+			}
+
+			if (gives_check & (uint64_t(1) << one_up)) {
+				move_list->add_move(one_up, sq, 0, NOT_SPECIAL);
+			}
+
+			int two_up = one_up + up_origin;
+			if ((RankTwo & (uint64_t(1) << sq)) && !(occupied & (uint64_t(1) << two_up)) && (gives_check & (uint64_t(1) << two_up))) {
+				move_list->add_move(two_up, sq, 0, NOT_SPECIAL);
+			}
+		}
+
+		// Step 3. The pieces. The king can only give discovered checks.
+		Bitboard bishop_checks = Magics::attacks_bb<BISHOP>(king_sq, occupied);
+		Bitboard rook_checks = Magics::attacks_bb<ROOK>(king_sq, occupied);
+
+		add_quiet_checks<KNIGHT, me>(pos, BBS::knight_attacks[king_sq], discoverers, lines, move_list);
+		add_quiet_checks<BISHOP, me>(pos, bishop_checks, discoverers, lines, move_list);
+		add_quiet_checks<ROOK, me>(pos, rook_checks, discoverers, lines, move_list);
+		add_quiet_checks<QUEEN, me>(pos, bishop_checks | rook_checks, discoverers, lines, move_list);
+		add_quiet_checks<KING, me>(pos, 0, discoverers, lines, move_list);
+	}
+
+
+
+
 	bool moveExists(GameState_t* pos, unsigned int move) {
 		MoveList ml;
 
 		if (pos->side_to_move == WHITE) { generate_all<ALL, WHITE>(pos, &ml); }
 		else { generate_all<ALL, BLACK>(pos, &ml); }
 
-		for (int i = 0; i < ml.size(); i++) {
+		for (int i = 0; i < int(ml.size()); i++) {
 			if (ml[i]->move == move) {
 				return true;
 			}
 		}
 		return false;
 	}
+
+
+	std::vector<unsigned int> legal_moves(GameState_t* pos) {
+		std::vector<unsigned int> legal;
+
+		MoveList ml;
+
+		if (pos->side_to_move == WHITE) { generate_all<ALL, WHITE>(pos, &ml); }
+		else { generate_all<ALL, BLACK>(pos, &ml); }
+
+		for (int i = 0; i < int(ml.size()); i++) {
+			if (!pos->make_move(ml[i])) {
+				continue;
+			}
+			pos->undo_move();
+			legal.push_back(ml[i]->move);
+		}
+
+		return legal;
+	}
+
+
+	bool has_legal_move(GameState_t* pos) {
+		MoveList ml;
+
+		if (pos->side_to_move == WHITE) { generate_all<ALL, WHITE>(pos, &ml); }
+		else { generate_all<ALL, BLACK>(pos, &ml); }
+
+		for (int i = 0; i < int(ml.size()); i++) {
+			if (pos->make_move(ml[i])) {
+				pos->undo_move();
+				return true;
+			}
+		}
+
+		return false;
+	}
 };
 
 template<MoveType T>
@@ -561,4 +854,30 @@ void moveGen::generate<QUIET>(GameState_t* pos, MoveList* move_list) {
 	else {
 		generate_all<QUIET, BLACK>(pos, move_list);
 	}
+}
+
+
+template<>
+void moveGen::generate<EVASIONS>(GameState_t* pos, MoveList* move_list) {
+	SIDE me = pos->side_to_move;
+
+	if (me == WHITE) {
+		generate_evasions<WHITE>(pos, move_list);
+	}
+	else {
+		generate_evasions<BLACK>(pos, move_list);
+	}
+}
+
+
+template<>
+void moveGen::generate<QUIET_CHECKS>(GameState_t* pos, MoveList* move_list) {
+	SIDE me = pos->side_to_move;
+
+	if (me == WHITE) {
+		generate_quiet_checks<WHITE>(pos, move_list);
+	}
+	else {
+		generate_quiet_checks<BLACK>(pos, move_list);
+	}
 }
\ No newline at end of file
@@ -19,6 +19,8 @@
 #define MOVEGEN_H
 #include "position.h"
 
+#include <vector>
+
 
 namespace moveGen {
 
@@ -27,6 +29,12 @@ namespace moveGen {
 
 	// Checks if the move exists for the current position
 	bool moveExists(GameState_t* pos, unsigned int move);
+
+	// The legal moves of the position.
+	std::vector<unsigned int> legal_moves(GameState_t* pos);
+
+	// Checks if the side to move has a legal move, i.e. that it isn't checkmated or stalemated.
+	bool has_legal_move(GameState_t* pos);
 }
 
 
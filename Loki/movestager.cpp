@@ -17,6 +17,8 @@
 */
 #include "movestager.h"
 
+#include <limits>
+
 
 
 /// <summary>
@@ -24,11 +26,22 @@
 /// </summary>
 /// <param name="_pos">A position object that we'll store in order to generate the moves.</param>
 /// <param name="stats">The previously generated stats on different kinds of (mostly quiet) moves.</param>
+/// <param name="_stack">The search stack entry of the current ply. Holds the killer moves.</param>
 /// <param name="ttMove">A move from the transposition table.</param>
 /// <param name="in_check">A flag signalling if we're in check or not.</param>
-MoveStager::MoveStager(GameState_t* _pos, MoveStats_t* _stats, unsigned int ttMove, bool in_check) {
+/// <param name="_depth">The remaining depth of the node.</param>
+MoveStager::MoveStager(GameState_t* _pos, MoveStats_t* _stats, const SearchStack_t* _stack, unsigned int ttMove, bool _in_check, int _depth) {
 	pos = _pos;
 	stats = _stats;
+	stack = _stack;
+	depth = _depth;
+	in_check = _in_check;
+
+	// The countermove is the move that last refuted the opponent's previous move.
+	unsigned int previous_move = (stack - 1)->current_move;
+	if (previous_move != NOMOVE && previous_move != MOVE_NULL) {
+		counter_move = stats->counterMoves[FROMSQ(previous_move)][TOSQ(previous_move)];
+	}
 
 	// If there is a move from the transposition table, set stage to tt stage, otherwise to capture stage.
 	tt_move = ttMove;
@@ -38,24 +51,29 @@ MoveStager::MoveStager(GameState_t* _pos, MoveStats_t* _stats, unsigned int ttMo
 		// Since there is a risk of key collisions, we need to check that the tt move is at least pseudo-legal.
 		// If the move isn't pseudo-legal set a new stage.
 		if (!is_pseudo_legal(pos, tt_move, in_check)) {
-			stage = CAPTURE_SCORE_STAGE;
+			stage = (in_check) ? EVASION_SCORE_STAGE : CAPTURE_SCORE_STAGE;
 			tt_move = NOMOVE;
 		}
 	}
 	else {
-		stage = CAPTURE_SCORE_STAGE;
+		stage = (in_check) ? EVASION_SCORE_STAGE : CAPTURE_SCORE_STAGE;
 	}
 }
 
 
 /// <summary>
-/// A constructor for use in quiescence search. The movestats are excluded since we wont be using them in quiescence where only captures are searched.
+/// A constructor for use in quiescence search. The movestats are excluded since we wont be using them in quiescence where only captures and
+/// checks are searched.
 /// </summary>
 /// <param name="_pos">A position object to use for generating moves.</param>
-MoveStager::MoveStager(GameState_t* _pos) {
+/// <param name="_in_check">A flag signalling if we're in check or not. If we are, only the evasions are generated.</param>
+/// <param name="_quiet_checks">A flag signalling if the quiet checks should be generated after the captures.</param>
+MoveStager::MoveStager(GameState_t* _pos, bool _in_check, bool _quiet_checks) {
 	pos = _pos;
+	in_check = _in_check;
+	quiet_checks = _quiet_checks;
 
-	stage = CAPTURE_SCORE_STAGE;
+	stage = (in_check) ? EVASION_SCORE_STAGE : CAPTURE_SCORE_STAGE;
 }
 
 
@@ -68,6 +86,7 @@ MoveStager::MoveStager() {
 
 	pos = nullptr;
 	stats = nullptr;
+	stack = nullptr;
 
 	tt_move = NOMOVE;
 }
@@ -78,10 +97,12 @@ MoveStager::MoveStager() {
 /// </summary>
 /// <param name="_pos">The position object.</param>
 /// <param name="_stats">The previously generated stats for (mostly quiet) moves.</param>
+/// <param name="_stack">The search stack entry of the root.</param>
 /// <param name="ttMove">The move from the transposition table.</param>
-RootMoveStager::RootMoveStager(GameState_t* _pos, MoveStats_t* _stats, unsigned int ttMove) {
+RootMoveStager::RootMoveStager(GameState_t* _pos, MoveStats_t* _stats, const SearchStack_t* _stack, unsigned int ttMove, const std::vector<unsigned int>& root_moves) {
 	pos = _pos;
 	stats = _stats;
+	stack = _stack;
 	current_move = 0;
 
 	tt_move = ttMove;
@@ -90,12 +111,27 @@ RootMoveStager::RootMoveStager(GameState_t* _pos, MoveStats_t* _stats, unsigned
 	score<CAPTURES>(true);
 	score<QUIET>(true);
 
+	// If the tablebases have ranked the root moves, drop the ones that don't keep the best result.
+	if (!root_moves.empty()) {
+		int kept = 0;
+
+		for (int i = 0; i < ml.size(); i++) {
+			if (std::find(root_moves.begin(), root_moves.end(), ml[i]->move) != root_moves.end()) {
+				ml.replace(kept++, *ml[i]);
+			}
+		}
+		ml.resize(kept);
+	}
+
 	// If the movelist contains the tt-move, score it accordingly.
 	if (tt_move != NOMOVE) {
 		for (int i = 0; i < ml.size(); i++) {
 			if (ml[i]->move == tt_move) { ml[i]->score = hash_move_sort; break; }
 		}
 	}
+
+	// Sort all the moves once.
+	partial_insertion_sort(ml.begin(), ml.end(), std::numeric_limits<int>::min());
 }
 
 
@@ -117,84 +153,162 @@ top:
 		move.move = tt_move;
 		move.score = hash_move_sort;
 
-		stage++;
+		stage = (in_check) ? EVASION_SCORE_STAGE : CAPTURE_SCORE_STAGE;
 		return true;
 
 	case CAPTURE_SCORE_STAGE:
-		// Score and generate the captures.
+		// Score and generate the captures. There are few of them, so they're all sorted.
 		score<CAPTURES>();
+		partial_insertion_sort(ml.begin(), ml.end(), std::numeric_limits<int>::min());
 		current_move = 0;
+		capture_end = ml.size();
 
-		// If there are no captures, go to the quiet score stage.
-		if (ml.size() == 0) {
-			stage = QUIET_SCORE_STAGE;
-			goto top;
+		// Set the new flag and fallthrough.
+		stage++;
+		[[fallthrough]];
+
+	case GOOD_CAPTURE_STAGE:
+		// Step 1. The captures are sorted, so the first one with a negative score marks the beginning of the losing captures.
+		while (current_move < capture_end && ml[current_move]->score >= 0) {
+			move = *ml[current_move++];
+
+			// Step 2. If the move we found was the TT move, we don't want to search it. Find another one.
+			if (move.move != tt_move) {
+				return true;
+			}
 		}
 
-		// Set the new flag and fallthrough.
+		// Step 3. Save the start of the losing captures for the last stage.
+		bad_capture = current_move;
+
 		stage++;
 		[[fallthrough]];
 
-	case CAPTURE_STAGE:
-		// Step 1. Find the best move and insert it.
-		pi_sort();
-		move.move = ml[current_move]->move;
-		move.score = ml[current_move]->score;
+	case KILLER_ONE_STAGE:
+	case KILLER_TWO_STAGE:
+		// If we should skip the quiets, go directly to the losing captures.
+		if (skip_quiets) {
+			stage = BAD_CAPTURE_STAGE;
+			current_move = bad_capture;
+			goto top;
+		}
 
-		// Step 2. Now increment the current move and if it turns out we don't have any more moves, increment the stage too.
-		current_move++;
+		// Try the killer move before generating quiets, since it often refutes the position without having to generate anything else.
+		move.move = stack->killers[stage - KILLER_ONE_STAGE];
+		move.score = (stage == KILLER_ONE_STAGE) ? first_killer : second_killer;
+		stage++;
 
-		if (current_move >= ml.size()) {
-			stage++;
+		if (move.move != tt_move && valid_quiet(move.move)) {
+			return true;
 		}
+		goto top;
+
+	case COUNTER_STAGE:
+		stage++;
 
-		// Step 3. If the move we found was the TT move, we don't want to search it. Find another one.
-		if (move.move == tt_move) {
+		if (skip_quiets) {
 			goto top;
 		}
 
-		return true;
+		move.move = counter_move;
+		move.score = countermove_bonus;
+
+		if (move.move != tt_move && move.move != stack->killers[0] && move.move != stack->killers[1] && valid_quiet(move.move)) {
+			return true;
+		}
+		[[fallthrough]];
 
 	case QUIET_SCORE_STAGE:
-		// If we should skip the quiets, return false since there are no moves after these.
+		// If we should skip the quiets, go directly to the losing captures.
 		if (skip_quiets) {
-			return false;
+			stage = BAD_CAPTURE_STAGE;
+			current_move = bad_capture;
+			goto top;
 		}
 		
-		// Score and generate the quiet moves.
+		// Score and generate the quiet moves. Only the ones with a reasonable score are sorted.
 		score<QUIET>();
-
-		// If there are no quiets, return false.
-		if (current_move >= ml.size()) { return false; }
+		partial_insertion_sort(ml.begin() + capture_end, ml.end(), quiet_sort_limit * depth);
+		current_move = capture_end;
 
 		// Increment stage and fallthrough.
-		stage++;
+		stage = QUIET_STAGE;
 		[[fallthrough]];
 
 	case QUIET_STAGE:
-		// If we should skip the quiets, return false since there are no moves after these.
-		if (skip_quiets) {
+		// Step 1. The quiets are sorted (apart from the tail), so take the next one. The tt-move, killers and countermove have already been searched.
+		while (!skip_quiets && current_move < ml.size()) {
+			move = *ml[current_move++];
+
+			if (!is_refutation(move.move)) {
+				return true;
+			}
+		}
+
+		// Step 2. Continue to the losing captures.
+		current_move = bad_capture;
+
+		stage++;
+		[[fallthrough]];
+
+	case BAD_CAPTURE_STAGE:
+		while (current_move < capture_end) {
+			move = *ml[current_move++];
+
+			if (move.move != tt_move) {
+				return true;
+			}
+		}
+
+		// In the first ply of quiescence search we continue with the quiet checks.
+		if (!quiet_checks) {
+			stage = NO_STAGE;
 			return false;
 		}
 
-		// Step 1. Find the best move and insert it.
-		pi_sort();
-		move.move = ml[current_move]->move;
-		move.score = ml[current_move]->score;
+		stage++;
+		[[fallthrough]];
+
+	case QUIET_CHECK_GENERATE_STAGE:
+		// The quiet checks are added after the captures. They aren't scored, since there usually are only a few of them.
+		moveGen::generate<QUIET_CHECKS>(pos, &ml);
+		current_move = capture_end;
 
-		// Step 2. Increment the current move and if we don't have any more moves, increment the stage flag too.
-		current_move++;
+		stage++;
+		[[fallthrough]];
 
-		if (current_move >= ml.size()) {
-			stage++;
+	case QUIET_CHECK_STAGE:
+		while (current_move < ml.size()) {
+			move = *ml[current_move++];
+
+			if (move.move != tt_move) {
+				return true;
+			}
 		}
 
-		// Step 3. If the move we found was the TT move, we don't want to search it. Find another one.
-		if (move.move == tt_move) {
-			goto top;
+		stage = NO_STAGE;
+		return false;
+
+	case EVASION_SCORE_STAGE:
+		// When in check, the evasions are the only moves generated. There are few of them, so they're all sorted.
+		score<EVASIONS>();
+		partial_insertion_sort(ml.begin(), ml.end(), std::numeric_limits<int>::min());
+		current_move = 0;
+
+		stage++;
+		[[fallthrough]];
+
+	case EVASION_STAGE:
+		while (current_move < ml.size()) {
+			move = *ml[current_move++];
+
+			if (move.move != tt_move) {
+				return true;
+			}
 		}
 
-		return true;
+		stage = NO_STAGE;
+		return false;
 
 	case NO_STAGE:
 		return false;
@@ -219,8 +333,7 @@ bool RootMoveStager::next_move(Move_t& move) {
 		return false;
 	}
 
-	// Step 1. Find the highest sorted move and set it.
-	pi_sort();
+	// Step 1. The moves were sorted on construction, so just take the next one.
 	move.move = ml[current_move]->move;
 	move.score = ml[current_move]->score;
 	current_move++;
@@ -231,32 +344,31 @@ bool RootMoveStager::next_move(Move_t& move) {
 
 
 /// <summary>
-/// Finds the best move in front of the current index in the movelist array and inserts it there.
+/// Determine if a move is one of the moves tried before the quiet moves were generated.
 /// </summary>
-void MoveStager::pi_sort() {
-	int best_index = current_move;
-	int best_score = -hash_move_sort;
-
-	for (int m = current_move; m < ml.size(); m++) {
+/// <param name="move">The move to check.</param>
+/// <returns>True if the move is the tt-move, a killer or the countermove.</returns>
+bool MoveStager::is_refutation(unsigned int move) const {
+	return move == tt_move || move == stack->killers[0] || move == stack->killers[1] || move == counter_move;
+}
 
-		// If the score for (*ml)[m] is higher than the maximum score we've found, this is the new best move.
-		if (ml[m]->score > best_score) {
-			best_index = m;
 
-			best_score = ml[m]->score;
-		}
-	}
-	// Copy the move at index and at best_index
-	Move_t temp_move = ml.at(current_move);
-	Move_t best_move = ml.at(best_index);
+/// <summary>
+/// Determine if a killer- or countermove can be played as a quiet move in the current position. These come from other positions, so they have
+/// to be validated before being searched.
+/// </summary>
+/// <param name="move">The move to check.</param>
+/// <returns>True if the move is a pseudo-legal quiet move.</returns>
+bool MoveStager::valid_quiet(unsigned int move) const {
+	SIDE Them = (pos->side_to_move == WHITE) ? BLACK : WHITE;
 
-	// Insert best_move at index and place temp_move (the previous move at index) at best_index.
-	ml.replace(current_move, best_move);
-	ml.replace(best_index, temp_move);
+	return move != NOMOVE
+		&& SPECIAL(move) != PROMOTION && SPECIAL(move) != ENPASSANT
+		&& pos->piece_list[Them][TOSQ(move)] == NO_TYPE
+		&& is_pseudo_legal(pos, move, in_check);
 }
 
 
-
 /// <summary>
 /// Get the moves that has been played.
 /// </summary>
@@ -267,8 +379,8 @@ MoveList* MoveStager::get_moves() {
 
 
 /// <summary>
-/// Determine whether a move is pseudo-legal or not. This method is used to check the TT move in MoveStager since some illegal moves may cause a crash.
-/// It can also be used for killers at a later point.
+/// Determine whether a move is pseudo-legal or not. This method is used to check the TT move, killers and countermoves in MoveStager since some
+/// illegal moves may cause a crash.
 /// </summary>
 /// <param name="pos">: The position object.</param>
 /// <param name="move">: The encoded move.</param>
@@ -323,11 +435,13 @@ bool is_pseudo_legal(GameState_t* pos, unsigned int move, bool in_check) {
 		is_capture = ((Us == WHITE) ? (to_sq == from_sq + 9 || to_sq == from_sq + 7) : (to_sq == from_sq - 9 || to_sq == from_sq - 7))
 			&& (pos->all_pieces[Them] & (uint64_t(1) << to_sq)) != 0;
 
-		single_push = (Us == WHITE) ? to_sq == from_sq + 8 : to_sq == from_sq - 8;
+		single_push = ((Us == WHITE) ? to_sq == from_sq + 8 : to_sq == from_sq - 8)
+			&& piece_captured == NO_TYPE;
 
 		double_push = ((Us == WHITE) ? (to_sq == from_sq + 16 && (BBS::RankMasks8[RANK_2] & (uint64_t(1) << from_sq)) != 0)
 			: (to_sq == from_sq - 16 && (BBS::RankMasks8[RANK_7] & (uint64_t(1) << from_sq)) != 0))
-			&& ((pos->all_pieces[WHITE] | pos->all_pieces[BLACK]) & (uint64_t(1) << (Us == WHITE ? from_sq + 8 : from_sq - 8))) == 0;
+			&& (occupied & (uint64_t(1) << (Us == WHITE ? from_sq + 8 : from_sq - 8))) == 0
+			&& (occupied & (uint64_t(1) << to_sq)) == 0;
 
 		if (!(is_capture || single_push || double_push)) {
 			return false;
@@ -362,7 +476,23 @@ bool is_pseudo_legal(GameState_t* pos, unsigned int move, bool in_check) {
 		}
 		break;
 
-	default:	/* There are no special considerations for kings or knights. */
+	/*
+	Kings and knights can't be blocked, but the move has to have the right shape. This matters for killers and countermoves, which were found
+	with another piece on the from-square.
+	*/
+	case KNIGHT:
+		if ((BBS::knight_attacks[from_sq] & (uint64_t(1) << to_sq)) == 0) {
+			return false;
+		}
+		break;
+
+	case KING:
+		if ((BBS::king_attacks[from_sq] & (uint64_t(1) << to_sq)) == 0) {
+			return false;
+		}
+		break;
+
+	default:
 		break;
 	}
 
@@ -19,14 +19,24 @@
 #define MOVESTAGER_H
 #include "thread.h"
 
-// This is all the stages we generate the moves in. In the future, it would be nice to split the captures.
+// This is all the stages we generate the moves in. The killers and the countermove are tried before the quiets are generated, and the losing
+// captures are searched after the quiets. In the first ply of quiescence search, the quiet checks are searched after the captures, and when in
+// check, only the evasions are generated.
 enum STAGE_T :int {
 	TT_STAGE = 0,
 	CAPTURE_SCORE_STAGE = 1,
-	CAPTURE_STAGE = 2,
-	QUIET_SCORE_STAGE = 3,
-	QUIET_STAGE = 4,
-	NO_STAGE = 5
+	GOOD_CAPTURE_STAGE = 2,
+	KILLER_ONE_STAGE = 3,
+	KILLER_TWO_STAGE = 4,
+	COUNTER_STAGE = 5,
+	QUIET_SCORE_STAGE = 6,
+	QUIET_STAGE = 7,
+	BAD_CAPTURE_STAGE = 8,
+	QUIET_CHECK_GENERATE_STAGE = 9,
+	QUIET_CHECK_STAGE = 10,
+	EVASION_SCORE_STAGE = 11,
+	EVASION_STAGE = 12,
+	NO_STAGE = 13
 };
 
 
@@ -38,8 +48,8 @@ bool is_pseudo_legal(GameState_t* pos, unsigned int move, bool in_check);
 class MoveStager {
 public:
 	MoveStager();
-	MoveStager(GameState_t* _pos, MoveStats_t* _stats, unsigned int ttMove, bool in_check); // For main search
-	MoveStager(GameState_t* _pos); // For quiescence search.
+	MoveStager(GameState_t* _pos, MoveStats_t* _stats, const SearchStack_t* _stack, unsigned int ttMove, bool in_check, int _depth); // For main search
+	MoveStager(GameState_t* _pos, bool _in_check, bool _quiet_checks); // For quiescence search.
 	
 	bool next_move(Move_t& move, bool skip_quiets = false);
 
@@ -54,17 +64,34 @@ protected:
 
 	GameState_t* pos = nullptr;
 	MoveStats_t* stats = nullptr;
+	const SearchStack_t* stack = nullptr;
 
 	unsigned int tt_move = NOMOVE;
+	unsigned int counter_move = NOMOVE;
 
-	void pi_sort();
+	bool in_check = false;
+
+	// Whether or not to generate the quiet checks after the captures.
+	bool quiet_checks = false;
+
+	// The captures are at [0, capture_end) of the movelist, with the losing ones starting at bad_capture.
+	int capture_end = 0;
+	int bad_capture = 0;
+
+	bool is_refutation(unsigned int move) const;
+	bool valid_quiet(unsigned int move) const;
+
+	inline int history_score(unsigned int move, const PieceToHistory* cont_one, const PieceToHistory* cont_two) const;
+
+	// The remaining depth of the node. Used to determine how many quiet moves are worth sorting.
+	int depth = 0;
 };
 
 
 
 class RootMoveStager : public MoveStager {
 public:
-	RootMoveStager(GameState_t* _pos, MoveStats_t* _stats, unsigned int ttMove);
+	RootMoveStager(GameState_t* _pos, MoveStats_t* _stats, const SearchStack_t* _stack, unsigned int ttMove, const std::vector<unsigned int>& root_moves);
 
 	bool next_move(Move_t& move);
 };
@@ -72,6 +99,52 @@ public:
 
 
 
+/// <summary>
+/// Sorts the moves in [begin, end) that score at least "limit" in descending order at the front of the range. The moves below the limit are
+/// left unsorted behind them, since these are rarely searched (or pruned by LMP) anyways.
+/// </summary>
+/// <param name="begin">Pointer to the first move.</param>
+/// <param name="end">Pointer one past the last move.</param>
+/// <param name="limit">The lowest score that gets sorted.</param>
+inline void partial_insertion_sort(Move_t* begin, Move_t* end, int limit) {
+
+	for (Move_t* sorted_end = begin, *p = begin + 1; p < end; p++) {
+		if (p->score >= limit) {
+			Move_t tmp = *p, *q;
+			*p = *++sorted_end;
+
+			for (q = sorted_end; q != begin && (q - 1)->score < tmp.score; q--) {
+				*q = *(q - 1);
+			}
+			*q = tmp;
+		}
+	}
+}
+
+
+// The quiet moves scoring below quiet_sort_limit * depth are not sorted.
+constexpr int quiet_sort_limit = -4000;
+
+
+/// <summary>
+/// The butterfly and continuation history score of a quiet move.
+/// </summary>
+/// <param name="move">The quiet move.</param>
+/// <param name="cont_one">The continuation history of the move one ply ago, or nullptr.</param>
+/// <param name="cont_two">The continuation history of the move two plies ago, or nullptr.</param>
+inline int MoveStager::history_score(unsigned int move, const PieceToHistory* cont_one, const PieceToHistory* cont_two) const {
+	int to_sq = TOSQ(move);
+	int pce = piece_index(pos->side_to_move, pos->piece_list[pos->side_to_move][FROMSQ(move)]);
+
+	int score = stats->history[pos->side_to_move][FROMSQ(move)][to_sq];
+
+	if (cont_one != nullptr) { score += (*cont_one)[pce][to_sq]; }
+	if (cont_two != nullptr) { score += (*cont_two)[pce][to_sq]; }
+
+	return score;
+}
+
+
 /// <summary>
 /// Method for generating and scoring all moves. The two templates are for captures and quiets separately.
 /// </summary>
@@ -81,24 +154,49 @@ void MoveStager::score(bool raise_captures) {
 	SIDE Them = (pos->side_to_move == WHITE) ? BLACK : WHITE;
 
 	if constexpr (T == QUIET) {
-		// Step 1. Generate all quiet moves.
+		// Step 1. Generate all quiet moves. These are added after the captures, which have already been scored.
+		int first_quiet = ml.size();
 		moveGen::generate<QUIET>(pos, &ml);
 
+		// The continuation histories of the moves one and two plies ago.
+		const PieceToHistory* cont_one = (stack - 1)->continuation_history;
+		const PieceToHistory* cont_two = (stack - 2)->continuation_history;
+
 		// Step 2. Loop through the moves while scoring them.
-		for (int i = 0; i < ml.size(); i++) {
+		for (int i = first_quiet; i < ml.size(); i++) {
 			ml[i]->score = 0;
 
 			// Step 2A. Killers (~79 elo).
-			if (ml[i]->move == stats->killers[pos->ply][0]) {
+			if (ml[i]->move == stack->killers[0]) {
 				ml[i]->score = first_killer;
 			}
-			else if (ml[i]->move == stats->killers[pos->ply][1]) {
+			else if (ml[i]->move == stack->killers[1]) {
 				ml[i]->score = second_killer;
 			}
 
-			// Step 2B. History (~243 elo).
+			// Step 2B. History (~243 elo) and continuation histories.
+			else {
+				ml[i]->score = history_score(ml[i]->move, cont_one, cont_two);
+			}
+		}
+	}
+	else if constexpr (T == EVASIONS) {
+		// Step 1. Generate the evasions. These are the only moves of the node.
+		moveGen::generate<EVASIONS>(pos, &ml);
+
+		const PieceToHistory* cont_one = (stats != nullptr) ? (stack - 1)->continuation_history : nullptr;
+		const PieceToHistory* cont_two = (stats != nullptr) ? (stack - 2)->continuation_history : nullptr;
+
+		// Step 2. Captures and promotions go first, ordered by MvvLva, and the quiet evasions are ordered by their history in the main search.
+		for (int i = 0; i < ml.size(); i++) {
+			int attacker = pos->piece_list[pos->side_to_move][FROMSQ(ml[i]->move)];
+			int captured = (SPECIAL(ml[i]->move) == ENPASSANT) ? PAWN : pos->piece_list[Them][TOSQ(ml[i]->move)];
+
+			if (captured != NO_TYPE || SPECIAL(ml[i]->move) == PROMOTION) {
+				ml[i]->score = 10000000 + MvvLva[attacker][(captured == NO_TYPE) ? PAWN : captured];
+			}
 			else {
-				ml[i]->score = stats->history[pos->side_to_move][FROMSQ(ml[i]->move)][TOSQ(ml[i]->move)];
+				ml[i]->score = (stats != nullptr) ? history_score(ml[i]->move, cont_one, cont_two) : 0;
 			}
 		}
 	}
@@ -106,31 +204,33 @@ void MoveStager::score(bool raise_captures) {
 		// Step 1. Generate the moves. We don't need to reset the list since these are the first moves to be generated.
 		moveGen::generate<CAPTURES>(pos, &ml);
 
+		int raise = (raise_captures) ? 10000000 : 0;
+
 		// Step 2. Loop through all the moves.
 		for (int i = 0; i < ml.size(); i++) {
-			
-			if (raise_captures) {
-				ml[i]->score = 10000000;
+			int attacker = pos->piece_list[pos->side_to_move][FROMSQ(ml[i]->move)];
+			int captured = (SPECIAL(ml[i]->move) == ENPASSANT) ? PAWN : pos->piece_list[Them][TOSQ(ml[i]->move)];
+
+			// Promotions that don't capture are ordered like pawn captures.
+			int victim = (captured == NO_TYPE) ? PAWN : captured;
+
+			// Step 2A. LxH captures can't lose material, and otherwise we only need to know whether SEE is negative. Winning and equal captures
+			//	are scored by MvvLva.
+			if ((captured != NO_TYPE && captured > attacker) || pos->see_ge(ml[i]->move, 0)) {
+				ml[i]->score = raise + MvvLva[attacker][victim];
 			}
+			// Step 2B. Losing captures get a negative score, but are still ordered by MvvLva among themselves.
 			else {
-				ml[i]->score = 0;
+				ml[i]->score = -raise + MvvLva[attacker][victim] - 1000;
 			}
 
-			// Step 2A. If the capture is a LxH, score it with MvvLva
-			if (pos->piece_list[Them][TOSQ(ml[i]->move)] > pos->piece_list[pos->side_to_move][FROMSQ(ml[i]->move)]) {
-				ml[i]->score = MvvLva[pos->piece_list[pos->side_to_move][FROMSQ(ml[i]->move)]][pos->piece_list[Them][TOSQ(ml[i]->move)]];
-			}
-			// Step 2B. Otherwise, we need to run SEE
-			else {
-				int score = pos->see(ml[i]->move);
-
-				if (score >= 0) {
-					ml[i]->score += score;
-				}
-				else {
-					ml[i]->score *= -1;
-					ml[i]->score += score;
-				}
+			// Step 2C. In the main search, captures with the same material outcome are ordered by their capture history. The sign of the score is kept,
+			//	since it is used to tell winning and losing captures apart.
+			if (stats != nullptr && captured != NO_TYPE) {
+				int history = stats->capture_history[piece_index(pos->side_to_move, pos->piece_list[pos->side_to_move][FROMSQ(ml[i]->move)])]
+					[TOSQ(ml[i]->move)][captured] / 64;
+
+				ml[i]->score = (ml[i]->score >= 0) ? std::max(0, ml[i]->score + history) : std::min(-1, ml[i]->score + history);
 			}
 		}
 	}
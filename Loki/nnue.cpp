@@ -0,0 +1,489 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "nnue.h"
+#include "position.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(HAS_SSE2_INSTRUCTIONS)
+#include <immintrin.h>
+#endif
+
+#if (defined(_WIN32) || defined(_WIN64))
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+namespace NNUE {
+
+	Kernel kernel = SCALAR_KERNEL;
+
+	namespace {
+
+		/*
+		The layout of a network file. The header is 64 bytes so that the weights after it keep the alignment of the mapping.
+		*/
+		struct FileHeader {
+			char magic[8];
+			uint32_t version;
+			uint32_t inputs;
+			uint32_t hidden;
+			uint32_t reserved[11];
+		};
+
+		static_assert(sizeof(FileHeader) == 64);
+
+		constexpr char FILE_MAGIC[8] = { 'L', 'O', 'K', 'I', 'N', 'N', 'U', 'E' };
+		constexpr uint32_t FILE_VERSION = 1;
+
+		constexpr size_t FILE_SIZE = sizeof(FileHeader) + sizeof(int16_t) * (INPUTS * HIDDEN + HIDDEN + 2 * HIDDEN) + sizeof(int32_t);
+
+
+		/*
+		The weights point directly into the memory-mapped file.
+		*/
+		struct Network {
+			const int16_t* feature_weights = nullptr;
+			const int16_t* feature_biases = nullptr;
+			const int16_t* output_weights = nullptr;
+			int32_t output_bias = 0;
+
+			const void* mapping = nullptr;
+			size_t mapping_size = 0;
+#if (defined(_WIN32) || defined(_WIN64))
+			HANDLE file_handle = INVALID_HANDLE_VALUE;
+			HANDLE mapping_handle = nullptr;
+#endif
+		};
+
+		Network network;
+
+
+		/// <summary>
+		/// Map a file into memory read-only.
+		/// </summary>
+		/// <returns>True if the file could be mapped. net.mapping and net.mapping_size are then set.</returns>
+		bool map_file(const std::string& path, Network& net) {
+#if (defined(_WIN32) || defined(_WIN64))
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			LARGE_INTEGER size;
+			HANDLE mapping = (GetFileSizeEx(file, &size)) ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+			const void* view = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+			if (view == nullptr) {
+				if (mapping != nullptr) {
+					CloseHandle(mapping);
+				}
+				CloseHandle(file);
+				return false;
+			}
+
+			net.file_handle = file;
+			net.mapping_handle = mapping;
+			net.mapping = view;
+			net.mapping_size = size_t(size.QuadPart);
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				return false;
+			}
+
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+				close(fd);
+				return false;
+			}
+
+			void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+
+			if (view == MAP_FAILED) {
+				return false;
+			}
+
+			net.mapping = view;
+			net.mapping_size = size_t(st.st_size);
+#endif
+			return true;
+		}
+
+
+		void unmap_file(Network& net) {
+			if (net.mapping == nullptr) {
+				return;
+			}
+
+#if (defined(_WIN32) || defined(_WIN64))
+			UnmapViewOfFile(net.mapping);
+			CloseHandle(net.mapping_handle);
+			CloseHandle(net.file_handle);
+#else
+			munmap(const_cast<void*>(net.mapping), net.mapping_size);
+#endif
+			net = Network();
+		}
+
+
+		/*
+		Kernels. update() writes in + the rows in add - the rows in sub to out, and output() returns the dot product of the clipped accumulators with
+		the output weights.
+		*/
+		void update_scalar(int16_t* out, const int16_t* in, const int16_t* const* add, int add_count, const int16_t* const* sub, int sub_count) {
+			for (int i = 0; i < HIDDEN; i++) {
+				int16_t v = in[i];
+
+				for (int a = 0; a < add_count; a++) {
+					v += add[a][i];
+				}
+				for (int s = 0; s < sub_count; s++) {
+					v -= sub[s][i];
+				}
+
+				out[i] = v;
+			}
+		}
+
+		int output_scalar(const int16_t* us, const int16_t* them, const int16_t* weights) {
+			int sum = 0;
+
+			for (int i = 0; i < HIDDEN; i++) {
+				sum += std::clamp(int(us[i]), 0, QA) * weights[i];
+				sum += std::clamp(int(them[i]), 0, QA) * weights[HIDDEN + i];
+			}
+
+			return sum;
+		}
+
+
+#if defined(HAS_SSE2_INSTRUCTIONS)
+		void update_sse2(int16_t* out, const int16_t* in, const int16_t* const* add, int add_count, const int16_t* const* sub, int sub_count) {
+			for (int i = 0; i < HIDDEN; i += 8) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+
+				for (int a = 0; a < add_count; a++) {
+					v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i*)(add[a] + i)));
+				}
+				for (int s = 0; s < sub_count; s++) {
+					v = _mm_sub_epi16(v, _mm_loadu_si128((const __m128i*)(sub[s] + i)));
+				}
+
+				_mm_storeu_si128((__m128i*)(out + i), v);
+			}
+		}
+
+		int output_sse2(const int16_t* us, const int16_t* them, const int16_t* weights) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i qa = _mm_set1_epi16(QA);
+			__m128i sum = _mm_setzero_si128();
+
+			for (int i = 0; i < HIDDEN; i += 8) {
+				__m128i u = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i*)(us + i)), zero), qa);
+				__m128i t = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i*)(them + i)), zero), qa);
+
+				// madd multiplies the 16-bit lanes and adds neighbouring products into 32-bit lanes.
+				sum = _mm_add_epi32(sum, _mm_madd_epi16(u, _mm_loadu_si128((const __m128i*)(weights + i))));
+				sum = _mm_add_epi32(sum, _mm_madd_epi16(t, _mm_loadu_si128((const __m128i*)(weights + HIDDEN + i))));
+			}
+
+			sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+			sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+
+			return _mm_cvtsi128_si32(sum);
+		}
+
+
+		TARGET_AVX2 void update_avx2(int16_t* out, const int16_t* in, const int16_t* const* add, int add_count, const int16_t* const* sub, int sub_count) {
+			for (int i = 0; i < HIDDEN; i += 16) {
+				__m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+
+				for (int a = 0; a < add_count; a++) {
+					v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i*)(add[a] + i)));
+				}
+				for (int s = 0; s < sub_count; s++) {
+					v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i*)(sub[s] + i)));
+				}
+
+				_mm256_storeu_si256((__m256i*)(out + i), v);
+			}
+		}
+
+		TARGET_AVX2 int output_avx2(const int16_t* us, const int16_t* them, const int16_t* weights) {
+			const __m256i zero = _mm256_setzero_si256();
+			const __m256i qa = _mm256_set1_epi16(QA);
+			__m256i sum = _mm256_setzero_si256();
+
+			for (int i = 0; i < HIDDEN; i += 16) {
+				__m256i u = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i*)(us + i)), zero), qa);
+				__m256i t = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i*)(them + i)), zero), qa);
+
+				sum = _mm256_add_epi32(sum, _mm256_madd_epi16(u, _mm256_loadu_si256((const __m256i*)(weights + i))));
+				sum = _mm256_add_epi32(sum, _mm256_madd_epi16(t, _mm256_loadu_si256((const __m256i*)(weights + HIDDEN + i))));
+			}
+
+			__m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+			s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+			s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+
+			return _mm_cvtsi128_si32(s);
+		}
+#endif
+
+
+		inline void update(int16_t* out, const int16_t* in, const int16_t* const* add, int add_count, const int16_t* const* sub, int sub_count) {
+			switch (kernel) {
+#if defined(HAS_SSE2_INSTRUCTIONS)
+			case AVX2_KERNEL: update_avx2(out, in, add, add_count, sub, sub_count); return;
+			case SSE2_KERNEL: update_sse2(out, in, add, add_count, sub, sub_count); return;
+#endif
+			default: update_scalar(out, in, add, add_count, sub, sub_count); return;
+			}
+		}
+
+		inline int output(const int16_t* us, const int16_t* them, const int16_t* weights) {
+			switch (kernel) {
+#if defined(HAS_SSE2_INSTRUCTIONS)
+			case AVX2_KERNEL: return output_avx2(us, them, weights);
+			case SSE2_KERNEL: return output_sse2(us, them, weights);
+#endif
+			default: return output_scalar(us, them, weights);
+			}
+		}
+
+
+		/// <summary>
+		/// The input of a piece seen from one side. The inputs of the perspective's own pieces come first, and black sees the board flipped.
+		/// </summary>
+		inline int feature_index(int perspective, int side, int pce, int sq) {
+			int relative_sq = (perspective == WHITE) ? sq : (sq ^ 56);
+
+			return ((side == perspective) ? 0 : 6 * 64) + pce * 64 + relative_sq;
+		}
+
+		inline const int16_t* feature_row(int perspective, int side, int pce, int sq) {
+			return network.feature_weights + feature_index(perspective, side, pce, sq) * HIDDEN;
+		}
+
+
+		/// <summary>
+		/// Compute an accumulator from scratch.
+		/// </summary>
+		void refresh(const GameState_t* pos, Accumulator& acc) {
+			const int16_t* rows[32];
+
+			for (int perspective = BLACK; perspective <= WHITE; perspective++) {
+				int count = 0;
+
+				for (int side = BLACK; side <= WHITE; side++) {
+					for (int pce = PAWN; pce <= KING; pce++) {
+						Bitboard pieces = pos->pieceBBS[pce][side];
+
+						while (pieces) {
+							int sq = PopBit(&pieces);
+
+							assert(count < 32);
+							rows[count++] = feature_row(perspective, side, pce, sq);
+						}
+					}
+				}
+
+				update(acc.values[perspective], network.feature_biases, rows, count, nullptr, 0);
+			}
+
+			acc.key = pos->posKey;
+			acc.computed = true;
+		}
+
+
+		/// <summary>
+		/// Compute an accumulator by applying its changes to the previous one.
+		/// </summary>
+		void apply_delta(const Accumulator& previous, Accumulator& acc) {
+			const DirtyPiece& dp = acc.dirty;
+
+			for (int perspective = BLACK; perspective <= WHITE; perspective++) {
+				const int16_t* add[3];
+				const int16_t* sub[3];
+				int add_count = 0, sub_count = 0;
+
+				for (int n = 0; n < dp.count; n++) {
+					if (dp.from[n] != NO_SQ) {
+						sub[sub_count++] = feature_row(perspective, dp.side[n], dp.piece[n], dp.from[n]);
+					}
+					if (dp.to[n] != NO_SQ) {
+						add[add_count++] = feature_row(perspective, dp.side[n], dp.piece[n], dp.to[n]);
+					}
+				}
+
+				update(acc.values[perspective], previous.values[perspective], add, add_count, sub, sub_count);
+			}
+
+			acc.computed = true;
+		}
+
+
+		/// <summary>
+		/// Make sure that the accumulator of the position is computed.
+		/// </summary>
+		/// <returns>The accumulator.</returns>
+		const Accumulator& current_accumulator(const GameState_t* pos) {
+			AccumulatorStack& stack = pos->accumulators;
+			int ply = pos->ply;
+
+			// Step 1. Positions that aren't on the stack are always computed from scratch.
+			if (ply < 0 || ply >= STACK_SIZE) {
+				refresh(pos, stack.entries[STACK_SIZE]);
+				return stack.entries[STACK_SIZE];
+			}
+
+			Accumulator& acc = stack.entries[ply];
+
+			// Step 2. If the accumulator belongs to another position, the ply has been reset and it can't be updated.
+			if (acc.key != pos->posKey) {
+				refresh(pos, acc);
+				return acc;
+			}
+
+			if (acc.computed) {
+				return acc;
+			}
+
+			// Step 3. Go back to the latest ply that is either computed or can't be updated.
+			int p = ply;
+			while (p > 0 && !stack.entries[p].computed && stack.entries[p].has_delta) {
+				p--;
+			}
+
+			// Step 4. If that one isn't computed, it is refreshed. This happens at the first ply of the stack, and when the ply has been reset
+			//	since the accumulator was used.
+			if (!stack.entries[p].computed) {
+				assert(p == 0 || !stack.entries[p].has_delta);
+				refresh(pos, stack.entries[p]);
+
+				if (p == ply) {
+					return acc;
+				}
+			}
+
+			// Step 5. Apply the changes of each ply after it.
+			for (int q = p + 1; q <= ply; q++) {
+				apply_delta(stack.entries[q - 1], stack.entries[q]);
+			}
+
+			return acc;
+		}
+	}
+
+
+	std::string kernel_name(Kernel k) {
+		switch (k) {
+		case AVX2_KERNEL: return "avx2";
+		case SSE2_KERNEL: return "sse2";
+		default: return "scalar";
+		}
+	}
+
+
+	void INIT() {
+#if defined(HAS_SSE2_INSTRUCTIONS)
+		kernel = (CPU::has_avx2()) ? AVX2_KERNEL : SSE2_KERNEL;
+#else
+		kernel = SCALAR_KERNEL;
+#endif
+	}
+
+
+	bool load(const std::string& path) {
+		// Step 1. An empty path unloads the network.
+		if (path.empty() || path == "<empty>") {
+			unmap_file(network);
+			return true;
+		}
+
+		// Step 2. Map the file and check the header and size.
+		Network net;
+		if (!map_file(path, net)) {
+			return false;
+		}
+
+		const FileHeader* header = static_cast<const FileHeader*>(net.mapping);
+
+		if (net.mapping_size != FILE_SIZE || std::memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header->version != FILE_VERSION
+			|| header->inputs != INPUTS || header->hidden != HIDDEN) {
+			unmap_file(net);
+			return false;
+		}
+
+		// Step 3. Point the weights into the file.
+		const int16_t* data = reinterpret_cast<const int16_t*>(header + 1);
+
+		net.feature_weights = data;
+		net.feature_biases = net.feature_weights + INPUTS * HIDDEN;
+		net.output_weights = net.feature_biases + HIDDEN;
+		std::memcpy(&net.output_bias, net.output_weights + 2 * HIDDEN, sizeof(int32_t));
+
+		// Step 4. Replace the old network.
+		unmap_file(network);
+		network = net;
+
+		return true;
+	}
+
+
+	bool is_loaded() {
+		return network.mapping != nullptr;
+	}
+
+
+	int evaluate(const GameState_t* pos) {
+		assert(is_loaded());
+
+		const Accumulator& acc = current_accumulator(pos);
+		assert(accumulator_ok(pos));
+
+		SIDE Us = pos->side_to_move;
+		SIDE Them = (Us == WHITE) ? BLACK : WHITE;
+
+		int sum = output(acc.values[Us], acc.values[Them], network.output_weights) + network.output_bias;
+
+		return sum * OUTPUT_SCALE / (QA * QB);
+	}
+
+
+	bool accumulator_ok(const GameState_t* pos) {
+		const Accumulator& acc = current_accumulator(pos);
+
+		Accumulator fresh;
+		refresh(pos, fresh);
+
+		return std::memcmp(acc.values, fresh.values, sizeof(fresh.values)) == 0;
+	}
+}
@@ -0,0 +1,150 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef NNUE_H
+#define NNUE_H
+#include "bitboard.h"
+
+#include <string>
+
+
+class GameState_t;
+
+
+/*
+
+An efficiently updatable neural network evaluation. The network has 768 inputs, one for every piece type of either colour on every square, seen
+from the perspective of one side. They are transformed into 256 values for each side, and these are kept in an accumulator that only changes by the
+weights of the few inputs that a move adds or removes. The accumulators of both sides are clipped and combined into a single output.
+
+A network file is a 64-byte header followed by little-endian integers:
+	int16_t feature_weights[768][256], feature_biases[256], output_weights[2 * 256] and int32_t output_bias.
+The output weights of the side to move come first. Both the accumulators and the output use a scale of QA, and the output weights one of QB.
+
+*/
+namespace NNUE {
+
+	constexpr int INPUTS = 768;
+	constexpr int HIDDEN = 256;
+
+	constexpr int QA = 255;
+	constexpr int QB = 64;
+	constexpr int OUTPUT_SCALE = 400;
+
+	// There is one accumulator for every ply of the search. Positions beyond it are evaluated from scratch.
+	constexpr int STACK_SIZE = MAXDEPTH + 1;
+
+
+	/// <summary>
+	/// The pieces that a move has moved, removed or added. A removed piece has to == NO_SQ and an added one has from == NO_SQ. A promoting capture
+	/// changes three pieces, which is the most any move does.
+	/// </summary>
+	struct DirtyPiece {
+		int count = 0;
+
+		int8_t side[3] = { 0 };
+		int8_t piece[3] = { 0 };
+		int8_t from[3] = { 0 };
+		int8_t to[3] = { 0 };
+
+		inline void add(int s, int pce, int from_sq, int to_sq) {
+			side[count] = int8_t(s); piece[count] = int8_t(pce); from[count] = int8_t(from_sq); to[count] = int8_t(to_sq);
+			count++;
+		}
+	};
+
+
+	/// <summary>
+	/// The transformed inputs of a position from each side's perspective. If it hasn't been computed, it can be found by applying dirty to the
+	/// accumulator of the previous ply, provided has_delta is set.
+	/// </summary>
+	struct alignas(64) Accumulator {
+		int16_t values[2][HIDDEN];
+
+		uint64_t key = 0;
+		bool computed = false;
+		bool has_delta = false;
+
+		DirtyPiece dirty;
+	};
+
+
+	/// <summary>
+	/// The accumulators of a position, indexed by ply. The position records the changes of every move here, and the accumulators themselves are
+	/// computed the first time a position is evaluated.
+	/// </summary>
+	class AccumulatorStack {
+	public:
+		/// <summary>
+		/// Start the accumulator of a new ply after a move or null move.
+		/// </summary>
+		/// <param name="ply">The ply after the move.</param>
+		/// <param name="parent_key">The hash key before the move.</param>
+		/// <param name="key">The hash key after the move.</param>
+		/// <returns>The changes to be filled in by the move, or nullptr if the ply is outside of the stack.</returns>
+		inline DirtyPiece* push(int ply, uint64_t parent_key, uint64_t key) {
+			if (ply <= 0 || ply >= STACK_SIZE) {
+				return nullptr;
+			}
+
+			// The previous accumulator might be from another position if the ply has been reset since it was used, and then it can't be updated.
+			Accumulator& parent = entries[ply - 1];
+			if (parent.key != parent_key) {
+				parent.key = parent_key;
+				parent.computed = false;
+				parent.has_delta = false;
+			}
+
+			Accumulator& acc = entries[ply];
+			acc.key = key;
+			acc.computed = false;
+			acc.has_delta = true;
+			acc.dirty.count = 0;
+
+			return &acc.dirty;
+		}
+
+		// The last entry is used for positions beyond the stack.
+		Accumulator entries[STACK_SIZE + 1];
+	};
+
+
+	// The SIMD kernels used for the accumulators and the output.
+	enum Kernel : int { SCALAR_KERNEL = 0, SSE2_KERNEL = 1, AVX2_KERNEL = 2 };
+
+	extern Kernel kernel;
+
+	std::string kernel_name(Kernel k);
+
+	// Selects the best kernel for the processor.
+	void INIT();
+
+	// Memory-maps a network file. On failure the previous network, if any, is kept and false is returned. An empty path or "<empty>" unloads it.
+	bool load(const std::string& path);
+
+	// Returns true if a network has been loaded.
+	bool is_loaded();
+
+	// Evaluate a position with the network. The score is relative to the side to move.
+	int evaluate(const GameState_t* pos);
+
+	// Returns true if the accumulator of the position is equal to one computed from scratch. Used for debugging.
+	bool accumulator_ok(const GameState_t* pos);
+}
+
+
+#endif
@@ -16,7 +16,12 @@
 	along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include "perft.h"
+#include "misc.h"
 
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
 
 
 namespace Perft {
@@ -25,60 +30,118 @@ namespace Perft {
 #else
 	PerftTable* pt = nullptr;
 #endif
-	long long leaf_count = 0;
 
 
 	namespace {
 
-		void perft(GameState_t* pos, int depth) {
-
-			if (depth <= 0) {
-				leaf_count += 1;
-				return;
+		/*
+		Generate the moves of a node. When in check, only the evasions are generated, so perft verifies that generator as well.
+		*/
+		void generate_moves(GameState_t* pos, MoveList* moves) {
+			if (pos->in_check()) {
+				moveGen::generate<EVASIONS>(pos, moves);
 			}
-
-#if defined(PERFT_TT)
-			bool tableHit = false;
-			PerftEntry* entry = pt->probe_table(pos->posKey, depth, tableHit);
-
-			if (tableHit) {
-				leaf_count += entry->nodeCount;
-				return;
+			else {
+				moveGen::generate<ALL>(pos, moves);
 			}
-#endif
+		}
 
-			MoveList moves; moveGen::generate<ALL>(pos, &moves);
 
-#if defined(PERFT_TT) // Just a pedantic suppression of C4189 when not using perft_tt
-			long long previous_cnt = leaf_count;
-#endif
+#ifndef NDEBUG
+		/*
+		Collect the legal moves of a list. If only_checks is set, the moves also have to be quiet and give check.
+		*/
+		std::vector<unsigned int> legal_moves(GameState_t* pos, MoveList* moves, bool only_checks) {
+			std::vector<unsigned int> legal;
+			SIDE Them = (pos->side_to_move == WHITE) ? BLACK : WHITE;
+
+			for (int m = 0; m < int(moves->size()); m++) {
+				unsigned int move = (*moves)[m]->move;
+				bool quiet = SPECIAL(move) == NOT_SPECIAL && pos->piece_list[Them][TOSQ(move)] == NO_TYPE;
 
-			for (int m = 0; m < moves.size(); m++) {
-				if (!pos->make_move(moves[m])) {
+				if (!pos->make_move((*moves)[m])) {
 					continue;
 				}
 
-				perft(pos, depth - 1);
+				if (!only_checks || (quiet && pos->in_check())) {
+					legal.push_back(move);
+				}
 
 				pos->undo_move();
+			}
+
+			std::sort(legal.begin(), legal.end());
+			return legal;
+		}
 
+
+		/*
+		In debug builds, check the evasion and quiet check generators against the legal moves found by the full generator.
+		*/
+		bool generators_agree(GameState_t* pos) {
+			MoveList all; moveGen::generate<ALL>(pos, &all);
+
+			if (pos->in_check()) {
+				MoveList evasions; moveGen::generate<EVASIONS>(pos, &evasions);
+
+				return legal_moves(pos, &evasions, false) == legal_moves(pos, &all, false);
 			}
 
-#if defined(PERFT_TT)
-			pt->store_entry(pos->posKey, depth, leaf_count - previous_cnt);
+			MoveList checks; moveGen::generate<QUIET_CHECKS>(pos, &checks);
+
+			return legal_moves(pos, &checks, false) == legal_moves(pos, &all, true);
+		}
 #endif
+	}
+
+
+	long long perft(GameState_t* pos, int depth, PerftTable* table) {
+
+		if (depth <= 0) {
+			return 1;
 		}
 
+		bool tableHit = false;
+		if (table != nullptr) {
+			PerftEntry* entry = table->probe_table(pos->posKey, depth, tableHit);
+
+			if (tableHit) {
+				return entry->nodeCount;
+			}
+		}
+
+		assert(generators_agree(pos));
+
+		MoveList moves; generate_moves(pos, &moves);
+
+		long long nodes = 0;
+
+		for (int m = 0; m < moves.size(); m++) {
+			if (!pos->make_move(moves[m])) {
+				continue;
+			}
+
+			nodes += perft(pos, depth - 1, table);
+
+			pos->undo_move();
+
+		}
+
+		if (table != nullptr) {
+			table->store_entry(pos->posKey, depth, nodes);
+		}
+
+		return nodes;
 	}
 
 
 	void perftTest(GameState_t* pos, int depth) {
-		leaf_count = 0;
+		long long leaf_count = 0;
 
 		std::cout << "Starting perft test to depth " << depth << std::endl;
 
 
-		MoveList moves; moveGen::generate<ALL>(pos, &moves);
+		MoveList moves; generate_moves(pos, &moves);
 
 		std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::high_resolution_clock::now();
 
@@ -90,13 +153,12 @@ namespace Perft {
 			}
 
 			legal += 1;
-			long long old_nodes = leaf_count;
-
-			perft(pos, depth - 1);
+			long long nodes = perft(pos, depth - 1, pt);
+			leaf_count += nodes;
 
 			pos->undo_move();
 
-			std::cout << "[" << legal << "] " << printMove(moves[m]->move) << "	---> " << (leaf_count - old_nodes) << " nodes." << std::endl;
+			std::cout << "[" << legal << "] " << printMove(moves[m]->move) << "	---> " << nodes << " nodes." << std::endl;
 		}
 
 		std::chrono::time_point<std::chrono::high_resolution_clock> end_time = std::chrono::high_resolution_clock::now();
@@ -112,6 +174,153 @@ namespace Perft {
 	}
 
 
+	std::vector<SuitePosition> read_suite(const std::string& path) {
+		std::vector<SuitePosition> positions;
+		std::ifstream file(path);
+		std::string line;
+
+		while (std::getline(file, line)) {
+			std::istringstream ss(line);
+			std::string field;
+
+			// Step 1. The FEN is everything before the first semicolon.
+			SuitePosition sp;
+			std::getline(ss, sp.fen, ';');
+			sp.fen.erase(sp.fen.find_last_not_of(" \t\r") + 1);
+
+			if (sp.fen.empty() || sp.fen[0] == '#') {
+				continue;
+			}
+
+			// Step 2. The counts are written as "D<depth> <nodes>".
+			while (std::getline(ss, field, ';')) {
+				std::istringstream count(field);
+				std::string depth;
+				long long nodes = 0;
+
+				if (count >> depth >> nodes && depth.size() > 1 && depth[0] == 'D' && depth.find_first_not_of("0123456789", 1) == std::string::npos) {
+					sp.counts[std::stoi(depth.substr(1))] = nodes;
+				}
+			}
+
+			if (!sp.counts.empty()) {
+				positions.push_back(sp);
+			}
+		}
+
+		return positions;
+	}
+
+
+	/*
+
+	Run the positions of a suite. Each thread runs the depths of a position up to max_depth, stopping at the first wrong count. Positions without any of those depths are skipped. The results are printed in the order of the file. The perft table isn't used, since it isn't safe to share between threads.
+
+	*/
+	bool run_suite(const std::string& path, int max_depth, int threads) {
+		struct Result {
+			int depth = 0;				// The last depth that was run, or zero if the position was skipped.
+			long long nodes = 0;		// The nodes counted at that depth.
+			long long total_nodes = 0;	// The nodes counted at all depths.
+			long long time = 0;
+			bool passed = true;
+		};
+
+		// Step 1. Read the positions.
+		std::vector<SuitePosition> positions = read_suite(path);
+
+		if (positions.empty()) {
+			std::cout << "info string perftsuite: no positions in " << path << std::endl;
+			return false;
+		}
+
+		long long start = getTimeMs();
+
+		// Step 2. Run the positions, with a board for every thread, and print the results in order as they are finished.
+		std::vector<GameState_t> boards(threads);
+		std::vector<Result> results(positions.size());
+
+		run_ordered(positions.size(), threads,
+			[&](int id, size_t i) {
+				GameState_t* pos = &boards[id];
+				const SuitePosition& sp = positions[i];
+				Result& r = results[i];
+
+				pos->parseFen(sp.fen);
+				long long position_start = getTimeMs();
+
+				for (auto it = sp.counts.begin(); it != sp.counts.end() && it->first <= max_depth && r.passed; ++it) {
+					r.depth = it->first;
+					r.nodes = perft(pos, r.depth);
+					r.total_nodes += r.nodes;
+					r.passed = r.nodes == it->second;
+				}
+
+				r.time = getTimeMs() - position_start;
+			},
+			[&](size_t i) {
+				const Result& r = results[i];
+
+				if (r.depth == 0) {
+					std::cout << "info string perftsuite " << (i + 1) << " skipped" << std::endl;
+					return;
+				}
+
+				std::cout << "info string perftsuite " << (i + 1) << " " << (r.passed ? "passed" : "FAILED") << " depth " << r.depth
+					<< " nodes " << r.nodes;
+				if (!r.passed) {
+					std::cout << " expected " << positions[i].counts.at(r.depth) << " fen " << positions[i].fen;
+				}
+				std::cout << " time " << r.time << " nps " << (r.total_nodes * 1000 / std::max(r.time, 1LL)) << std::endl;
+			});
+
+		// Step 3. Print the totals. The speed is the total of all threads.
+		int passed = 0, run = 0;
+		long long nodes = 0;
+
+		for (const Result& r : results) {
+			run += (r.depth > 0);
+			passed += (r.depth > 0 && r.passed);
+			nodes += r.total_nodes;
+		}
+
+		long long time = std::max(getTimeMs() - start, 1LL);
+
+		std::cout << "info string perftsuite done: " << passed << "/" << run << " passed, " << nodes << " nodes in " << std::fixed
+			<< std::setprecision(1) << time / 1000.0 << "s, " << (nodes * 1000 / time) << " nps" << std::endl;
+
+		return passed == run;
+	}
+
+
+	/*
+
+	Parse a "perftsuite" command. The maximum depth and number of threads are optional and given in that order.
+
+	*/
+	void parse_suite(const std::string& command) {
+		std::istringstream ss(command);
+		std::string token, path;
+		int max_depth = MAXDEPTH, threads = 1;
+
+		ss >> token >> path; // "perftsuite <epd>"
+
+		if (path.empty()) {
+			std::cout << "info string perftsuite: usage perftsuite <epd> [maxdepth] [threads]" << std::endl;
+			return;
+		}
+
+		if (ss >> max_depth) {
+			ss >> threads;
+		}
+
+		max_depth = std::clamp(max_depth, 1, MAXDEPTH);
+		threads = std::clamp(threads, 1, int(std::max(std::thread::hardware_concurrency(), 1u)));
+
+		run_suite(path, max_depth, threads);
+	}
+
+
 
 	PerftTable::PerftTable(size_t mb_size) {
 		num_entries = int(MB(mb_size) / sizeof(PerftEntry));
@@ -120,7 +329,7 @@ namespace Perft {
 	}
 
 	PerftTable::~PerftTable() {
-		delete entries;
+		delete[] entries;
 	}
 
 	void PerftTable::store_entry(uint64_t pos_key, int depth, long long nodes) {
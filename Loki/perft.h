@@ -18,15 +18,41 @@
 #include "movegen.h"
 
 #include <chrono>
+#include <map>
+#include <string>
+#include <vector>
 
 
 namespace Perft {
-	extern long long leaf_count;
+	class PerftTable;
+
+	// Count the leaf nodes to a depth. It only uses the position and the table it is given, so several threads can run it on their own
+	//	positions as long as they don't share a table.
+	long long perft(GameState_t* pos, int depth, PerftTable* table = nullptr);
 
-	
 	void perftTest(GameState_t* pos, int depth);
 
 
+	/*
+
+	A perft suite is an EPD file where each line is a FEN followed by the expected node counts, e.g. "<fen> ;D1 20 ;D2 400 ;D3 8902".
+
+	*/
+	struct SuitePosition {
+		std::string fen;
+		std::map<int, long long> counts; // The expected node count of each depth. Not every depth has to be given.
+	};
+
+	std::vector<SuitePosition> read_suite(const std::string& path);
+
+	// Run the positions of a suite to at most max_depth on a number of threads, and print the result and speed of every position and in total.
+	//	Returns true if all counts were correct.
+	bool run_suite(const std::string& path, int max_depth, int threads);
+
+	// Parses a "perftsuite <epd> [maxdepth] [threads]" command and runs it.
+	void parse_suite(const std::string& command);
+
+
 	/*
 	The below structure resembles a transposition table's, and its use is twofold: 1) It will make perft faster, and
 		2) It can be helpful when debugging the zobrist position key which is also used to get an entry to the TT.
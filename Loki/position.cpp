@@ -69,6 +69,27 @@ void GameState_t::generate_poskey() {
 	posKey ^= BBS::Zobrist::castling_keys[castleRights];
 }
 
+
+/*
+
+The material key is made from piece_keys[side][pce][n] for the n'th piece of each type, so the square indices are re-used as piece counts. This
+way, adding or removing a piece only requires one XOR with the key of the count it ends up at or came from.
+
+*/
+void GameState_t::generate_material_key() {
+	materialKey = 0;
+
+	for (int pce = PAWN; pce < NO_TYPE; pce++) {
+		for (int n = 0; n < countBits(pieceBBS[pce][WHITE]); n++) {
+			materialKey ^= BBS::Zobrist::piece_keys[WHITE][pce][n];
+		}
+
+		for (int n = 0; n < countBits(pieceBBS[pce][BLACK]); n++) {
+			materialKey ^= BBS::Zobrist::piece_keys[BLACK][pce][n];
+		}
+	}
+}
+
 void GameState_t::displayBoardState() {
 	std::string output = "................................................................";
 	int index = 0;
@@ -156,6 +177,7 @@ void GameState_t::clearPos() {
 	fiftyMove = 0;
 
 	posKey = 0;
+	materialKey = 0;
 
 	history_ply = 0;
 }
@@ -296,8 +318,9 @@ void GameState_t::parseFen(const std::string FEN_STR) {
 		| pieceBBS[QUEEN][BLACK] | pieceBBS[KING][BLACK]);
 
 
-	// Generate the position hash key
+	// Generate the position and material hash keys
 	generate_poskey();
+	generate_material_key();
 }
 
 
@@ -454,6 +477,7 @@ bool GameState_t::make_move(Move_t* move) {
 	info->fifty_moves = fiftyMove;
 	info->enPasSq = enPasSq;
 	info->posKey = posKey;
+	info->materialKey = materialKey;
 	history_ply++;
 
 	posKey ^= BBS::Zobrist::castling_keys[castleRights];
@@ -473,6 +497,10 @@ bool GameState_t::make_move(Move_t* move) {
 		piece_list[side_to_move][destination] = promotion_piece;
 
 		posKey ^= BBS::Zobrist::piece_keys[side_to_move][promotion_piece][destination];
+
+		// The pawn disappears and the promotion piece is added.
+		materialKey ^= BBS::Zobrist::piece_keys[side_to_move][PAWN][countBits(pieceBBS[PAWN][side_to_move])];
+		materialKey ^= BBS::Zobrist::piece_keys[side_to_move][promotion_piece][countBits(pieceBBS[promotion_piece][side_to_move]) - 1];
 	}
 	else {
 		pieceBBS[piece_moved][side_to_move] |= (uint64_t(1) << destination);
@@ -489,6 +517,7 @@ bool GameState_t::make_move(Move_t* move) {
 		piece_list[Them][destination] = NO_TYPE;
 
 		posKey ^= BBS::Zobrist::piece_keys[Them][piece_captured][destination];
+		materialKey ^= BBS::Zobrist::piece_keys[Them][piece_captured][countBits(pieceBBS[piece_captured][Them])];
 	}
 
 	// Step 6. If the move is a castling move, move the rook.
@@ -527,6 +556,7 @@ bool GameState_t::make_move(Move_t* move) {
 		piece_list[(side_to_move == WHITE) ? BLACK : WHITE][(side_to_move == WHITE) ? (destination - 8) : (destination + 8)] = NO_TYPE;
 
 		posKey ^= BBS::Zobrist::piece_keys[Them][PAWN][(side_to_move == WHITE) ? (destination - 8) : (destination + 8)];
+		materialKey ^= BBS::Zobrist::piece_keys[Them][PAWN][countBits(pieceBBS[PAWN][Them])];
 	}
 
 	// Step 8. Update the castling rights --> if the king has been moved, all castling rights for that side will be removed. If a piece has moved to or from
@@ -596,6 +626,29 @@ bool GameState_t::make_move(Move_t* move) {
 	posKey ^= BBS::Zobrist::castling_keys[castleRights];
 	posKey ^= BBS::Zobrist::side_key;
 
+	// Step 12A. Record the pieces that have been moved, added or removed, such that the network's accumulator can be updated from the previous one.
+	if (NNUE::DirtyPiece* dp = accumulators.push(ply, info->posKey, posKey)) {
+		if (spc == PROMOTION) {
+			dp->add(side_to_move, PAWN, origin, NO_SQ);
+			dp->add(side_to_move, promotion_piece, NO_SQ, destination);
+		}
+		else {
+			dp->add(side_to_move, piece_moved, origin, destination);
+		}
+
+		if (piece_captured != NO_TYPE) {
+			dp->add(Them, piece_captured, destination, NO_SQ);
+		}
+		else if (spc == ENPASSANT) {
+			dp->add(Them, PAWN, (side_to_move == WHITE) ? (destination - 8) : (destination + 8), NO_SQ);
+		}
+		else if (spc == CASTLING) {
+			bool kingside = destination > origin;
+			dp->add(side_to_move, ROOK, (side_to_move == WHITE) ? (kingside ? H1 : A1) : (kingside ? H8 : A8),
+				(side_to_move == WHITE) ? (kingside ? F1 : D1) : (kingside ? F8 : D8));
+		}
+	}
+
 	// Step 13. See if the king is in check. If it is, then undo the move and return false.
 	if (square_attacked(king_squares[side_to_move], (side_to_move == WHITE) ? BLACK : WHITE)) {
 		side_to_move = (side_to_move == WHITE) ? BLACK : WHITE; // undo_move will toggle this, so we have to change it before calling the function.
@@ -736,6 +789,7 @@ void GameState_t::undo_move() {
 	posKey ^= BBS::Zobrist::castling_keys[castleRights];
 
 	fiftyMove = info->fifty_moves;
+	materialKey = info->materialKey;
 
 	// Step 10. Decrement the ply and history ply.
 	ply--;
@@ -752,6 +806,9 @@ Doing a null move
 */
 
 int GameState_t::make_nullmove() {
+	uint64_t parent_key = posKey;
+	int enPas = enPasSq;
+
 	// Step 1. Change side to move
 	side_to_move = (side_to_move == WHITE) ? BLACK : WHITE;
 
@@ -761,17 +818,19 @@ int GameState_t::make_nullmove() {
 	// Step 3. Increment ply
 	ply += 1;
 
-	// Step 4. If there is an en-passant square, return the index and remove it.
+	// Step 4. If there is an en-passant square, remove it.
 	if (enPasSq != NO_SQ) {
-		int enPas = enPasSq;
 		enPasSq = NO_SQ;
 
 		// XOR out the en-passant square
 		posKey ^= BBS::Zobrist::empty_keys[enPas];
-
-		return enPas;
 	}
-	return NO_SQ;
+
+	// Step 5. No pieces have changed, so the network's accumulator is the same as the previous one.
+	accumulators.push(ply, parent_key, posKey);
+
+	// Return the old en-passant square, which undo_nullmove needs.
+	return enPas;
 }
 
 
@@ -891,8 +950,9 @@ GameState_t::GameState_t(const GameState_t& pos) {
 	ply = pos.ply;
 	fiftyMove = pos.fiftyMove;
 
-	// Copy zobrist hashkey
+	// Copy zobrist hashkeys
 	posKey = pos.posKey;
+	materialKey = pos.materialKey;
 
 	// Copy history and history ply
 	std::copy(std::begin(pos.history), std::end(pos.history), std::begin(history));
@@ -1004,6 +1064,7 @@ void GameState_t::mirror_board() {
 	enPasSq = tempEnPas;
 
 	generate_poskey();
+	generate_material_key();
 
 	all_pieces[WHITE] = (pieceBBS[PAWN][WHITE] | pieceBBS[KNIGHT][WHITE] | pieceBBS[BISHOP][WHITE] |
 		pieceBBS[ROOK][WHITE] | pieceBBS[QUEEN][WHITE] | pieceBBS[KING][WHITE]);
@@ -1048,6 +1109,14 @@ bool GameState_t::is_ok() {
 		return false;
 	}
 
+	// The same goes for the material key.
+	uint64_t old_material_key = materialKey;
+	generate_material_key();
+
+	if (materialKey != old_material_key) {
+		return false;
+	}
+
 	// Make sure there are only one king on the board for each side.
 	if (countBits(pieceBBS[KING][WHITE]) != 1 || countBits(pieceBBS[KING][BLACK]) != 1) {
 		return false;
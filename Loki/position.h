@@ -21,6 +21,7 @@
 
 #include "bitboard.h"
 #include "move.h"
+#include "nnue.h"
 
 #if !defined(_MSC_VER)
 #include <cstring> // To use strcpy with GCC
@@ -39,6 +40,7 @@ public:
 	int enPasSq = 0;
 
 	uint64_t posKey = 0;
+	uint64_t materialKey = 0;
 };
 
 
@@ -75,6 +77,13 @@ public:
 	volatile Bitboard posKey = 0;
 	void generate_poskey();
 
+	// The zobrist hash of the material on the board. It only depends on the amount of each piece type for each side.
+	Bitboard materialKey = 0;
+	void generate_material_key();
+
+	// The network accumulators for each ply. make_move records the pieces it changes, and the accumulators are computed when evaluated.
+	mutable NNUE::AccumulatorStack accumulators;
+
 
 	// For making moves on the board.
 	bool make_move(Move_t* move);
@@ -110,6 +119,9 @@ public:
 	// Returns true if we are repeating moves or have reached the fifty-move rule limit.
 	bool is_draw() const;
 
+	// Returns true if the position has been had before.
+	bool is_repetition() const;
+
 	/*
 	SEE functions - the SEE algorithm itself will be implemented later
 	*/
@@ -119,6 +131,9 @@ public:
 
 	int see(unsigned int move) const;
 
+	// Returns true if the static exchange evaluation of the move is at least the threshold. Stops as soon as that is known.
+	bool see_ge(unsigned int move, int threshold) const;
+
 
 	/*
 	Debugging functions
@@ -156,9 +171,6 @@ public:
 	}
 
 private:
-	// Returns true if the position has been had before.
-	bool is_repetition() const;
-
 	// Returns true if the material situation on the board is such that none of the sides can possibly checkmate the other.
 	bool insufficient_material() const;
 
@@ -25,7 +25,7 @@ namespace PSQT {
 #define S(mg, eg) Score(mg, eg)
 
 
-	const Score PawnTable[64] = {
+	TUNABLE_DEF Score PawnTable[64] = {
 		S(0, 0)		,	S(0, 0)		,	S(0, 0)		,	S(0, 0)		,	S(0, 0)		,	S(0, 0)		,	S(0, 0)		,	S(0, 0)		,
 		S(-15, 31)	,	S(15, 31)	,	S(-22, 35)	,	S(-4, 27)	,	S(-2, 7)	,	S(32, 25)	,	S(51, 23)	,	S(1, 5)		,
 		S(-15, 21)	,	S(7, 23)	,	S(4, 11)	,	S(-11, 29)	,	S(13, 17)	,	S(2, 23)	,	S(47, 17)	,	S(-1, 9)	,
@@ -37,7 +37,7 @@ namespace PSQT {
 	};
 
 
-	const Score KnightTable[64] = {
+	TUNABLE_DEF Score KnightTable[64] = {
 		S(-55, -37)	,	S(-14, -10)	,	S(-47, -15)	,	S(-51, 15)	,	S(1, -5)	,	S(-33, 13)	,	S(-12, -36)	,	S(-17, -69)	,
 		S(-57, 5)	,	S(23, -23)	,	S(-11, -11)	,	S(15, -1)	,	S(17, -3)	,	S(19, 5)	,	S(-17, 29)	,	S(-7, -23)	,
 		S(-22, -2)	,	S(-13, 13)	,	S(9, -9)	,	S(5, 19)	,	S(15, 21)	,	S(25, -9)	,	S(37, -19)	,	S(-6, -24)	,
@@ -49,7 +49,7 @@ namespace PSQT {
 	};
 
 
-	const Score BishopTable[64] = {
+	TUNABLE_DEF Score BishopTable[64] = {
 		S(9, -29)	,	S(-16, 23)	,	S(-11, 6)	,	S(-2, 3)	,	S(8, 4)		,	S(-16, 10)	,	S(-34, 18)	,	S(-19, 32)	,
 		S(73, -46)	,	S(17, -14)	,	S(12, -2)	,	S(-1, 1)	,	S(8, 3)		,	S(6, 0)		,	S(36, -10)	,	S(17, -27)	,
 		S(-2, -10)	,	S(19, -12)	,	S(16, -5)	,	S(10, 2)	,	S(13, 8)	,	S(31, -10)	,	S(13, -8)	,	S(10, 8)	,
@@ -60,7 +60,7 @@ namespace PSQT {
 		S(-34, -1)	,	S(-70, -17)	,	S(36, -10)	,	S(3, -37)	,	S(28, -33)	,	S(-94, 32)	,	S(-73, -56)	,	S(-64, -14)	,
 	};
 
-	const Score RookTable[64] = {
+	TUNABLE_DEF Score RookTable[64] = {
 		S(-12, -24)	,	S(2, -20)	,	S(21, -23)	,	S(36, -32)	,	S(41, -40)	,	S(27, -34)	,	S(-40, -8)	,	S(-18, -38)	,
 		S(-38, -14)	,	S(-5, -23)	,	S(-15, -10)	,	S(-1, -13)	,	S(23, -32)	,	S(33, -32)	,	S(-32, 1)	,	S(-77, 4)	,
 		S(-45, -1)	,	S(-9, -14)	,	S(15, -36)	,	S(-14, -15)	,	S(20, -35)	,	S(18, -32)	,	S(14, -30)	,	S(-32, -23)	,
@@ -72,7 +72,7 @@ namespace PSQT {
 	};
 
 
-	const Score QueenTable[64] = {
+	TUNABLE_DEF Score QueenTable[64] = {
 		S(-13, -7)	,	S(-3, -31)	,	S(-1, -3)	,	S(27, -57)	,	S(-3, -7)	,	S(-15, -45)	,	S(-33, -21)	,	S(-41, 11)	,
 		S(-13, -49)	,	S(-17, 5)	,	S(19, -41)	,	S(17, -29)	,	S(27, -35)	,	S(23, -15)	,	S(-3, -33)	,	S(-3, 9)	,
 		S(-27, 27)	,	S(17, -47)	,	S(-7, 13)	,	S(3, -1)	,	S(5, 19)	,	S(7, 31)	,	S(21, 33)	,	S(15, 25)	,
@@ -83,7 +83,7 @@ namespace PSQT {
 		S(-29, -11)	,	S(-23, 47)	,	S(41, 7)	,	S(49, -3)	,	S(25, 41)	,	S(-7, 49)	,	S(-3, 41)	,	S(65, 9)
 	};
 
-	const Score KingTable[64] = {
+	TUNABLE_DEF Score KingTable[64] = {
 		S(-4, -76)	,	S(41, -57)	,	S(21, -42)	,	S(-40, -39)	,	S(29, -55)	,	S(-21, -34)	,	S(46, -63)	, S(33, -96)	,
 		S(-9, -55)	,	S(-3, -39)	,	S(-1, -18)	,	S(-47, -6)	,	S(-35, -4)	,	S(-23, -10)	,	S(13, -29)	, S(15, -49)	,
 		S(-30, -38)	,	S(-16, -22)	,	S(-22, -6)	,	S(-40, 13)	,	S(-36, 13)	,	S(-32, 5)	,	S(-4, -14)	, S(-6, -42)	,
@@ -111,49 +111,4 @@ namespace PSQT {
 
 
 #undef S
-
-
-	/// <summary>
-	/// Compute the manhattan distance between two squares.
-	/// </summary>
-	/// <param name="sq1">The first square</param>
-	/// <param name="sq2">The second square</param>
-	/// <returns>The amount of moves it would take a king to get from sq1 to sq2 and vice versa (Manhattan Distance)</returns>
-	int compute_md(int sq1, int sq2) {
-		int file1, file2, rank1, rank2;
-
-		int rankDistance, fileDistance;
-
-		file1 = sq1 % 8; rank1 = sq1 / 8;
-		file2 = sq2 % 8; rank2 = sq2 / 8;
-
-		rankDistance = abs(rank2 - rank1);
-		fileDistance = abs(file2 - file1);
-
-		return rankDistance + fileDistance;
-	}
-
-
-	int ManhattanDistance[64][64] = {};
-
-	/// <summary>
-	/// Initialize the Manhattan Distance table
-	/// </summary>
-	void initManhattanDistance() {
-
-		for (int sq1 = 0; sq1 < 64; sq1++) {
-
-			for (int sq2 = 0; sq2 < 64; sq2++) {
-				ManhattanDistance[sq1][sq2] = compute_md(sq1, sq2);
-			}
-
-		}
-	}
-
-	/// <summary>
-	/// Initialize the psqt's. For now, it's only the Manhattan-Distance table.
-	/// </summary>
-	void INIT() {
-		initManhattanDistance();
-	}
 }
\ No newline at end of file
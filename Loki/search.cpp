@@ -18,9 +18,6 @@
 #include "search.h"
 
 
-static long long reductions = 0;
-static long long re_searches = 0;
-
 ThreadPool_t* Search::threads = nullptr;
 std::vector<std::thread> Search::threads_running;
 std::atomic<bool> Search::isStop(true);
@@ -28,8 +25,20 @@ std::atomic<bool> Search::isStop(true);
 
 // The checkup function sees if we need to stop the search
 void check_stopped_search(SearchThread_t* ss) {
+	// Stop if the node limit has been reached. For a multithreaded search, only the main thread's nodes count.
+	if (ss->info->node_limit != 0 && ss->info->nodes >= ss->info->node_limit && (ss->thread_id == 0 || ss->standalone)) {
+		ss->info->stopped = true;
+	}
+
+	// A standalone thread only stops by its own limits.
+	if (ss->standalone) {
+		if (ss->info->timeset && getTimeMs() >= ss->info->stoptime) {
+			ss->info->stopped = true;
+		}
+	}
+
 	// Only the 0'th (main) thread should check if the UCI has sent us commands to quit.
-	if (ss->thread_id == 0) {
+	else if (ss->thread_id == 0) {
 		if (ss->info->timeset && getTimeMs() >= ss->info->stoptime) {
 			ss->info->stopped = true;
 		}
@@ -55,24 +64,6 @@ void check_stopped_search(SearchThread_t* ss) {
 
 
 
-void ChangePV(int move, SearchPv* parent, SearchPv* child) {
-	parent->length = child->length + 1;
-	parent->pv[0] = move;
-
-	// Here we copy the PV that the child node found into the parent while keeping the parent's first move as "move"
-	//std::copy(std::begin(child->pv), std::begin(child->pv) + child->length, std::begin(parent->pv) + 1);
-	std::copy(child->pv.begin(), child->pv.begin() + child->length, parent->pv.begin() + 1);
-
-	//if (child->length >= MAXDEPTH) {
-	//	child->length = MAXDEPTH - 1;
-	//}
-	//
-	//for (int i = 0; i < child->length; i++) {
-	//	parent->pv[i + 1] = child->pv[i];
-	//}
-}
-
-
 /*
 
 Search parameter formulas
@@ -81,12 +72,10 @@ Search parameter formulas
 
 // Here the idea is to increase the null move reduction depending on the lead in evaluation: lead = eval - beta.
 int nullmove_reduction(int depth, int lead) {
-	// Make sure not to go out of range. This shouldn't happen too often.
-	if (lead >= 2000) {
-		lead = 1999;
-	}
-	
-	return NM_Reductions[depth][lead];
+	// The lead stops mattering at 6 pawns, so the reduction is computed directly instead of being looked up in a [depth][lead] table.
+	lead = std::min(lead, 1999);
+
+	return (int)std::round(1.5 + 0.25 * double(depth) + std::min(3.0, double(lead) / (2.0 * (double)pawn_value.mg())));
 }
 
 
@@ -145,7 +134,7 @@ bool is_passed(int fromSq, GameState_t* pos) {
 
 // The razoring margin should rise with depth, and on top of that, we do not want to prune too aggresively if our eval is improving
 int razoring_margin(int depth, bool i) {
-	return (2 * pawn_value.mg + (depth - 1) * (pawn_value.mg / 2)) + ((i == true) ? 100 : 0);
+	return (2 * pawn_value.mg() + (depth - 1) * (pawn_value.mg() / 2)) + ((i == true) ? 100 : 0);
 }
 
 
@@ -164,6 +153,10 @@ namespace Search {
 
 		threads_running.clear();
 
+		// If the position is in the tablebases, only the moves that keep the best result are searched.
+		info->tb_cardinality = Syzygy::max_cardinality;
+		Syzygy::root_probe(pos, info->root_moves, info->tb_cardinality);
+
 		ThreadPool_t tp(num_threads);
 		threads = &tp;
 		threads->init_threads(pos, info);
@@ -197,8 +190,14 @@ namespace Search {
 			info->quit = true;
 		}
 
-		// We save the node-count of the main thread to be used by the benchmarking method
+#if defined(SEARCH_STATS)
+		SearchStats::last = getStats();
+#endif
+
+		// We save the node-count and lazy evaluation counts of the main thread to be used by the benchmarking method
 		info->nodes = (threads->at(0))->info->nodes;
+		info->lazy_calls = (threads->at(0))->eval->lazy_calls;
+		info->lazy_exits = (threads->at(0))->eval->lazy_exits;
 
 		isStop = true;
 		threads = nullptr;
@@ -208,64 +207,78 @@ namespace Search {
 	void searchPosition(SearchThread_t* ss) {
 		// Clear ss before searching
 		clearForSearch(ss);
+		ss->best_score = 0;
+		ss->best_move_time = 0;
+		ss->best_move_nodes = 0;
+		ss->best_depth = 0;
+		ss->best_pv.clear();
+
+		// If we're checkmated or stalemated, there is nothing to search and the iterations would never find a move, so we return the result directly.
+		if (!moveGen::has_legal_move(ss->pos)) {
+			ss->best_move = NOMOVE;
+			ss->best_score = (ss->pos->in_check()) ? -INF : 0;
+
+			if (ss->thread_id == 0 && !ss->standalone) {
+				std::cout << "info " << ((ss->best_score != 0) ? "score mate 0" : "score cp 0") << " depth 0" << std::endl;
+				std::cout << "bestmove (none)" << std::endl;
+
+				isStop = true;
+			}
+			return;
+		}
 
 		// Here we get an estimate of the value of the position. Used for creating the aspiration windows
-		SearchPv pvLine;
-		int score = alphabeta(ss, 1, -INF, INF, true, &pvLine);
+		int score = alphabeta(ss, 1, -INF, INF, true);
 		int best_move = NOMOVE;
 
 		// These are just some parameters to print for UCI
 		long long nodes = 0;
 		long long time_to_depth = 0;
 
-		double branching_factor = 0.0;
-
 		long long nps = 0;
-		double move_ordering = 0;
-
-		double reduction_failed = 0.0;
-
-		long long fh;
-		long long fhf;
 
 		// Iterative deepening
 		for (int currDepth = 1; currDepth <= ss->info->depth; currDepth++) {
-			pvLine.clear();
 			ss->info->seldepth = 0; // Clear seldepth
 
 			// Search the position. Use the previous score to center the aspiration windows.
-			score = aspiration_search(ss, currDepth, score, &pvLine);
+			score = aspiration_search(ss, currDepth, score);
 
 			// If we've been asked to stop, break out of the loop. We don't want the new PV from the lates alphabeta call because the tree hasn't been fully
 			// searched, so we'll take the next best, aka last iteration's result.
-			if (ss->info->stopped == true || isStop.load() == true) {
+			if (ss->info->stopped == true || (!ss->standalone && isStop.load() == true)) {
 
 				// If this is the first iteration, we need to get the PV move. Otherwise we'd return NOMOVE which is illegal.
 				if (currDepth == 1) {
-					best_move = pvLine.pv[0];
+					best_move = ss->pv_table.root_line()[0];
 				}
 				
 				assert(best_move != NOMOVE);
 
 				// If we're the main thread, we'll tell the other threads to stop searching
-				if (ss->thread_id == 0) { isStop = true; }
+				if (ss->thread_id == 0 && !ss->standalone) { isStop = true; }
 				break;
 			}
 
-			
-			nodes = getNodes();
-			
-			time_to_depth = getTimeMs() - ss->info->starttime;
-
-			branching_factor = std::pow(nodes, 1 / double(currDepth));
+			// Get the best move from the root's row in the PV table, and remember when it changed.
+			if (int(ss->pv_table.root_line()[0]) != best_move) {
+				ss->best_move_time = getTimeMs() - ss->info->starttime;
+				ss->best_move_nodes = ss->info->nodes;
+			}
 
-			nps = nodes / ((time_to_depth < 1 ? 1 : time_to_depth) / 1000.0); // We need to make sure we don't divide by zero.
-			
-			// Get the best move from the pvLine stack
-			best_move = pvLine.pv[0];
+			best_move = ss->pv_table.root_line()[0];
+			ss->best_score = score;
+			ss->best_depth = currDepth;
+			ss->best_pv.assign(ss->pv_table.root_line(), ss->pv_table.root_line() + ss->pv_table.root_length());
 
 			// Only the "main" thread can print to console
-			if (ss->thread_id == 0) {
+			if (ss->thread_id == 0 && !ss->standalone) {
+				nodes = getNodes();
+
+				time_to_depth = getTimeMs() - ss->info->starttime;
+
+				nps = nodes / ((time_to_depth < 1 ? 1 : time_to_depth) / 1000.0); // We need to make sure we don't divide by zero.
+
 				std::cout << "info ";
 
 				if (abs(score) > MATE) {
@@ -279,44 +292,30 @@ namespace Search {
 					<< " seldepth " << ss->info->seldepth
 					<< " nodes " << nodes
 					<< " nps " << nps
+					<< " tbhits " << getTbHits()
 					<< " time " << time_to_depth;
 				
 				std::cout << " pv ";
 
 				// We need to only display the PV containing the mate, if abs(score) > MATE.
 				// Otherwise we'd get weird lines from previous PV's Loki has found before seeing the mate.
-				for (int n = 0; n < pvLine.length; n++) {
-					assert(pvLine.pv[n] != NOMOVE);
-					std::cout << printMove(pvLine.pv[n]) << " ";
+				for (int n = 0; n < ss->pv_table.root_length(); n++) {
+					assert(ss->pv_table.root_line()[n] != NOMOVE);
+					std::cout << printMove(ss->pv_table.root_line()[n]) << " ";
 				}
 				std::cout << "\n";
 
-				// Print out the move ordering for debugging
-				fh = getFailHigh();
-				fhf = getFailHighFirst();
-				if (fh != 0 && fhf != 0) {
-					move_ordering = (double(fhf) / double(fh)) * 100.0;
-				}
-				else {
-					move_ordering = 0.0;
-				}
-
-				if (re_searches == 0) {
-					reduction_failed = 0.0;
-				}
-				else {
-					reduction_failed = (reductions == 0) ? 0 : (double(re_searches) / double(reductions)) * 100.0;
-				}
-
-				//std::cout << "Move Ordering: " << move_ordering << "%" << std::endl;
-				//std::cout << "Branching factor: " << branching_factor << std::endl;
-				//std::cout << "LMR re-search: " << reduction_failed << "%" << std::endl;
-				//std::cout << "LMR reductions:" << reductions << std::endl;
+#if defined(SEARCH_STATS)
+				// The other threads are still searching, so only this thread's statistics can be read here. runSearch adds up those of all
+				//	threads when they have stopped.
+				SearchStats::print_iteration(getStats(ss), currDepth, ss->info->nodes, ss->info->fh, ss->info->fhf);
+#endif
 			}
 		} // Iterative deepening end
 
+		ss->best_move = best_move;
 
-		if (ss->thread_id == 0) {
+		if (ss->thread_id == 0 && !ss->standalone) {
 
 			std::cout << "bestmove " << printMove(best_move) << std::endl;
 			
@@ -333,31 +332,23 @@ namespace Search {
 
 		ss->info->stopped = false;
 		ss->info->nodes = 0;
+		ss->info->tbhits = 0;
 
 		ss->info->seldepth = 0;
 
 		ss->info->fh = 0;
 		ss->info->fhf = 0;
 
-		reductions = 0;
-		re_searches = 0;
+		ss->eval->lazy_calls = 0;
+		ss->eval->lazy_exits = 0;
 
-		for (int i = 0; i < 64; i++) {
-			for (int j = 0; j < 64; j++) {
-				ss->stats.history[0][i][j] = 0;
-				ss->stats.history[1][i][j] = 0;
-				
-				ss->stats.counterMoves[i][j] = 0;
-			}
-		}
-		
-		for (int d = 0; d < MAXDEPTH; d++) {
-			ss->stats.killers[d][0] = NOMOVE;
-			ss->stats.killers[d][1] = NOMOVE;
-		
-			ss->stats.static_eval[d] = 0;
-			//ss->moves_path[d] = 0;
-		}
+#if defined(SEARCH_STATS)
+		ss->search_stats.clear();
+		ss->eval->table_probes = 0;
+		ss->eval->table_hits = 0;
+#endif
+
+		ss->clear_move_heuristics();
 
 	}
 
@@ -372,7 +363,7 @@ namespace Search {
 	*/
 
 	// Calls search_root with aspiration windows (~10 elo)
-	int aspiration_search(SearchThread_t* ss, int depth, int estimate, SearchPv* line) {
+	int aspiration_search(SearchThread_t* ss, int depth, int estimate) {
 		// Step 1. Initialize some variables
 		int score = -INF;
 
@@ -382,8 +373,8 @@ namespace Search {
 		int delta = aspiration_window;
 
 		// Step 2. Determine whether aspiration windows should be used. Shallow searches are for example so fast that it doesn't make sense.
-		// And if we're in a position with mate scores, we need to search with a full window.
-		if (depth >= aspiration_depth && abs(estimate) < MATE / 2) {
+		// And if we're in a position with mate or tablebase scores, we need to search with a full window.
+		if (depth >= aspiration_depth && abs(estimate) < TB_WIN_IN_MAX_PLY) {
 			alpha_aspirated = std::max(-INF, estimate - delta);
 			beta_aspirated = std::min(INF, estimate + delta);
 		}
@@ -392,7 +383,7 @@ namespace Search {
 		while (true) {
 
 			// Step 3A. Search.
-			score = search_root(ss, depth, alpha_aspirated, beta_aspirated, line);
+			score = search_root(ss, depth, alpha_aspirated, beta_aspirated);
 
 			// Step 3A.1. If we've been told to stop, return.
 			if (ss->info->stopped) { return 0; }
@@ -427,13 +418,15 @@ namespace Search {
 
 
 	// Root alpha beta
-	int search_root(SearchThread_t* ss, int depth, int alpha, int beta, SearchPv* pvLine) {
+	int search_root(SearchThread_t* ss, int depth, int alpha, int beta) {
 		assert(depth > 0);
 
 		ss->info->nodes++;
 
-		pvLine->clear();
-		SearchPv line;
+		ss->pv_table.clear(ss->pos->ply);
+
+		SearchStack_t* stack = ss->stack(ss->pos->ply);
+		stack->move_count = 0;
 		
 		int score = -INF;
 		int best_score = -INF;
@@ -454,7 +447,7 @@ namespace Search {
 		// Step 2. Probe transposition table --> If there is a move from previous iterations, we'll assume the best move from that as the best move now, and
 		//	order that first.
 		bool ttHit = false;
-		EntryData_t* entry = tt->probe_tt(ss->pos->posKey, ttHit);
+		EntryData_t* entry = ss->table()->probe_tt(ss->pos->posKey, ttHit);
 		unsigned int pvMove = (ttHit) ? entry->get_move() : NOMOVE;
 
 
@@ -465,40 +458,41 @@ namespace Search {
 
 		// Step 3. Static evaluation
 		if (in_check) {
-			ss->stats.static_eval[ss->pos->ply] = VALUE_NONE;
+			stack->static_eval = VALUE_NONE;
 		}
-		ss->stats.static_eval[ss->pos->ply] = ss->eval->score(ss->pos);
+		stack->static_eval = ss->eval->score(ss->pos);
 
 
 		// Step 4. Initialize a staged move generation object and loop through all moves.
-		RootMoveStager stager(ss->pos, &ss->stats, pvMove);
+		RootMoveStager stager(ss->pos, &ss->stats, stack, pvMove, ss->info->root_moves);
 
 		Move_t move;
 
 		while (stager.next_move(move)) {
-			line.clear();
+
+			// Set the move we're searching such that the children can use the countermove and continuation histories.
+			stack->current_move = move.move;
+			stack->continuation_history = &ss->stats.continuation_history
+				[piece_index(ss->pos->side_to_move, ss->pos->piece_list[ss->pos->side_to_move][FROMSQ(move.move)])][TOSQ(move.move)];
 
 			if (!ss->pos->make_move(&move)) {
 				continue;
 			}
 
 			legal++;
-
-
-			// Set the previous move such that we can use the countermove heuristic.
-			ss->stats.moves_path[ss->pos->ply] = move.move;
+			stack->move_count++;
 
 
 			// Step 5. Principal Variation search. We search all moves with the full window until one raises alpha. Afterwards we'll search with a null window
 			// If this is the first legal move
 			if (legal == 1) {
-				score = -alphabeta(ss, new_depth - 1, -beta, -alpha, true, &line);
+				score = -alphabeta(ss, new_depth - 1, -beta, -alpha, true);
 			}
 			else {
-				score = -alphabeta(ss, new_depth - 1, -(alpha + 1), -alpha, true, &line);
+				score = -alphabeta(ss, new_depth - 1, -(alpha + 1), -alpha, true);
 
 				if (score > alpha && score < beta) {
-					score = -alphabeta(ss, new_depth - 1, -beta, -alpha, true, &line);
+					score = -alphabeta(ss, new_depth - 1, -beta, -alpha, true);
 				}
 			}
 
@@ -513,7 +507,7 @@ namespace Search {
 				}
 				ss->info->fh++;
 
-				tt->store_entry(ss->pos, move.move, beta, depth, ttFlag::BETA);
+				ss->table()->store_entry(ss->pos, move.move, value_to_tt(beta, ss->pos->ply), depth, ttFlag::BETA);
 
 
 				return beta;
@@ -528,7 +522,7 @@ namespace Search {
 
 					raised_alpha = true;
 
-					ChangePV(best_move, pvLine, &line);
+					ss->pv_table.update(ss->pos->ply, best_move);
 				}
 			}
 		}
@@ -544,12 +538,12 @@ namespace Search {
 		
 		// If we improved alpha, we're in a PV-node
 		if (raised_alpha) {
-			assert(best_move == pvLine->pv[0]);
+			assert(best_move == int(ss->pv_table.root_line()[0]));
 		
-			tt->store_entry(ss->pos, best_move, alpha, depth, ttFlag::EXACT);
+			ss->table()->store_entry(ss->pos, best_move, value_to_tt(alpha, ss->pos->ply), depth, ttFlag::EXACT);
 		}
 		else {
-			tt->store_entry(ss->pos, best_move, alpha, depth, ttFlag::ALPHA);
+			ss->table()->store_entry(ss->pos, best_move, value_to_tt(alpha, ss->pos->ply), depth, ttFlag::ALPHA);
 		}
 	
 		return alpha;
@@ -558,14 +552,14 @@ namespace Search {
 
 
 
-	int alphabeta(SearchThread_t* ss, int depth, int alpha, int beta, bool can_null, SearchPv* pvLine) {
+	int alphabeta(SearchThread_t* ss, int depth, int alpha, int beta, bool can_null) {
 		assert(beta > alpha);
 
 		SIDE Us = ss->pos->side_to_move;
 		SIDE Them = (Us == WHITE) ? BLACK : WHITE;
 
-		// If we return due to pruning, none of the moves in pvLine should be used by parent.
-		pvLine->length = 0;
+		// If we return due to pruning, none of the moves in this ply's PV should be used by parent.
+		ss->pv_table.clear(ss->pos->ply);
 
 
 		// Update seldepth in case we've reached the highest ply so far
@@ -576,7 +570,7 @@ namespace Search {
 
 		// Step 1. Dive into quiescence search (~382 elo)
 		if (depth <= 0) {
-			return quiescence(ss, alpha, beta);
+			return quiescence(ss, 0, alpha, beta);
 		}
 
 		// Update nodes
@@ -605,10 +599,10 @@ namespace Search {
 
 		int reduction = 0; // Only used in moves_loop
 
-		int new_depth;
+		SearchStack_t* stack = ss->stack(ss->pos->ply);
+		stack->move_count = 0;
 
-		// Create a new PV
-		SearchPv line;
+		int new_depth;
 
 		// Idea from stockfish: Are we improving our static evaluations over plies? This can be used for pruning decisions.
 		bool improving = false;
@@ -649,12 +643,18 @@ namespace Search {
 		// Step 4. Transposition table probing (~30 elo - too little?). This is done before quiescence since it is quite fast, and if we can get a cutoff before
 		// going into quiescence, we'll of course use that. Probing before quiescence search contributed with ~17 elo.
 		bool ttHit = false;
-		EntryData_t* entry = tt->probe_tt(ss->pos->posKey, ttHit);
+		EntryData_t* entry = ss->table()->probe_tt(ss->pos->posKey, ttHit);
 		
 		int ttScore = (ttHit) ? value_from_tt(entry->get_score(), ss->pos->ply) : -INF;
 		unsigned int ttMove = (ttHit) ? entry->get_move() : NOMOVE;
 		int ttDepth = (ttHit) ? entry->get_depth() : 0;
 		int tt_flag = (ttHit) ? entry->get_flag() : ttFlag::NO_FLAG;
+
+		if (ttHit) {
+			if (tt_flag == EXACT) { STATS_ADD(ss, TT_HIT_EXACT, depth); }
+			else if (tt_flag == BETA) { STATS_ADD(ss, TT_HIT_LOWER, depth); }
+			else if (tt_flag == ALPHA) { STATS_ADD(ss, TT_HIT_UPPER, depth); }
+		}
 		
 		// If we're not in a PV-node (beta - alpha == 1), we can do a cutoff if the transposition table returned a valid depth.
 		if (ttHit
@@ -662,40 +662,73 @@ namespace Search {
 			&& ttDepth >= depth) {
 		
 			if (tt_flag == BETA && ttScore >= beta) {
+				STATS_ADD(ss, TT_CUTOFF, depth);
 				return beta;
 			}
 		
 			else if (tt_flag == ALPHA && ttScore <= alpha) {
+				STATS_ADD(ss, TT_CUTOFF, depth);
 				return alpha;
 			}
 
 			else if (tt_flag == EXACT) {
+				STATS_ADD(ss, TT_CUTOFF, depth);
 				return ttScore;
 			}
 		}
 
 
+		// Step 4A. Tablebase probing. The tables are only probed right after a capture or pawn move, since there are few of these and the
+		//	tables assume the fifty-move counter is zero. Castling rights aren't in the tables. A result that is exact or outside the window is
+		//	stored in the transposition table with a depth bonus and returned.
+		if (!root_node
+			&& Syzygy::max_cardinality > 0
+			&& ss->pos->fiftyMove == 0
+			&& ss->pos->castleRights == 0
+			&& countBits(ss->pos->all_pieces[WHITE] | ss->pos->all_pieces[BLACK]) <= std::min(Syzygy::max_cardinality, ss->info->tb_cardinality)) {
+
+			Syzygy::ProbeState result;
+			Syzygy::WDLScore wdl = Syzygy::probe_wdl(ss->pos, &result);
+
+			if (result != Syzygy::FAIL) {
+				ss->info->tbhits++;
+
+				// Cursed wins and blessed losses are scored close to a draw.
+				int tb_score = (wdl < Syzygy::WDL_BLESSED_LOSS) ? -TB_WIN + ss->pos->ply
+					: (wdl > Syzygy::WDL_CURSED_WIN) ? TB_WIN - ss->pos->ply
+					: 2 * int(wdl);
+
+				int tb_flag = (wdl < Syzygy::WDL_BLESSED_LOSS) ? ALPHA : (wdl > Syzygy::WDL_CURSED_WIN) ? BETA : EXACT;
+
+				if (tb_flag == EXACT || (tb_flag == BETA && tb_score >= beta) || (tb_flag == ALPHA && tb_score <= alpha)) {
+					ss->table()->store_entry(ss->pos, NOMOVE, value_to_tt(tb_score, ss->pos->ply), std::min(depth + 6, MAXDEPTH - 1), tb_flag);
+					return tb_score;
+				}
+			}
+		}
+
+
 
 		// Step 5. Static evaluation.
 		if (in_check) {
 			// If we're in check, we'll go directly to the moves since we don't want this branch pruned away.
-			ss->stats.static_eval[ss->pos->ply] = VALUE_NONE;
+			stack->static_eval = VALUE_NONE;
 			improving = false;
 		
 			goto moves_loop;
 		}
 		
-		ss->stats.static_eval[ss->pos->ply] = ss->eval->score(ss->pos);
+		stack->static_eval = ss->eval->score(ss->pos);
 		//improving = (ss->pos->ply >= 2) ?
-		//	(ss->stats.static_eval[ss->pos->ply] >= ss->stats.static_eval[ss->pos->ply - 2] || ss->stats.static_eval[ss->pos->ply - 2] == VALUE_NONE) :
+		//	(stack->static_eval >= (stack - 2)->static_eval || (stack - 2)->static_eval == VALUE_NONE) :
 		//	false;
-		improving = (ss->pos->ply >= 2) ? (ss->stats.static_eval[ss->pos->ply] > ss->stats.static_eval[ss->pos->ply - 2]) : false;
+		improving = (ss->pos->ply >= 2) ? (stack->static_eval > (stack - 2)->static_eval) : false;
 
 
 		// Step 6. Null move pruning (~136 elo). FIXME: Improve safe_nullmove and nullmove_reduction, and set moves_path to MOVE_NULL so no unintentional pruning happens.
 		if (can_null && !in_check && !is_pv
 			&& depth > 2 && 
-			ss->stats.static_eval[ss->pos->ply] >= beta &&
+			stack->static_eval >= beta &&
 			ss->pos->safe_nullmove()) {
 		
 			//int R = nullmove_reduction(depth, ss->static_eval[ss->pos->ply] - beta);
@@ -711,22 +744,22 @@ namespace Search {
 				//}
 			}
 			
-			int old_evaluation = ss->stats.static_eval[ss->pos->ply];
+			int old_evaluation = stack->static_eval;
+
+			// When we do a nullmove, we can't rely on the countermove heuristic, so we'll have to set the move to indicate NMP usage
+			stack->current_move = MOVE_NULL;
+			stack->continuation_history = nullptr;
+
 			int old_enpassant = ss->pos->make_nullmove();
+			STATS_ADD(ss, NULL_MOVE_SEARCH, depth);
 			
 			// We want to use another eval here than the one already calculated since the former is inaccurate when the side to move gets switched
-			ss->stats.static_eval[ss->pos->ply] = ss->eval->score(ss->pos);
-		
-			// When we do a nullmove, we can't rely on the countermove heuristic, so we'll have to set the move to indicate NMP usage
-			ss->stats.moves_path[ss->pos->ply] = MOVE_NULL;
+			(stack + 1)->static_eval = ss->eval->score(ss->pos);
 		
-			score = -alphabeta(ss, depth - R - 1, -beta, 1 - beta, false, &line);
-			
-			// Clear the pv
-			line.clear();
+			score = -alphabeta(ss, depth - R - 1, -beta, 1 - beta, false);
 		
 			// Insert the real evaluation again in case we don't get a cutoff.
-			ss->stats.static_eval[ss->pos->ply] = old_evaluation;
+			(stack + 1)->static_eval = old_evaluation;
 			ss->pos->undo_nullmove(old_enpassant);
 		
 			if (score >= beta && abs(score) < MATE) {
@@ -734,7 +767,7 @@ namespace Search {
 				// Step 6A. Verified Null Move Pruning. For high depths, we will want to do a verification search with a null window centered around beta to be sure
 				//if (depth >= 8) {
 				//	// This time, the score is not inside a "make/undo" move, so we shouldn't make it negative or switch the bounds
-				//	score = alphabeta(ss, depth - R - 1, beta - 1, beta, false, &line);
+				//	score = alphabeta(ss, depth - R - 1, beta - 1, beta, false);
 				//
 				//	if (score >= beta && abs(score < MATE)) { // If we're still above beta, it is safe to say, that our null move is good enough
 				//		return beta;
@@ -744,6 +777,7 @@ namespace Search {
 				//else {
 				//	return beta;
 				//}
+				STATS_ADD(ss, NULL_MOVE_CUTOFF, depth);
 				return beta;
 			}
 		}
@@ -754,7 +788,7 @@ namespace Search {
 		//		and skip tactically boring moves from the search
 		if (depth < 7 && !in_check && !is_pv
 			&& abs(alpha) < MATE && abs(beta) < MATE
-			&& ss->stats.static_eval[ss->pos->ply] + futility_margin(depth, improving) <= alpha) {
+			&& stack->static_eval + futility_margin(depth, improving) <= alpha) {
 		
 			futility_pruning = true;
 		}
@@ -766,7 +800,8 @@ namespace Search {
 		
 			int margin = 175 * depth - ((improving) ? 75 : 0);
 			
-			if (ss->stats.static_eval[ss->pos->ply] - margin >= beta) {
+			if (stack->static_eval - margin >= beta) {
+				STATS_ADD(ss, REVERSE_FUTILITY, depth);
 				return beta;
 			}
 		}
@@ -774,20 +809,21 @@ namespace Search {
 		
 		// Step 9. Razoring (~36 elo)
 		if (use_razoring && depth <= razoring_depth && !is_pv &&
-			ss->stats.static_eval[ss->pos->ply] + razoring_margin(depth, improving) <= alpha
+			stack->static_eval + razoring_margin(depth, improving) <= alpha
 			&& !in_check && abs(beta) < MATE && abs(alpha) < MATE && ss->pos->non_pawn_material()) {
 
 			if (depth == 1) {
-				return quiescence(ss, alpha, beta);
+				STATS_ADD(ss, RAZORING, depth);
+				return quiescence(ss, 0, alpha, beta);
 			}
 		
 			int razor_window = alpha - razoring_margin(depth, improving);
 		
-			score = quiescence(ss, razor_window, razor_window + 1);
+			score = quiescence(ss, 0, razor_window, razor_window + 1);
 		
 			// If we couldn't raise the score over alpha - margin, this node is very likely to be an ALL-node
 			if (score <= razor_window) {
-		
+				STATS_ADD(ss, RAZORING, depth);
 				return alpha;
 			}
 		}
@@ -796,7 +832,7 @@ namespace Search {
 		moves_loop:
 
 		// Initialize a movestager object.
-		MoveStager stager(ss->pos, &ss->stats, (ttHit) ? ttMove : NOMOVE, in_check);
+		MoveStager stager(ss->pos, &ss->stats, stack, (ttHit) ? ttMove : NOMOVE, in_check, depth);
 
 		// Step 10. Internal Iterative Deepening (IID) (~21 elo): If the transposition table didn't return a move, we'll search the position to a shallower
 		//		depth in the hopes of finding the PV.
@@ -810,32 +846,39 @@ namespace Search {
 		//	//new_depth = depth - iid_reduction;
 		//	new_depth = depth - (depth / 4) - 1;
 		//
-		//	score = alphabeta(ss, new_depth, alpha, beta, true, &line);
+		//	score = alphabeta(ss, new_depth, alpha, beta, true);
 		//
 		//	// Now we'll set the ttHit and ttMove if we found a good move.
-		//	//if (line.pv[0] != NOMOVE) {
+		//	//if (ss->pv_table.length[ss->pos->ply] > ss->pos->ply) {
 		//	//	ttHit = true;
-		//	//	ttMove = line.pv[0];
+		//	//	ttMove = ss->pv_table.table[ss->pos->ply][ss->pos->ply];
 		//	//}
 		//
 		//	// Step 11B. Probe the transposition table to see if we have found a (probably) best move.
-		//	entry = tt->probe_tt(ss->pos->posKey, ttHit);
+		//	entry = ss->table()->probe_tt(ss->pos->posKey, ttHit);
 		//
 		//	int ttScore = (ttHit) ? value_from_tt(entry->score, ss->pos->ply) : -INF;
 		//	unsigned int ttMove = (ttHit) ? entry->move : NOMOVE;
 		//	int ttDepth = (ttHit) ? entry->depth : 0;
 		//	int tt_flag = (ttHit) ? entry->flag : ttFlag::NO_FLAG;
-		//
-		//	line.clear();
 		//}
 
 		Move_t current_move;
 		int move = NOMOVE;
 		int legal = 0;
-		int moves_searched = 0;
+
+		// The quiet moves and captures searched so far. These will get a history malus if another move fails high.
+		unsigned int quiets_searched[64];
+		unsigned int captures_searched[32];
+		int quiet_count = 0;
+		int capture_count = 0;
 
 		while(stager.next_move(current_move)) {
 			move = current_move.move;
+
+			if (move == int(stack->excluded_move)) {
+				continue;
+			}
 			
 			// Most of the below will first be used when adding proper LMR and LMP, and thus they're commented out.
 			bool capture = (ss->pos->piece_list[Them][TOSQ(move)] != NO_TYPE) ? true : false;
@@ -849,6 +892,15 @@ namespace Search {
 				extensions++;
 			}
 
+			// Determine if a quiet move hangs material. SEE needs the position before the move, so this is done here and used for pruning in Step 13B.
+			bool loses_material = !root_node && !is_pv && !in_check && depth <= see_quiet_depth && best_score > -MATE
+				&& !capture && SPECIAL(move) == NOT_SPECIAL
+				&& !ss->pos->see_ge(move, see_quiet_margin * depth);
+
+			// Set the move we're searching for use in the countermove and continuation histories.
+			stack->current_move = move;
+			stack->continuation_history = &ss->stats.continuation_history[piece_index(Us, ss->pos->piece_list[Us][FROMSQ(move)])][TOSQ(move)];
+
 			// Make the move.
 			if (!ss->pos->make_move(&current_move)) {
 				continue;
@@ -860,15 +912,13 @@ namespace Search {
 			bool gives_check = ss->pos->in_check(); // FIXME: Add function to determine if a move gives check before making it.
 			bool is_tactical = capture || gives_check || in_check || SPECIAL(move) == PROMOTION || SPECIAL(move) == ENPASSANT;
 
-			// Set the move we're searching for use in the countermove heuristic.
-			ss->stats.moves_path[ss->pos->ply] = move;
-
 
 			// Step 12. If we are allowed to use futility pruning, and this move is not tactically significant, prune it.
 			//			We just need to make sure that at least one legal move has been searched since we'd risk getting false mate scores else.
 			if (futility_pruning && 
 				(!is_tactical || (depth <= 1 && current_move.score < 0)) // If we're at a pre-frontier node, we'll also prune moves that are deemed to be bad.
 				&& legal > 0) {
+				STATS_ADD(ss, FUTILITY_PRUNE, depth);
 				ss->pos->undo_move();
 				continue;
 			}
@@ -877,13 +927,22 @@ namespace Search {
 			//			chances are that we won't get one with the quiets. Therefore, if they meet certain criteria, we skip them.
 
 			if (do_lmp && !is_tactical) { // do_lmp is only set if we're not in a pv-node or root node, so we don't need to check this here.
+				STATS_ADD(ss, LMP_PRUNE, depth);
 				ss->pos->undo_move();
 				continue;
 			}
 			else if (!is_tactical && !is_pv && !root_node && best_score > -MATE // We need to have raised alpha at least once.
-				&& moves_searched > late_move_pruning(depth, improving)) {
+				&& stack->move_count > late_move_pruning(depth, improving)) {
 				do_lmp = true;
 
+				STATS_ADD(ss, LMP_PRUNE, depth);
+				ss->pos->undo_move();
+				continue;
+			}
+
+			// Step 13B. SEE pruning. At low depths, quiet moves that don't give check and lose material in a simple exchange are unlikely to be good.
+			if (loses_material && !gives_check) {
+				STATS_ADD(ss, SEE_PRUNE, depth);
 				ss->pos->undo_move();
 				continue;
 			}
@@ -893,15 +952,15 @@ namespace Search {
 			
 			new_depth = depth - 1 + extensions;
 
-			if (moves_searched == 0) {
-				score = -alphabeta(ss, new_depth, -beta, -alpha, true, &line);
+			if (stack->move_count == 0) {
+				score = -alphabeta(ss, new_depth, -beta, -alpha, true);
 			}
 			else {
 				// Step 14A. Late move reductions (~107 elo). If we haven't raised alpha yet, we're probably in an ALL-node,
 				//	so we'll reduce the search depth and do a full-depth re-search if the score is (surprisingly) above alpha
-				if (moves_searched >= lmr_limit && depth >= lmr_depth && !in_check && !root_node) {
+				if (stack->move_count >= lmr_limit && depth >= lmr_depth && !in_check && !root_node) {
 					// Step 14A.1. Initialize the base reduction from a pre-calculated table.
-					int R = late_move_reduction(depth, moves_searched);
+					int R = late_move_reduction(depth, stack->move_count);
 
 					// Step 14A.2. Increase/Decrease the reduction based on different conditions.
 					lmr_conditions(ss, improving, capture, is_pv, gives_check, SPECIAL(move) == PROMOTION, current_move, R);
@@ -910,7 +969,10 @@ namespace Search {
 					int d = std::clamp(depth - 1 - R, 1, depth - 1);
 
 					// Step 14A.4. Now search the move in a null-window centered around alpha.
-					score = -alphabeta(ss, d, -(alpha + 1), -alpha, true, &line);
+					score = -alphabeta(ss, d, -(alpha + 1), -alpha, true);
+
+					STATS_ADD(ss, LMR_SEARCH, depth);
+					if (score > alpha) { STATS_ADD(ss, LMR_RE_SEARCH, depth); }
 				}
 				else {	/* Hack to enter normal search in case LMR isn't applicable */
 					score = alpha + 1;
@@ -918,40 +980,46 @@ namespace Search {
 
 				// Step 14B. If we couldn't do LMR, or the reduced search returned a value above alpha, do a normal search.
 				if (score > alpha) {
-					score = -alphabeta(ss, new_depth, -(alpha + 1), -alpha, true, &line);
+					score = -alphabeta(ss, new_depth, -(alpha + 1), -alpha, true);
 
 					if (score > alpha && score < beta) { // If we raised alpha and stayed inside the bounds, re-search with a full window.
-						score = -alphabeta(ss, new_depth, -beta, -alpha, true, &line);
+						score = -alphabeta(ss, new_depth, -beta, -alpha, true);
 					}
 				}
 
 			}
 
 
-			// Undo the move and increment the moves_searched counter.
+			// Undo the move and increment the move counter.
 			ss->pos->undo_move();
-			moves_searched++;
+			stack->move_count++;
 
 			if (ss->info->stopped) { return 0; }
 
 			if (score >= beta) {
-				if (moves_searched == 1) {
+				if (stack->move_count == 1) {
 					ss->info->fhf++;
 				}
 				ss->info->fh++;
 
-				// Step 14C. If a beta cutoff was achieved, update the quit move ordering heuristics 
-				if (!capture && SPECIAL(move) != PROMOTION && SPECIAL(move) != ENPASSANT) {
-					ss->update_move_heuristics(move, depth, stager.get_moves());
-				}
+				// Step 14C. If a beta cutoff was achieved, update the move ordering heuristics 
+				ss->update_move_heuristics(move, depth, quiets_searched, quiet_count, captures_searched, capture_count);
 				
 				
-				tt->store_entry(ss->pos, move, beta, depth, ttFlag::BETA);
+				ss->table()->store_entry(ss->pos, move, value_to_tt(beta, ss->pos->ply), depth, ttFlag::BETA);
 
 				return beta;
 			}
 
 
+			// Step 14D. Remember the move, so it can be penalized if another one fails high later.
+			if (capture || SPECIAL(move) == ENPASSANT) {
+				if (capture_count < 32) { captures_searched[capture_count++] = move; }
+			}
+			else if (SPECIAL(move) != PROMOTION) {
+				if (quiet_count < 64) { quiets_searched[quiet_count++] = move; }
+			}
+
 			if (score > best_score) {
 				best_score = score;
 				best_move = move;
@@ -960,7 +1028,7 @@ namespace Search {
 					alpha = score;
 
 					// Change PV
-					ChangePV(best_move, pvLine, &line);
+					ss->pv_table.update(ss->pos->ply, best_move);
 				}
 			}
 		}
@@ -977,11 +1045,11 @@ namespace Search {
 
 		
 		if (alpha > old_alpha) {
-			tt->store_entry(ss->pos, best_move, alpha, depth, ttFlag::EXACT);
+			ss->table()->store_entry(ss->pos, best_move, value_to_tt(alpha, ss->pos->ply), depth, ttFlag::EXACT);
 
 		}
 		else{
-			tt->store_entry(ss->pos, best_move, alpha, depth, ttFlag::ALPHA);
+			ss->table()->store_entry(ss->pos, best_move, value_to_tt(alpha, ss->pos->ply), depth, ttFlag::ALPHA);
 		}
 
 
@@ -991,10 +1059,11 @@ namespace Search {
 
 	const int delta_piece_value[5] = { 100, 310, 350, 560, 1000 };
 
-	int quiescence(SearchThread_t* ss, int alpha, int beta) {
+	int quiescence(SearchThread_t* ss, int depth, int alpha, int beta) {
 		assert(beta > alpha);
 		
 		ss->info->nodes++;
+		STATS_ADD(ss, QSEARCH_NODE, 0);
 
 		if ((ss->info->nodes & 2047) == 0) {
 			check_stopped_search(ss);
@@ -1013,26 +1082,26 @@ namespace Search {
 			return ss->eval->score(ss->pos);
 		}
 
+		// If we're in check, we'll search all evasions and can't stand pat, since we would otherwise miss that the side to move might be mated.
+		bool in_check = ss->pos->in_check();
+
 		// Step 2. Static evaluation and possible cutoff if this beats beta.
-		int stand_pat = ss->eval->score(ss->pos);
+		if (!in_check) {
+			int stand_pat = ss->eval->score(ss->pos, alpha, beta);
 
-		assert(stand_pat > -MATE && stand_pat < MATE);
+			assert(stand_pat > -MATE && stand_pat < MATE);
 
-		if (stand_pat >= beta) {
-			return beta;
-		}
+			if (stand_pat >= beta) {
+				return beta;
+			}
 
-		if (alpha < stand_pat) {
-			alpha = stand_pat;
+			if (alpha < stand_pat) {
+				alpha = stand_pat;
+			}
 		}
 
 
-
 		int score = -INF;
-		
-		// If we're in check, we'll generate all moves, since we would otherwise give false mate scores if no captures were available to evade the check
-		// (~20 elo)
-		bool in_check = ss->pos->in_check();
 
 
 
@@ -1042,8 +1111,8 @@ namespace Search {
 		//}
 
 
-		// Step 4. Generation of moves
-		MoveStager stager(ss->pos);
+		// Step 4. Generation of moves. In the first ply of quiescence search, the quiet checks are searched after the captures.
+		MoveStager stager(ss->pos, in_check, depth >= 0);
 
 		int legal = 0;
 		int move = NOMOVE;
@@ -1055,8 +1124,17 @@ namespace Search {
 			int piece_captured = ss->pos->piece_list[(ss->pos->side_to_move == WHITE) ? BLACK : WHITE][TOSQ(move)];
 
 			// Step 5. SEE pruning (~56 elo). If the move is a capture and SEE(move) < 0 (we know this if move->score < 0 for captures), just prune it.
-			if (piece_captured != NO_TYPE && current_move.score < 0) {
-				continue;
+			//	Quiet checks that lose material are pruned as well. None of the evasions are pruned.
+			if (!in_check) {
+				if (piece_captured != NO_TYPE && current_move.score < 0) {
+					STATS_ADD(ss, SEE_PRUNE, 0);
+					continue;
+				}
+
+				if (piece_captured == NO_TYPE && SPECIAL(move) == NOT_SPECIAL && !ss->pos->see_ge(move, 0)) {
+					STATS_ADD(ss, SEE_PRUNE, 0);
+					continue;
+				}
 			}
 			
 			// Step 6. Futility pruning (~30 elo). If the value of the piece captured, plus some margin (~200cp) is still not enough to raise alpha, we won't bother searching it.
@@ -1074,7 +1152,7 @@ namespace Search {
 			legal++;
 
 
-			score = -quiescence(ss, -beta, -alpha);
+			score = -quiescence(ss, depth - 1, -beta, -alpha);
 
 			ss->pos->undo_move();
 
@@ -1097,6 +1175,10 @@ namespace Search {
 			}
 		}
 
+		// Step 7. If we're in check and have no evasions, we're mated.
+		if (in_check && legal == 0) {
+			return -INF + ss->pos->ply;
+		}
 
 		return alpha;
 	}
@@ -1106,7 +1188,7 @@ namespace Search {
 
 	namespace Debug {
 
-		int MDTF(SearchThread_t* ss, int estimate, int depth, SearchPv* pvLine) {
+		int MDTF(SearchThread_t* ss, int estimate, int depth) {
 			int g = estimate;
 
 			int lower = -INF;
@@ -1115,10 +1197,10 @@ namespace Search {
 			while (lower < upper) {
 				int beta = std::max(g, lower + 1);
 
-				g = search_root(ss, depth, beta - 1, beta, pvLine);
+				g = search_root(ss, depth, beta - 1, beta);
 
 				if (g < beta) {
-					pvLine->length = 0;
+					ss->pv_table.clear(ss->pos->ply);
 					upper = g;
 				}
 				else {
@@ -1150,12 +1232,19 @@ SearchInfo_t::SearchInfo_t(const SearchInfo_t& s) {
 	infinite = s.infinite;
 
 	nodes = s.nodes;
+	node_limit = s.node_limit;
+	tbhits = s.tbhits;
+	root_moves = s.root_moves;
+	tb_cardinality = s.tb_cardinality;
 	
 	quit = s.quit;
 	stopped = s.stopped;
 
 	fh = s.fh;
 	fhf = s.fhf;
+
+	lazy_calls = s.lazy_calls;
+	lazy_exits = s.lazy_exits;
 }
 
 
@@ -1176,6 +1265,14 @@ long long getNodes() {
 	return n;
 }
 
+long long getTbHits() {
+	long long n = 0;
+	for (int i = 0; i < Search::threads->count(); i++) {
+		n += (Search::threads->at(i))->info->tbhits;
+	}
+	return n;
+}
+
 long long getFailHigh() {
 	long long n = 0;
 	for (int i = 0; i < Search::threads->count(); i++) {
@@ -1192,6 +1289,23 @@ long long getFailHighFirst() {
 	return n;
 }
 
+#if defined(SEARCH_STATS)
+SearchStats::Table getStats(const SearchThread_t* ss) {
+	SearchStats::Table table = ss->search_stats;
+	table.eval_probes += ss->eval->table_probes;
+	table.eval_hits += ss->eval->table_hits;
+	return table;
+}
+
+SearchStats::Table getStats() {
+	SearchStats::Table table;
+	for (int i = 0; i < Search::threads->count(); i++) {
+		table.add(getStats(Search::threads->at(i)));
+	}
+	return table;
+}
+#endif
+
 
 void uci_moveinfo(int move, int depth, int index) {
 	std::string moveStr = printMove(move);
@@ -1201,7 +1315,7 @@ void uci_moveinfo(int move, int depth, int index) {
 
 
 int to_cp(int score) {
-	return score * (100 / pawn_value.mg);
+	return score * (100 / pawn_value.mg());
 }
 
 int to_mate(int score) {
@@ -1215,36 +1329,27 @@ int to_mate(int score) {
 ---------------------------------- INITIALIZATION ----------------------------------
 ====================================================================================
 */
-int MvvLva[6][6] = { {0} };
-
 int Reductions[MAXDEPTH][MAXPOSITIONMOVES] = { {0} };
 int LMP_Limit[MAXDEPTH] = { 0 };
 
-int NM_Reductions[MAXDEPTH][2000] = { {0} };
-
 void Search::INIT() {
 
-	// Initialize MvvLva.
-	int victim_scores[6] = { 100, 200, 300, 400, 500, 600 };
+	// Initialize table of late move reductions. The logarithms are computed once for every argument instead of once for every entry.
+	double logarithms[MAXPOSITIONMOVES] = { 0 };
 
-	for (int victim = KING; victim >= PAWN; victim--) {
-		for (int attacker = KING; attacker >= PAWN; attacker--) {
-
-			MvvLva[attacker][victim] = victim_scores[victim] + (6 - attacker);
-
-		}
+	for (int n = 1; n < MAXPOSITIONMOVES; n++) {
+		logarithms[n] = std::log(2.0 * double(n));
 	}
 
-	// Initialize table of late move reductions
-	for (double d = 1; d < MAXDEPTH; d += 1.0) {
+	for (int d = 1; d < MAXDEPTH; d++) {
 
-		for (double c = 1; c < MAXPOSITIONMOVES; c += 1.0) {
+		for (int c = 1; c < MAXPOSITIONMOVES; c++) {
 
 			//Reductions[(int)d][(int)c] = 1.75 + (int)std::round((std::log(3.0 * d) * std::log(3.0 * c)) / 5.5);
-			Reductions[(int)d][(int)c] = (int)std::round((std::log(2.0 * d) * std::log(2.0 * c)) / 5.5);
+			Reductions[d][c] = (int)std::round((logarithms[d] * logarithms[c]) / 5.5);
 
-			if (Reductions[(int)d][(int)c] < 1) {
-				Reductions[(int)d][(int)c] = 1;
+			if (Reductions[d][c] < 1) {
+				Reductions[d][c] = 1;
 			}
 
 		}
@@ -1267,14 +1372,4 @@ void Search::INIT() {
 		// Note: Since the growth is exponential, we'll cut it at 256 (max moves in a position).
 		LMP_Limit[(int)d] = static_cast<int>(std::min(uint64_t(std::round(1.73 * std::exp(0.53 * d))), (uint64_t)MAXPOSITIONMOVES));
 	}
-
-	// Initialize null move R-value table
-	for (int d = 0; d < MAXDEPTH; d++) {
-
-		for (int lead = 0; lead < 2000; lead++) {
-			// This is set so as to not reduce by more than six plies under any circumstance
-			//NM_Reductions[d][lead] = ((d > 6) ? 3 : 2) + std::max(0, std::min(3, (int)std::round(1.5 * std::log(std::pow(lead / 100, 2)))));
-			NM_Reductions[d][lead] = (int)std::round(1.5 + 0.25 * double(d) + std::min(3.0, double(lead) / (2.0 * (double)pawn_value.mg)));
-		}
-	}
 }
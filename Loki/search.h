@@ -23,6 +23,7 @@
 
 #include "transposition.h"
 #include "evaluation.h"
+#include "syzygy.h"
 
 
 #include <cmath>
@@ -31,17 +32,6 @@
 #include <vector>
 #include <array>
 
-struct SearchPv {
-	int length = 0;
-	std::array<int, MAXDEPTH + 1> pv = { 0 };
-
-	void clear() {
-		pv.fill(0);
-		length = 0;
-	}
-};
-
-
 namespace Search {
 	extern ThreadPool_t* threads;
 	extern std::vector<std::thread> threads_running;
@@ -58,17 +48,17 @@ namespace Search {
 	// Clears the SearchThread_t before beginning a search in searchPosition.
 	void clearForSearch(SearchThread_t* ss);
 
-	int aspiration_search(SearchThread_t* ss, int depth, int estimate, SearchPv* line);
+	int aspiration_search(SearchThread_t* ss, int depth, int estimate);
 
-	int search_root(SearchThread_t* ss, int depth, int alpha, int beta, SearchPv* pvLine);
+	int search_root(SearchThread_t* ss, int depth, int alpha, int beta);
 
-	int alphabeta(SearchThread_t* ss, int depth, int alpha, int beta, bool can_null, SearchPv* pvLine);
+	int alphabeta(SearchThread_t* ss, int depth, int alpha, int beta, bool can_null);
 
-	int quiescence(SearchThread_t* ss, int alpha, int beta);
+	int quiescence(SearchThread_t* ss, int depth, int alpha, int beta);
 
 	namespace Debug {
 		// MTDF is useful for debugging the transposition table as suggested by Tord Romstad on the WinBoard forum.
-		int MDTF(SearchThread_t* ss, int estimate, int depth, SearchPv* pvLine);
+		int MDTF(SearchThread_t* ss, int estimate, int depth);
 	}
 
 	void INIT();
@@ -83,7 +73,6 @@ Helper function for search parameters.
 /*
 NMP
 */
-extern int NM_Reductions[MAXDEPTH][2000];
 extern int nullmove_reduction(int depth, int lead);
 
 /*
@@ -119,12 +108,16 @@ Helper functions for search in general
 
 extern void check_stopped_search(SearchThread_t* ss);
 
-extern void ChangePV(int move, SearchPv* parent, SearchPv* child);
-
 
 extern long long getNodes();
+extern long long getTbHits();
 extern long long getFailHigh();
 extern long long getFailHighFirst();
+#if defined(SEARCH_STATS)
+// The statistics of one thread, and the sum of all threads. The sum may only be taken when the other threads have stopped.
+extern SearchStats::Table getStats(const SearchThread_t* ss);
+extern SearchStats::Table getStats();
+#endif
 
 extern void uci_moveinfo(int move, int depth, int index);
 
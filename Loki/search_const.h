@@ -17,6 +17,7 @@
 */
 #ifndef SEARCH_CONST_H
 #define SEARCH_CONST_H
+#include <algorithm>
 
 
 
@@ -37,11 +38,28 @@ Counter moves
 */
 constexpr int countermove_bonus = 70000;
 
+/*
+History heuristics
+*/
+// The bound of all history tables. Quiet scores are at most three of these added together, which must stay below the killer and countermove scores.
+constexpr int HISTORY_MAX = 16384;
+
+inline int history_bonus(int depth) {
+	return std::min(16 * depth * depth, 1200);
+}
+
 /*
 Captures
 */
-// Indexed by MvvLva[attacker][victim]
-extern int MvvLva[6][6];
+// Indexed by MvvLva[attacker][victim]. The victim's value dominates and the cheaper attacker breaks ties.
+constexpr int MvvLva[6][6] = {
+	{ 105, 205, 305, 405, 505, 605 },
+	{ 104, 204, 304, 404, 504, 604 },
+	{ 103, 203, 303, 403, 503, 603 },
+	{ 102, 202, 302, 402, 502, 602 },
+	{ 101, 201, 301, 401, 501, 601 },
+	{ 100, 200, 300, 400, 500, 600 }
+};
 
 
 /*
@@ -65,6 +83,12 @@ constexpr int lmr_limit = 3;
 constexpr int lmr_depth = 2;
 constexpr int lmr_pieceVals[5] = { 100, 300, 300, 500, 900 };
 
+/*
+SEE pruning of quiet moves
+*/
+constexpr int see_quiet_depth = 6;
+constexpr int see_quiet_margin = -100; // The SEE threshold is see_quiet_margin * depth.
+
 /*
 Razoring
 */
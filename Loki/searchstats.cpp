@@ -0,0 +1,149 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "searchstats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+
+namespace SearchStats {
+
+	const char* event_names[EVENT_NB] = {
+		"tt_hit_exact", "tt_hit_lower", "tt_hit_upper", "tt_cutoff",
+		"null_move_search", "null_move_cutoff",
+		"reverse_futility", "razoring", "futility_prune", "lmp_prune", "see_prune",
+		"lmr_search", "lmr_re_search",
+		"qsearch_node"
+	};
+
+	Table last;
+
+
+	void Table::add(const Table& other) {
+		for (int d = 0; d <= MAXDEPTH; d++) {
+			for (int e = 0; e < EVENT_NB; e++) {
+				counts[d][e] += other.counts[d][e];
+			}
+		}
+
+		eval_probes += other.eval_probes;
+		eval_hits += other.eval_hits;
+	}
+
+
+	long long Table::total(Event e) const {
+		long long n = 0;
+
+		for (int d = 0; d <= MAXDEPTH; d++) {
+			n += counts[d][e];
+		}
+
+		return n;
+	}
+
+
+	void print_iteration(const Table& table, int depth, long long nodes, long long fail_highs, long long fail_high_firsts) {
+		std::cout << "info string stats depth " << depth;
+
+		for (int e = 0; e < EVENT_NB; e++) {
+			std::cout << " " << event_names[e] << " " << table.total(Event(e));
+		}
+
+		std::cout << " eval_probes " << table.eval_probes << " eval_hits " << table.eval_hits;
+
+		// The share of fail-highs on the first move, the effective branching factor and the share of reduced searches that had to be redone.
+		long long lmr_searches = table.total(LMR_SEARCH);
+
+		std::cout << std::fixed << std::setprecision(1)
+			<< " move_ordering " << ((fail_highs > 0) ? 100.0 * double(fail_high_firsts) / double(fail_highs) : 0.0)
+			<< " branching_factor " << std::setprecision(2) << std::pow(double(std::max(nodes, 1LL)), 1.0 / double(depth))
+			<< " lmr_re_search_rate " << std::setprecision(1)
+			<< ((lmr_searches > 0) ? 100.0 * double(table.total(LMR_RE_SEARCH)) / double(lmr_searches) : 0.0) << std::endl;
+
+		std::cout.unsetf(std::ios::floatfield);
+	}
+
+
+	std::string to_json(const Table& table) {
+		std::ostringstream json;
+
+		// Step 1. The totals.
+		json << "{\n  \"totals\": {";
+		for (int e = 0; e < EVENT_NB; e++) {
+			json << (e > 0 ? ", " : " ") << "\"" << event_names[e] << "\": " << table.total(Event(e));
+		}
+		json << ", \"eval_probes\": " << table.eval_probes << ", \"eval_hits\": " << table.eval_hits << " },\n";
+
+		// Step 2. The counts of each depth, leaving out the depths where nothing happened.
+		json << "  \"depths\": [";
+
+		bool first = true;
+		for (int d = 0; d <= MAXDEPTH; d++) {
+			bool empty = true;
+			for (int e = 0; e < EVENT_NB; e++) {
+				empty &= (table.counts[d][e] == 0);
+			}
+
+			if (empty) {
+				continue;
+			}
+
+			json << (first ? "\n" : ",\n") << "    { \"depth\": " << d;
+			for (int e = 0; e < EVENT_NB; e++) {
+				json << ", \"" << event_names[e] << "\": " << table.counts[d][e];
+			}
+			json << " }";
+
+			first = false;
+		}
+
+		json << "\n  ]\n}";
+
+		return json.str();
+	}
+
+
+	void parse(const std::string& command) {
+#if !defined(SEARCH_STATS)
+		(void)command;
+		std::cout << "info string stats: search statistics aren't collected in this build. Build with search_stats=yes" << std::endl;
+#else
+		std::istringstream ss(command);
+		std::string token, path;
+		ss >> token >> path; // "stats [file]"
+
+		if (path.empty()) {
+			std::cout << to_json(last) << std::endl;
+			return;
+		}
+
+		std::ofstream file(path);
+		if (!file) {
+			std::cout << "info string stats: could not open " << path << std::endl;
+			return;
+		}
+
+		file << to_json(last) << std::endl;
+		std::cout << "info string stats written to " << path << std::endl;
+#endif
+	}
+}
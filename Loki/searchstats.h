@@ -0,0 +1,97 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+#include "defs.h"
+
+#include <cstring>
+#include <string>
+
+
+/*
+
+Statistics of the search, for tuning the pruning and reductions. They are only collected in builds with SEARCH_STATS defined ("make
+search_stats=yes"), and otherwise the STATS_ADD macro is empty, so normal builds pay nothing for them.
+
+Every thread counts the events of its own search by the remaining depth of the node they happen in, with the quiescence search at depth zero.
+After each iteration, the main thread prints its own counts as an "info string stats" line, since the other threads are still writing theirs.
+When the search is done, the counts of all threads are added up and kept, and the "stats" command prints them as JSON.
+
+*/
+namespace SearchStats {
+
+	enum Event : int {
+		TT_HIT_EXACT, TT_HIT_LOWER, TT_HIT_UPPER, TT_CUTOFF,
+		NULL_MOVE_SEARCH, NULL_MOVE_CUTOFF,
+		REVERSE_FUTILITY, RAZORING, FUTILITY_PRUNE, LMP_PRUNE, SEE_PRUNE,
+		LMR_SEARCH, LMR_RE_SEARCH,
+		QSEARCH_NODE,
+		EVENT_NB
+	};
+
+	extern const char* event_names[EVENT_NB];
+
+
+	struct Table {
+		// Indexed by [depth][event].
+		long long counts[MAXDEPTH + 1][EVENT_NB];
+
+		// The probes and hits of the evaluation hash table. These aren't split by depth.
+		long long eval_probes = 0;
+		long long eval_hits = 0;
+
+		Table() {
+			clear();
+		}
+
+		void clear() {
+			std::memset(counts, 0, sizeof(counts));
+			eval_probes = eval_hits = 0;
+		}
+
+		inline void add(Event e, int depth) {
+			counts[(depth < 0) ? 0 : (depth > MAXDEPTH) ? MAXDEPTH : depth][e]++;
+		}
+
+		void add(const Table& other);
+
+		long long total(Event e) const;
+	};
+
+	// The sum of the tables of the last search.
+	extern Table last;
+
+	// Prints the totals of a table, and the move ordering, branching factor and LMR re-search rate, as an "info string stats" line.
+	void print_iteration(const Table& table, int depth, long long nodes, long long fail_highs, long long fail_high_firsts);
+
+	// The table as a JSON object with the totals and the counts of every depth where something happened.
+	std::string to_json(const Table& table);
+
+	// Parses a "stats [file]" command. The last search's statistics are written to the file, or printed if none is given.
+	void parse(const std::string& command);
+}
+
+
+#if defined(SEARCH_STATS)
+#define STATS_ADD(ss, event, depth) ((ss)->search_stats.add(SearchStats::event, (depth)))
+#else
+#define STATS_ADD(ss, event, depth) ((void)0)
+#endif
+
+
+#endif
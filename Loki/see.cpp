@@ -234,4 +234,109 @@ int GameState_t::see(unsigned int move) const {
 	}
 
 	return gain[0];
-}
\ No newline at end of file
+}
+
+
+
+/*
+
+Threshold version of the static exchange evaluation. Instead of building the whole swap-list, we keep track of the balance relative to the
+threshold and stop as soon as it is clear which side of it the exchange ends on. Works for quiet moves too, where it tells if the piece moved
+can be won by the opponent.
+
+*/
+
+TARGET_CLONES bool GameState_t::see_ge(unsigned int move, int threshold) const {
+
+	// Step 1. Special moves (castling, en-passant and promotions) are considered as being neutral.
+	if (SPECIAL(move) != NOT_SPECIAL) {
+		return 0 >= threshold;
+	}
+
+	int from_sq = FROMSQ(move);
+	int to_sq = TOSQ(move);
+	SIDE Them = (side_to_move == WHITE) ? BLACK : WHITE;
+
+	// Step 2. If capturing the piece on to_sq isn't enough to reach the threshold, we lose.
+	int captured = piece_list[Them][to_sq];
+	int swap = ((captured == NO_TYPE) ? 0 : see_pieces[captured]) - threshold;
+	if (swap < 0) {
+		return false;
+	}
+
+	// Step 3. If we're still above the threshold after losing the piece moved, we win.
+	swap = see_pieces[piece_list[side_to_move][from_sq]] - swap;
+	if (swap <= 0) {
+		return true;
+	}
+
+	// Step 4. Initialize the occupancy and attackers. The sliders are stored since they are needed for the x-rays.
+	Bitboard occupied = (all_pieces[WHITE] | all_pieces[BLACK]) ^ (uint64_t(1) << from_sq) ^ (uint64_t(1) << to_sq);
+	Bitboard attackers = attackers_to(to_sq, occupied);
+
+	Bitboard diagonal_sliders = pieceBBS[BISHOP][WHITE] | pieceBBS[BISHOP][BLACK] | pieceBBS[QUEEN][WHITE] | pieceBBS[QUEEN][BLACK];
+	Bitboard orthogonal_sliders = pieceBBS[ROOK][WHITE] | pieceBBS[ROOK][BLACK] | pieceBBS[QUEEN][WHITE] | pieceBBS[QUEEN][BLACK];
+
+	SIDE stm = side_to_move;
+	Bitboard stm_attackers = 0, b = 0;
+
+	// res is the result if the side to move can't recapture. It flips every time a side recaptures.
+	int res = 1;
+
+	// Step 5. Let the sides recapture with their least valuable attacker until one of them runs out, or the result is decided.
+	while (true) {
+		stm = (stm == WHITE) ? BLACK : WHITE;
+		attackers &= occupied;
+
+		// Step 5A. If the side to move has no more attackers, it loses the exchange.
+		if ((stm_attackers = attackers & all_pieces[stm]) == 0) {
+			break;
+		}
+
+		res ^= 1;
+
+		// Step 5B. Find the least valuable attacker. If capturing with it keeps the balance on the side of the previous result, we can stop.
+		//	Otherwise remove it from the board and add the sliders that attack through it.
+		if ((b = stm_attackers & pieceBBS[PAWN][stm]) != 0) {
+			if ((swap = see_pieces[PAWN] - swap) < res) { break; }
+
+			occupied ^= uint64_t(1) << bitScanForward(b);
+			attackers |= Magics::attacks_bb<BISHOP>(to_sq, occupied) & diagonal_sliders;
+		}
+
+		else if ((b = stm_attackers & pieceBBS[KNIGHT][stm]) != 0) {
+			if ((swap = see_pieces[KNIGHT] - swap) < res) { break; }
+
+			occupied ^= uint64_t(1) << bitScanForward(b);
+		}
+
+		else if ((b = stm_attackers & pieceBBS[BISHOP][stm]) != 0) {
+			if ((swap = see_pieces[BISHOP] - swap) < res) { break; }
+
+			occupied ^= uint64_t(1) << bitScanForward(b);
+			attackers |= Magics::attacks_bb<BISHOP>(to_sq, occupied) & diagonal_sliders;
+		}
+
+		else if ((b = stm_attackers & pieceBBS[ROOK][stm]) != 0) {
+			if ((swap = see_pieces[ROOK] - swap) < res) { break; }
+
+			occupied ^= uint64_t(1) << bitScanForward(b);
+			attackers |= Magics::attacks_bb<ROOK>(to_sq, occupied) & orthogonal_sliders;
+		}
+
+		else if ((b = stm_attackers & pieceBBS[QUEEN][stm]) != 0) {
+			if ((swap = see_pieces[QUEEN] - swap) < res) { break; }
+
+			occupied ^= uint64_t(1) << bitScanForward(b);
+			attackers |= (Magics::attacks_bb<BISHOP>(to_sq, occupied) & diagonal_sliders)
+				| (Magics::attacks_bb<ROOK>(to_sq, occupied) & orthogonal_sliders);
+		}
+
+		// Step 5C. The king can only recapture if the opponent has no attackers left.
+		else {
+			return ((attackers & ~all_pieces[stm]) != 0) ? (res ^ 1) : res;
+		}
+	}
+
+	return bool(res);
+}
@@ -0,0 +1,375 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "solve.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+
+namespace Solve {
+
+	namespace {
+
+		/// <summary>
+		/// The outcome of searching a test position.
+		/// </summary>
+		struct Result {
+			std::string san;
+			int score = 0;
+
+			// True if the position has a bm or am opcode, and if the search ended on a move that satisfies them.
+			bool checked = false;
+			bool solved = false;
+
+			long long solution_time = 0;
+			long solution_nodes = 0;
+			long nodes = 0;
+		};
+
+
+		/*
+
+		Remove check marks and annotations from a move, and write castling with the letter O.
+
+		*/
+		std::string normalize(std::string san) {
+			while (!san.empty() && std::string("+#!?").find(san.back()) != std::string::npos) {
+				san.pop_back();
+			}
+
+			std::replace(san.begin(), san.end(), '0', 'O');
+
+			return san;
+		}
+
+
+		/*
+
+		See if a move is in a list of EPD moves. The moves may be in standard algebraic notation or in the coordinate notation of UCI.
+
+		*/
+		bool contains(const std::vector<std::string>& moves, const std::string& san, unsigned int move) {
+			for (const std::string& m : moves) {
+				if (normalize(m) == san || m == printMove(move)) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+
+		/*
+
+		Search a test position with the threads. With more than one thread, they all search the position at the same time and share the
+		transposition table, and the first thread's move is played. A position without legal moves has no move, and it is failed if it
+		has solutions.
+
+		*/
+		Result search_position(std::vector<SearchThread_t*>& threads, const TestPosition& tp, const Settings& settings) {
+			// Step 1. Set up the position and limits of all threads.
+			for (SearchThread_t* thread : threads) {
+				thread->pos->parseFen(tp.fen);
+
+				thread->info->clear();
+				thread->info->starttime = getTimeMs();
+				thread->info->stoptime = thread->info->starttime + settings.movetime;
+				thread->info->timeset = true;
+				thread->info->depth = settings.depth;
+			}
+
+			// Step 2. Search.
+			if (threads.size() == 1) {
+				Search::searchPosition(threads[0]);
+			}
+			else {
+				std::vector<std::thread> running;
+
+				for (SearchThread_t* thread : threads) {
+					running.push_back(std::thread(Search::searchPosition, thread));
+				}
+				for (auto& t : running) {
+					t.join();
+				}
+			}
+
+			// Step 3. Compare the move of the first thread to the solutions.
+			SearchThread_t* main = threads[0];
+			Result r;
+
+			r.san = to_san(main->pos, main->best_move);
+			r.score = main->best_score;
+			r.solution_time = main->best_move_time;
+			r.solution_nodes = main->best_move_nodes;
+
+			for (SearchThread_t* thread : threads) {
+				r.nodes += thread->info->nodes;
+			}
+
+			r.checked = !tp.best_moves.empty() || !tp.avoid_moves.empty();
+			r.solved = r.checked && (tp.best_moves.empty() || contains(tp.best_moves, r.san, main->best_move))
+				&& !contains(tp.avoid_moves, r.san, main->best_move);
+
+			return r;
+		}
+
+
+		void print_result(size_t index, const TestPosition& tp, const Result& r) {
+			std::cout << "info string solve " << (index + 1) << " " << (tp.id.empty() ? std::string("-") : tp.id) << " ";
+
+			if (!r.checked) {
+				std::cout << r.san << " score " << r.score;
+			}
+			else if (r.solved) {
+				std::cout << "solved " << r.san << " time " << r.solution_time << " nodes " << r.solution_nodes;
+			}
+			else {
+				std::cout << "failed " << r.san;
+
+				for (const std::string& m : tp.best_moves) { std::cout << " bm " << m; }
+				for (const std::string& m : tp.avoid_moves) { std::cout << " am " << m; }
+			}
+
+			std::cout << std::endl;
+		}
+	}
+
+
+	std::vector<TestPosition> read_epd(const std::string& path) {
+		std::vector<TestPosition> positions;
+		std::ifstream file(path);
+		std::string line;
+
+		while (std::getline(file, line)) {
+			std::istringstream ss(line);
+			std::string fields[4];
+
+			// Step 1. The first four fields are the board, the side to move, the castling rights and the en-passant square.
+			if (!(ss >> fields[0] >> fields[1] >> fields[2] >> fields[3]) || fields[0][0] == '#') {
+				continue;
+			}
+
+			TestPosition tp;
+			tp.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+
+			// Step 2. The operations are separated by semicolons, and are an opcode followed by its operands.
+			std::string rest;
+			std::getline(ss, rest);
+			std::istringstream operations(rest);
+			std::string operation;
+
+			while (std::getline(operations, operation, ';')) {
+				std::istringstream op(operation);
+				std::string opcode, operand;
+				op >> opcode;
+
+				while (op >> operand) {
+					if (opcode == "bm") { tp.best_moves.push_back(operand); }
+					else if (opcode == "am") { tp.avoid_moves.push_back(operand); }
+					else if (opcode == "id") { tp.id += (tp.id.empty() ? "" : " ") + operand; }
+				}
+			}
+
+			tp.id.erase(std::remove(tp.id.begin(), tp.id.end(), '"'), tp.id.end());
+			positions.push_back(tp);
+		}
+
+		return positions;
+	}
+
+
+	std::string to_san(GameState_t* pos, unsigned int move) {
+		const std::string PIECE_LETTERS = "PNBRQK";
+
+		if (move == NOMOVE) {
+			return "(none)";
+		}
+
+		int from_sq = FROMSQ(move);
+		int to_sq = TOSQ(move);
+		SIDE side = pos->side_to_move;
+		SIDE Them = (side == WHITE) ? BLACK : WHITE;
+		int pce = pos->piece_list[side][from_sq];
+
+		// Step 1. Castling.
+		if (SPECIAL(move) == CASTLING) {
+			return (to_sq > from_sq) ? "O-O" : "O-O-O";
+		}
+
+		bool capture = pos->piece_list[Them][to_sq] != NO_TYPE || SPECIAL(move) == ENPASSANT;
+		std::string san;
+
+		// Step 2. Pawn moves are written with the file they capture from and the promotion piece.
+		if (pce == PAWN) {
+			san += (capture) ? FILES[from_sq % 8] + "x" : "";
+			san += index_to_uci(to_sq);
+
+			if (SPECIAL(move) == PROMOTION) {
+				san += std::string("=") + PIECE_LETTERS[KNIGHT + PROMTO(move)];
+			}
+			return san;
+		}
+
+		// Step 3. Other moves have the piece letter and, if another piece of the same type can move to the same square, its file, rank or both.
+		san += PIECE_LETTERS[pce];
+
+		bool ambiguous = false, same_file = false, same_rank = false;
+		for (unsigned int other : moveGen::legal_moves(pos)) {
+			int other_from = FROMSQ(other);
+
+			if (other == move || int(TOSQ(other)) != to_sq || pos->piece_list[side][other_from] != pce) {
+				continue;
+			}
+
+			ambiguous = true;
+			same_file |= (other_from % 8 == from_sq % 8);
+			same_rank |= (other_from / 8 == from_sq / 8);
+		}
+
+		if (ambiguous) {
+			san += (!same_file) ? FILES[from_sq % 8] : ((!same_rank) ? std::to_string(from_sq / 8 + 1) : index_to_uci(from_sq));
+		}
+
+		san += (capture) ? "x" : "";
+		san += index_to_uci(to_sq);
+
+		return san;
+	}
+
+
+	void run(const Settings& settings) {
+		// Step 1. Read the positions.
+		std::vector<TestPosition> positions;
+
+		if (settings.source == "builtin") {
+			for (const std::string& fen : test_positions) {
+				positions.push_back(TestPosition{ fen, "", {}, {} });
+			}
+		}
+		else {
+			positions = read_epd(settings.source);
+		}
+
+		if (positions.empty()) {
+			std::cout << "info string solve: no positions in " << settings.source << std::endl;
+			return;
+		}
+
+		tt->clear_table();
+		long long start = getTimeMs();
+
+		std::vector<Result> results(positions.size());
+
+		// Step 2A. Search the positions one at a time with all threads. The transposition table is cleared between them, so the result of a
+		//	position doesn't depend on the ones before it.
+		if (settings.sequential) {
+			std::vector<SearchThread_t*> threads;
+
+			for (int t = 0; t < settings.threads; t++) {
+				threads.push_back(new SearchThread_t);
+				threads.back()->thread_id = t;
+				threads.back()->standalone = true;
+			}
+
+			for (size_t i = 0; i < positions.size(); i++) {
+				tt->clear_table();
+
+				results[i] = search_position(threads, positions[i], settings);
+				print_result(i, positions[i], results[i]);
+			}
+
+			for (SearchThread_t* thread : threads) {
+				delete thread;
+			}
+		}
+
+		// Step 2B. Search settings.threads positions at a time with one thread each. The results are printed in the order of the positions.
+		//	Every thread has its own part of the Hash size as a transposition table, which is cleared between positions like in Step 2A, and
+		//	the shared table is shrunk to the minimum size until they are done.
+		else {
+			TableResizeGuard table_guard(settings.threads);
+			std::vector<SearchThread_t*> threads;
+
+			for (int t = 0; t < settings.threads; t++) {
+				threads.push_back(new SearchThread_t);
+				threads.back()->thread_id = t;
+				threads.back()->standalone = true;
+				threads.back()->own_table = table_guard.thread_table();
+			}
+
+			run_ordered(positions.size(), settings.threads,
+				[&](int id, size_t i) {
+					std::vector<SearchThread_t*> thread = { threads[id] };
+					thread[0]->own_table->clear_table();
+
+					results[i] = search_position(thread, positions[i], settings);
+				},
+				[&](size_t i) { print_result(i, positions[i], results[i]); });
+
+			for (SearchThread_t* thread : threads) {
+				delete thread->own_table;
+				delete thread;
+			}
+		}
+
+		// Step 3. Print the totals. The time and nodes to solution are summed over the solved positions.
+		int checked = 0, solved = 0;
+		long long solution_time = 0, solution_nodes = 0, nodes = 0;
+
+		for (const Result& r : results) {
+			checked += r.checked;
+			solved += r.solved;
+			solution_time += (r.solved) ? r.solution_time : 0;
+			solution_nodes += (r.solved) ? r.solution_nodes : 0;
+			nodes += r.nodes;
+		}
+
+		double seconds = std::max(getTimeMs() - start, 1LL) / 1000.0;
+
+		std::cout << "info string solve done: " << solved << "/" << checked << " solved, time to solution " << solution_time << "ms, nodes to solution "
+			<< solution_nodes << ", " << positions.size() << " positions and " << nodes << " nodes in " << std::fixed << std::setprecision(1)
+			<< seconds << "s" << std::endl;
+	}
+
+
+	void parse(const std::string& command) {
+		Settings settings;
+
+		std::istringstream ss(command);
+		std::string token;
+		ss >> token; // "solve"
+
+		if (ss >> token) {
+			settings.source = token;
+		}
+
+		while (ss >> token) {
+			if (token == "movetime") { ss >> settings.movetime; }
+			else if (token == "depth") { ss >> settings.depth; }
+			else if (token == "threads") { ss >> settings.threads; }
+			else if (token == "sequential") { settings.sequential = true; }
+		}
+
+		settings.movetime = std::max(settings.movetime, 1);
+		settings.depth = std::clamp(settings.depth, 1, MAXDEPTH);
+		settings.threads = std::clamp(settings.threads, THREADS_MIN_NUM, THREADS_MAX_NUM);
+
+		run(settings);
+	}
+}
@@ -0,0 +1,71 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef SOLVE_H
+#define SOLVE_H
+#include "search.h"
+
+#include <string>
+#include <vector>
+
+
+/*
+
+Test suite solving. The positions of an EPD file are searched with a fixed time or depth, and the best move is compared to the "bm" (best move)
+and "am" (avoid move) opcodes. A position is solved when the search ends on a best move and not on a move to avoid, and its time and nodes to
+solution are those of the iteration where the final best move was first found.
+
+The positions are either searched concurrently with one single-threaded search per thread, each with its own transposition table, or one at a
+time with all the threads searching the same position and sharing the transposition table. In the second case, the nodes to solution are those
+of the first thread. The tables are cleared before every position, so a search at a fixed depth doesn't depend on the other positions.
+
+*/
+namespace Solve {
+
+	/// <summary>
+	/// A test position. The moves are in standard algebraic notation as in the EPD file.
+	/// </summary>
+	struct TestPosition {
+		std::string fen;
+		std::string id;
+		std::vector<std::string> best_moves;
+		std::vector<std::string> avoid_moves;
+	};
+
+	// Reads the positions of an EPD file. Lines that can't be parsed are skipped.
+	std::vector<TestPosition> read_epd(const std::string& path);
+
+	// Returns the move in standard algebraic notation without check marks, like "Nbd7", "exd6", "e8=Q" or "O-O".
+	std::string to_san(GameState_t* pos, unsigned int move);
+
+
+	struct Settings {
+		std::string source = "builtin";	// An EPD file, or "builtin" for the positions of test_positions.h, which have no solutions.
+		int movetime = 1000;			// The time of each search in milliseconds.
+		int depth = MAXDEPTH;			// The depth of each search.
+		int threads = 1;
+		bool sequential = false;		// Search the positions one at a time with all threads.
+	};
+
+	void run(const Settings& settings);
+
+	// Parses a "solve <file|builtin> [movetime ms] [depth d] [threads t] [sequential]" command and runs it.
+	void parse(const std::string& command);
+}
+
+
+#endif
@@ -0,0 +1,1352 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "syzygy.h"
+#include "movegen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#if (defined(_WIN32) || defined(_WIN64))
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace Syzygy {
+
+	int max_cardinality = 0;
+
+
+	namespace {
+
+		constexpr int TB_PIECES = 7;
+
+		// The rank of a root move that wins within the fifty-move rule. It is larger than any DTZ plus fifty-move counter, so the ranks of slow
+		//	wins and of losses never overlap those of cursed wins, draws and blessed losses.
+		constexpr int MAX_DTZ = 1 << 18;
+
+		enum TBType { WDL, DTZ };
+
+		// The flags of the PairsData of a table.
+		enum TBFlag : int { STM = 1, MAPPED = 2, WIN_PLIES = 4, LOSS_PLIES = 8, WIDE = 16, SINGLE_VALUE = 128 };
+
+		constexpr uint8_t WDL_MAGIC[4] = { 0x71, 0xE8, 0x23, 0x5D };
+		constexpr uint8_t DTZ_MAGIC[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+		const std::string PIECE_CHARS = "PNBRQK";
+
+#if (defined(_WIN32) || defined(_WIN64))
+		constexpr char PATH_SEPARATOR = ';';
+#else
+		constexpr char PATH_SEPARATOR = ':';
+#endif
+
+
+		/*
+		Helpers for squares and pieces. The tables encode pieces as 1..6 for white's pawn to king, and 9..14 for black's.
+		*/
+		inline int tb_piece(SIDE side, int pce) { return pce + 1 + ((side == WHITE) ? 0 : 8); }
+
+		inline int file_of(int sq) { return sq & 7; }
+		inline int rank_of(int sq) { return sq >> 3; }
+
+		// Positive above the a1-h8 diagonal, negative below it and zero on it.
+		inline int off_A1H8(int sq) { return rank_of(sq) - file_of(sq); }
+
+		inline int sign_of(int x) { return (x > 0) - (x < 0); }
+
+
+		/*
+		Reads from the mapped files. The headers are little-endian and the Huffman codes big-endian.
+		*/
+		inline uint16_t read_le16(const uint8_t* p) { return uint16_t(p[0] | (p[1] << 8)); }
+		inline uint32_t read_le32(const uint8_t* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+		inline uint32_t read_be32(const uint8_t* p) { return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]); }
+		inline uint64_t read_be64(const uint8_t* p) { return (uint64_t(read_be32(p)) << 32) | read_be32(p + 4); }
+
+
+		/*
+		The indexing tables, computed by INIT.
+		*/
+		int MapPawns[64];			// Squares a2-h7 to 0..47. The pawn with the highest value is the leading one.
+		int MapB1H1H7[64];			// Squares below the a1-h8 diagonal to 0..27.
+		int MapA1D1D4[64];			// Squares in the a1-d1-d4 triangle to 0..9.
+		int MapKK[10][64];			// The 462 legal placements of two kings, the first one in the a1-d1-d4 triangle.
+		uint64_t Binomial[6][64];	// Binomial[k][n] is the number of ways to choose k of n squares.
+		int LeadPawnIdx[6][64];		// The first index of a leading pawn square, by the number of leading pawns.
+		int LeadPawnsSize[6][4];	// The number of indices of the leading pawns on each file.
+
+		inline bool pawns_comp(int i, int j) { return MapPawns[i] < MapPawns[j]; }
+
+
+		/*
+		The data needed to decompress one part of a table. A table has a part for each side to move, and for pawn tables for each file of the
+		leading pawn as well.
+		*/
+		struct PairsData {
+			uint8_t flags = 0;
+			size_t block_size = 0;						// The size of a block of Huffman codes in bytes.
+			size_t span = 0;							// There is a sparse index entry for every span values.
+			uint32_t num_blocks = 0;
+			int max_sym_len = 0;
+			int min_sym_len = 0;						// The value of the table if it is SINGLE_VALUE.
+			const uint8_t* lowest_sym = nullptr;		// uint16_t for each code length.
+			const uint8_t* btree = nullptr;				// Three bytes for each symbol with its left and right child.
+			const uint8_t* block_length = nullptr;		// uint16_t for each block.
+			uint32_t block_length_size = 0;
+			const uint8_t* sparse_index = nullptr;		// Six bytes for each entry, the block as uint32_t and an offset as uint16_t.
+			size_t sparse_index_size = 0;
+			const uint8_t* data = nullptr;
+			std::vector<uint64_t> base64;
+			std::vector<uint8_t> symlen;				// The number of values a symbol expands into, minus one.
+			int pieces[TB_PIECES] = { 0 };
+			uint64_t group_idx[TB_PIECES + 1] = { 0 };
+			int group_len[TB_PIECES + 1] = { 0 };
+			uint16_t map_idx[4] = { 0 };				// DTZ tables only.
+
+			inline int left(int sym) const { const uint8_t* lr = btree + 3 * sym; return ((lr[1] & 0xF) << 8) | lr[0]; }
+			inline int right(int sym) const { const uint8_t* lr = btree + 3 * sym; return (lr[2] << 4) | (lr[1] >> 4); }
+		};
+
+
+		/*
+		A WDL or DTZ table of one material configuration, like "KRPvKR". A table is stored with the stronger side as white, so it serves both the
+		position with key and the one with the colors switched, key2.
+		*/
+		struct Table {
+			TBType type = WDL;
+			std::string code;
+
+			std::atomic<bool> ready{ false };
+			std::mutex mutex;
+
+			const void* mapping = nullptr;
+			size_t mapping_size = 0;
+#if (defined(_WIN32) || defined(_WIN64))
+			HANDLE file_handle = INVALID_HANDLE_VALUE;
+			HANDLE mapping_handle = nullptr;
+#endif
+
+			const uint8_t* map = nullptr;		// The value maps of DTZ tables.
+
+			uint64_t key = 0;
+			uint64_t key2 = 0;
+			int piece_count = 0;
+			bool has_pawns = false;
+			bool has_unique_pieces = false;
+			uint8_t pawn_count[2] = { 0 };		// The pawns of the leading side and of the other side.
+
+			PairsData items[2][4];				// Indexed by [side to move][file of the leading pawn].
+
+			Table(TBType t, const std::string& c);
+			~Table() { unmap(); }
+
+			void unmap();
+
+			inline int sides() const { return (type == WDL && key != key2) ? 2 : 1; }
+			inline PairsData* get(int stm, int f) { return &items[(type == WDL) ? stm % 2 : 0][has_pawns ? f : 0]; }
+		};
+
+
+		/*
+		Compute the material key of the position of a table code, with the first side as white if white_first is set.
+		*/
+		uint64_t material_key(const std::string& code, bool white_first) {
+			uint64_t key = 0;
+			int counts[2][6] = { { 0 } };
+
+			SIDE side = (white_first) ? WHITE : BLACK;
+
+			for (char c : code) {
+				if (c == 'v') {
+					side = (side == WHITE) ? BLACK : WHITE;
+					continue;
+				}
+				int pce = int(PIECE_CHARS.find(c));
+				key ^= BBS::Zobrist::piece_keys[side][pce][counts[side][pce]++];
+			}
+
+			return key;
+		}
+
+
+		Table::Table(TBType t, const std::string& c) : type(t), code(c) {
+			key = material_key(code, true);
+			key2 = material_key(code, false);
+
+			int counts[2][6] = { { 0 } };
+			int side = 0;
+			for (char ch : code) {
+				if (ch == 'v') { side = 1; continue; }
+				counts[side][PIECE_CHARS.find(ch)]++;
+				piece_count++;
+			}
+
+			has_pawns = (counts[0][PAWN] + counts[1][PAWN]) > 0;
+
+			for (int s = 0; s < 2; s++) {
+				for (int pce = PAWN; pce < KING; pce++) {
+					if (counts[s][pce] == 1) {
+						has_unique_pieces = true;
+					}
+				}
+			}
+
+			// The leading side is the one with the fewest pawns, since that compresses best. It is the first side if the other one has none.
+			bool first_leads = counts[1][PAWN] == 0 || (counts[0][PAWN] != 0 && counts[1][PAWN] >= counts[0][PAWN]);
+
+			pawn_count[0] = uint8_t(counts[first_leads ? 0 : 1][PAWN]);
+			pawn_count[1] = uint8_t(counts[first_leads ? 1 : 0][PAWN]);
+		}
+
+
+		void Table::unmap() {
+			if (mapping == nullptr) {
+				return;
+			}
+
+#if (defined(_WIN32) || defined(_WIN64))
+			UnmapViewOfFile(mapping);
+			CloseHandle(mapping_handle);
+			CloseHandle(file_handle);
+#else
+			munmap(const_cast<void*>(mapping), mapping_size);
+#endif
+			mapping = nullptr;
+		}
+
+
+		std::vector<std::string> directories;
+
+		// The tables are kept in deques so their addresses don't change as more are added.
+		std::deque<Table> wdl_tables;
+		std::deque<Table> dtz_tables;
+
+		std::unordered_map<uint64_t, std::pair<Table*, Table*>> tables;
+
+
+		/// <summary>
+		/// Open a table file in the first directory that has it.
+		/// </summary>
+		/// <returns>The full path, or an empty string if it wasn't found.</returns>
+		std::string find_file(const std::string& name) {
+			for (const std::string& dir : directories) {
+				std::string path = dir + "/" + name;
+
+				if (std::ifstream(path).is_open()) {
+					return path;
+				}
+			}
+			return "";
+		}
+
+
+		/// <summary>
+		/// Map the file of a table into memory and check its magic number.
+		/// </summary>
+		/// <returns>A pointer past the magic number, or nullptr if the file couldn't be mapped.</returns>
+		const uint8_t* map_file(Table& e) {
+			std::string path = find_file(e.code + ((e.type == WDL) ? ".rtbw" : ".rtbz"));
+			if (path.empty()) {
+				return nullptr;
+			}
+
+#if (defined(_WIN32) || defined(_WIN64))
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return nullptr;
+			}
+
+			LARGE_INTEGER size;
+			HANDLE mapping = (GetFileSizeEx(file, &size)) ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+			const void* view = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+			if (view == nullptr) {
+				if (mapping != nullptr) {
+					CloseHandle(mapping);
+				}
+				CloseHandle(file);
+				return nullptr;
+			}
+
+			e.file_handle = file;
+			e.mapping_handle = mapping;
+			e.mapping = view;
+			e.mapping_size = size_t(size.QuadPart);
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				return nullptr;
+			}
+
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+				close(fd);
+				return nullptr;
+			}
+
+			void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+			close(fd);
+
+			if (view == MAP_FAILED) {
+				return nullptr;
+			}
+			madvise(view, size_t(st.st_size), MADV_RANDOM);
+
+			e.mapping = view;
+			e.mapping_size = size_t(st.st_size);
+#endif
+
+			// Every table file is a 4-byte magic number followed by data padded to 64 bytes, and 12 bytes of checksum.
+			const uint8_t* data = static_cast<const uint8_t*>(e.mapping);
+			const uint8_t* magic = (e.type == WDL) ? WDL_MAGIC : DTZ_MAGIC;
+
+			if (e.mapping_size % 64 != 16 || std::memcmp(data, magic, 4) != 0) {
+				std::cout << "info string Corrupted tablebase file " << path << std::endl;
+				return nullptr;
+			}
+
+			return data + 4;
+		}
+
+
+
+		/*
+		==================================================================================================================================
+		-------------------------------------------------------- DECOMPRESSION -----------------------------------------------------------
+		==================================================================================================================================
+
+		The values of a table are compressed with Recursive Pairing, where the most frequent pair of adjacent symbols is replaced by a new symbol
+		over and over. The resulting symbols are Huffman coded in blocks of block_size bytes, and the sparse index gives the block and offset of
+		every span'th value.
+		*/
+
+		int decompress_pairs(const PairsData* d, uint64_t idx) {
+
+			// Step 1. All positions of some tables have the same value.
+			if (d->flags & SINGLE_VALUE) {
+				return d->min_sym_len;
+			}
+
+			// Step 2. Find the sparse index entry of idx. It is for the value in the middle of its span.
+			uint32_t k = uint32_t(idx / d->span);
+
+			uint32_t block = read_le32(d->sparse_index + 6 * size_t(k));
+			int offset = read_le16(d->sparse_index + 6 * size_t(k) + 4);
+
+			offset += int(idx % d->span) - int(d->span / 2);
+
+			// Step 3. Move to the block that has the value. A block holds block_length + 1 values.
+			while (offset < 0) {
+				offset += read_le16(d->block_length + 2 * size_t(--block)) + 1;
+			}
+
+			while (offset > read_le16(d->block_length + 2 * size_t(block))) {
+				offset -= read_le16(d->block_length + 2 * size_t(block++)) + 1;
+			}
+
+			// Step 4. Decode symbols from the start of the block until the one that holds the value at offset.
+			const uint8_t* ptr = d->data + uint64_t(block) * d->block_size;
+
+			uint64_t buf64 = read_be64(ptr); ptr += 8;
+			int buf64_size = 64;
+			int sym;
+
+			while (true) {
+				int len = 0; // The length of the code minus min_sym_len.
+
+				// The codes are canonical, so longer codes have smaller values and the length can be found from base64.
+				while (buf64 < d->base64[len]) {
+					len++;
+				}
+
+				sym = int((buf64 - d->base64[len]) >> (64 - len - d->min_sym_len));
+				sym += read_le16(d->lowest_sym + 2 * size_t(len));
+
+				if (offset < d->symlen[sym] + 1) {
+					break;
+				}
+
+				offset -= d->symlen[sym] + 1;
+				len += d->min_sym_len;
+				buf64 <<= len;
+				buf64_size -= len;
+
+				// Refill the buffer.
+				if (buf64_size <= 32) {
+					buf64_size += 32;
+					buf64 |= uint64_t(read_be32(ptr)) << (64 - buf64_size);
+					ptr += 4;
+				}
+			}
+
+			// Step 5. Expand the symbol into its pair until the value is reached.
+			while (d->symlen[sym]) {
+				int l = d->left(sym);
+
+				if (offset < d->symlen[l] + 1) {
+					sym = l;
+				}
+				else {
+					offset -= d->symlen[l] + 1;
+					sym = d->right(sym);
+				}
+			}
+
+			return d->left(sym);
+		}
+
+
+
+		/*
+		==================================================================================================================================
+		------------------------------------------------------------ INDEXING ------------------------------------------------------------
+		==================================================================================================================================
+		*/
+
+		// DTZ tables only store one side to move, unless the table is symmetric.
+		bool check_dtz_stm(Table& e, int stm, int f) {
+			if (e.type == WDL) {
+				return true;
+			}
+
+			int flags = e.get(stm, f)->flags;
+			return (flags & STM) == stm || (e.key == e.key2 && !e.has_pawns);
+		}
+
+
+		// WDL values are stored as 0..4, and DTZ values are sorted by frequency for each result and have to be mapped back.
+		int map_score(Table& e, int f, int value, WDLScore wdl) {
+			if (e.type == WDL) {
+				return value - 2;
+			}
+
+			constexpr int WDLMap[] = { 1, 3, 0, 2, 0 };
+
+			const PairsData* d = e.get(0, f);
+			int flags = d->flags;
+
+			if (flags & MAPPED) {
+				int idx = d->map_idx[WDLMap[wdl + 2]] + value;
+				value = (flags & WIDE) ? read_le16(e.map + 2 * size_t(idx)) : e.map[idx];
+			}
+
+			// The tables store moves or plies. We want plies.
+			if ((wdl == WDL_WIN && !(flags & WIN_PLIES)) || (wdl == WDL_LOSS && !(flags & LOSS_PLIES))
+				|| wdl == WDL_CURSED_WIN || wdl == WDL_BLESSED_LOSS) {
+				value *= 2;
+			}
+
+			return value + 1;
+		}
+
+
+		/*
+		Compute the index of a position in a table and look up its value.
+		*/
+		int do_probe_table(const GameState_t* pos, Table& e, WDLScore wdl, ProbeState* result) {
+			int squares[TB_PIECES];
+			int pieces[TB_PIECES];
+			uint64_t idx;
+			int next = 0, size = 0, lead_pawns_count = 0;
+			Bitboard b, lead_pawns = 0;
+			int tb_file = 0;
+
+			// Step 1. The tables are stored with the stronger side as white, and symmetric ones only with white to move. Otherwise the colors
+			//	are switched and the board flipped.
+			bool symmetric_black_to_move = (e.key == e.key2 && pos->side_to_move == BLACK);
+			bool black_stronger = (pos->materialKey != e.key);
+
+			bool flip = symmetric_black_to_move || black_stronger;
+			int flip_color = flip * 8;
+			int flip_squares = flip * 56;
+			int stm = flip ^ (pos->side_to_move == WHITE ? 0 : 1);
+
+			// Step 2. Pawn tables have a part for each file a-d of the leading pawn, which is the one closest to the edge and on the lowest rank.
+			if (e.has_pawns) {
+				int pc = e.get(0, 0)->pieces[0] ^ flip_color;
+				SIDE lead_side = (pc & 8) ? BLACK : WHITE;
+
+				lead_pawns = b = pos->pieceBBS[PAWN][lead_side];
+				do {
+					squares[size++] = PopBit(&b) ^ flip_squares;
+				} while (b);
+
+				lead_pawns_count = size;
+
+				std::swap(squares[0], *std::max_element(squares, squares + lead_pawns_count, pawns_comp));
+
+				tb_file = file_of(squares[0]);
+				if (tb_file > 3) {
+					tb_file = file_of(squares[0] ^ 7);
+				}
+			}
+
+			if (!check_dtz_stm(e, stm, tb_file)) {
+				*result = CHANGE_STM;
+				return 0;
+			}
+
+			// Step 3. Add the rest of the pieces and order them like the table does.
+			b = (pos->all_pieces[WHITE] | pos->all_pieces[BLACK]) ^ lead_pawns;
+			do {
+				int sq = PopBit(&b);
+				SIDE side = (pos->piece_list[WHITE][sq] != NO_TYPE) ? WHITE : BLACK;
+
+				squares[size] = sq ^ flip_squares;
+				pieces[size++] = tb_piece(side, pos->piece_list[side][sq]) ^ flip_color;
+			} while (b);
+
+			PairsData* d = e.get(stm, tb_file);
+
+			for (int i = lead_pawns_count; i < size - 1; i++) {
+				for (int j = i + 1; j < size; j++) {
+					if (d->pieces[i] == pieces[j]) {
+						std::swap(pieces[i], pieces[j]);
+						std::swap(squares[i], squares[j]);
+						break;
+					}
+				}
+			}
+
+			// Step 4. Mirror the board so the first square is on the a-d files.
+			if (file_of(squares[0]) > 3) {
+				for (int i = 0; i < size; i++) {
+					squares[i] ^= 7;
+				}
+			}
+
+			// Step 5. Encode the leading pawns.
+			if (e.has_pawns) {
+				idx = LeadPawnIdx[lead_pawns_count][squares[0]];
+
+				std::stable_sort(squares + 1, squares + lead_pawns_count, pawns_comp);
+
+				for (int i = 1; i < lead_pawns_count; i++) {
+					idx += Binomial[i][MapPawns[squares[i]]];
+				}
+			}
+
+			// Step 6. Without pawns, the board is also flipped so the first piece is below the fifth rank and below the a1-h8 diagonal.
+			else {
+				if (rank_of(squares[0]) > 3) {
+					for (int i = 0; i < size; i++) {
+						squares[i] ^= 56;
+					}
+				}
+
+				for (int i = 0; i < d->group_len[0]; i++) {
+					if (!off_A1H8(squares[i])) {
+						continue;
+					}
+
+					if (off_A1H8(squares[i]) > 0) {
+						for (int j = i; j < size; j++) {
+							squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+						}
+					}
+					break;
+				}
+
+				// Step 6A. With at least three unique pieces, the first three are encoded together. Otherwise it is only the kings.
+				if (e.has_unique_pieces) {
+					int adjust1 = squares[1] > squares[0];
+					int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+					if (off_A1H8(squares[0])) {
+						idx = (MapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+					}
+					else if (off_A1H8(squares[1])) {
+						idx = (6 * 63 + rank_of(squares[0]) * 28 + MapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+					}
+					else if (off_A1H8(squares[2])) {
+						idx = 6 * 63 * 62 + 4 * 28 * 62 + rank_of(squares[0]) * 7 * 28 + (rank_of(squares[1]) - adjust1) * 28 + MapB1H1H7[squares[2]];
+					}
+					else {
+						idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rank_of(squares[0]) * 7 * 6 + (rank_of(squares[1]) - adjust1) * 6
+							+ (rank_of(squares[2]) - adjust2);
+					}
+				}
+				else {
+					idx = MapKK[MapA1D1D4[squares[0]]][squares[1]];
+				}
+			}
+
+			// Step 7. Encode the remaining groups of pieces. A square is moved down for each square of the earlier groups below it.
+			idx *= d->group_idx[0];
+			int* group_sq = squares + d->group_len[0];
+
+			bool remaining_pawns = e.has_pawns && e.pawn_count[1];
+
+			while (d->group_len[++next]) {
+				std::stable_sort(group_sq, group_sq + d->group_len[next]);
+				uint64_t n = 0;
+
+				for (int i = 0; i < d->group_len[next]; i++) {
+					int adjust = int(std::count_if(squares, group_sq, [&](int s) { return group_sq[i] > s; }));
+					n += Binomial[i + 1][group_sq[i] - adjust - 8 * remaining_pawns];
+				}
+
+				remaining_pawns = false;
+				idx += n * d->group_idx[next];
+				group_sq += d->group_len[next];
+			}
+
+			return map_score(e, tb_file, decompress_pairs(d, idx), wdl);
+		}
+
+
+
+		/*
+		==================================================================================================================================
+		---------------------------------------------------------- TABLE SETUP -----------------------------------------------------------
+		==================================================================================================================================
+		*/
+
+		/*
+		Split the pieces of a table part into groups that are encoded together, and compute the factor of each group in the index.
+		*/
+		void set_groups(Table& e, PairsData* d, const int order[], int f) {
+			int n = 0;
+			int first_len = (e.has_pawns) ? 0 : (e.has_unique_pieces) ? 3 : 2;
+			d->group_len[n] = 1;
+
+			for (int i = 1; i < e.piece_count; i++) {
+				if (--first_len > 0 || d->pieces[i] == d->pieces[i - 1]) {
+					d->group_len[n]++;
+				}
+				else {
+					d->group_len[++n] = 1;
+				}
+			}
+			d->group_len[++n] = 0;
+
+			// The order of the groups in the index is stored in the table. The leading group is at order[0], and the remaining pawns at order[1].
+			bool pp = e.has_pawns && e.pawn_count[1];
+			int next = (pp) ? 2 : 1;
+			int free_squares = 64 - d->group_len[0] - ((pp) ? d->group_len[1] : 0);
+			uint64_t idx = 1;
+
+			for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+				if (k == order[0]) {
+					d->group_idx[0] = idx;
+					idx *= (e.has_pawns) ? LeadPawnsSize[d->group_len[0]][f] : (e.has_unique_pieces) ? 31332 : 462;
+				}
+				else if (k == order[1]) {
+					d->group_idx[1] = idx;
+					idx *= Binomial[d->group_len[1]][48 - d->group_len[0]];
+				}
+				else {
+					d->group_idx[next] = idx;
+					idx *= Binomial[d->group_len[next]][free_squares];
+					free_squares -= d->group_len[next++];
+				}
+			}
+
+			d->group_idx[n] = idx;
+		}
+
+
+		uint8_t set_symlen(PairsData* d, int s, std::vector<bool>& visited) {
+			visited[s] = true;
+			int sr = d->right(s);
+
+			if (sr == 0xFFF) {
+				return 0;
+			}
+
+			int sl = d->left(s);
+
+			if (!visited[sl]) {
+				d->symlen[sl] = set_symlen(d, sl, visited);
+			}
+			if (!visited[sr]) {
+				d->symlen[sr] = set_symlen(d, sr, visited);
+			}
+
+			return uint8_t(d->symlen[sl] + d->symlen[sr] + 1);
+		}
+
+
+		/*
+		Read the sizes and the Huffman code of a table part.
+		*/
+		const uint8_t* set_sizes(PairsData* d, const uint8_t* data) {
+			d->flags = *data++;
+
+			if (d->flags & SINGLE_VALUE) {
+				d->num_blocks = 0;
+				d->span = 0;
+				d->block_length_size = 0;
+				d->sparse_index_size = 0;
+				d->min_sym_len = *data++;
+				return data;
+			}
+
+			// The last group index is the size of the table.
+			uint64_t tb_size = d->group_idx[std::find(d->group_len, d->group_len + TB_PIECES, 0) - d->group_len];
+
+			d->block_size = size_t(1) << *data++;
+			d->span = size_t(1) << *data++;
+			d->sparse_index_size = size_t((tb_size + d->span - 1) / d->span);
+			int padding = *data++;
+			d->num_blocks = read_le32(data); data += 4;
+			d->block_length_size = d->num_blocks + padding;
+			d->max_sym_len = *data++;
+			d->min_sym_len = *data++;
+			d->lowest_sym = data;
+			d->base64.resize(size_t(d->max_sym_len - d->min_sym_len + 1));
+
+			// base64[i] is the lowest code of length i + min_sym_len, left-aligned in 64 bits.
+			for (int i = int(d->base64.size()) - 2; i >= 0; i--) {
+				d->base64[i] = (d->base64[i + 1] + read_le16(d->lowest_sym + 2 * size_t(i)) - read_le16(d->lowest_sym + 2 * size_t(i + 1))) / 2;
+			}
+
+			for (size_t i = 0; i < d->base64.size(); i++) {
+				d->base64[i] <<= 64 - i - d->min_sym_len;
+			}
+
+			data += d->base64.size() * 2;
+			d->symlen.resize(read_le16(data)); data += 2;
+			d->btree = data;
+
+			std::vector<bool> visited(d->symlen.size());
+
+			for (size_t sym = 0; sym < d->symlen.size(); sym++) {
+				if (!visited[sym]) {
+					d->symlen[sym] = set_symlen(d, int(sym), visited);
+				}
+			}
+
+			return data + d->symlen.size() * 3 + (d->symlen.size() & 1);
+		}
+
+
+		/*
+		Read the value maps of a DTZ table.
+		*/
+		const uint8_t* set_dtz_map(Table& e, const uint8_t* data, int max_file) {
+			if (e.type == WDL) {
+				return data;
+			}
+
+			e.map = data;
+
+			for (int f = 0; f <= max_file; f++) {
+				PairsData* d = e.get(0, f);
+
+				if (d->flags & MAPPED) {
+					if (d->flags & WIDE) {
+						data += uintptr_t(data) & 1;
+
+						for (int i = 0; i < 4; i++) {
+							d->map_idx[i] = uint16_t((data - e.map) / 2 + 1);
+							data += 2 * size_t(read_le16(data)) + 2;
+						}
+					}
+					else {
+						for (int i = 0; i < 4; i++) {
+							d->map_idx[i] = uint16_t(data - e.map + 1);
+							data += *data + 1;
+						}
+					}
+				}
+			}
+
+			return data + (uintptr_t(data) & 1);
+		}
+
+
+		/*
+		Set up a table from its file.
+		*/
+		bool set(Table& e, const uint8_t* data) {
+			enum { SPLIT = 1, HAS_PAWNS = 2 };
+
+			// Step 1. Check that the file is for this table.
+			if (e.has_pawns != bool(*data & HAS_PAWNS) || (e.type == WDL && (e.key != e.key2) != bool(*data & SPLIT))) {
+				return false;
+			}
+			data++;
+
+			const int sides = e.sides();
+			const int max_file = (e.has_pawns) ? 3 : 0;
+
+			bool pp = e.has_pawns && e.pawn_count[1];
+
+			// Step 2. Read the pieces and group orders.
+			for (int f = 0; f <= max_file; f++) {
+				int order[2][2] = { { *data & 0xF, (pp) ? *(data + 1) & 0xF : 0xF },
+									{ *data >> 4, (pp) ? *(data + 1) >> 4 : 0xF } };
+				data += 1 + pp;
+
+				for (int k = 0; k < e.piece_count; k++, data++) {
+					for (int i = 0; i < sides; i++) {
+						e.get(i, f)->pieces[k] = (i) ? *data >> 4 : *data & 0xF;
+					}
+				}
+
+				for (int i = 0; i < sides; i++) {
+					set_groups(e, e.get(i, f), order[i], f);
+				}
+			}
+
+			data += uintptr_t(data) & 1;
+
+			// Step 3. Read the Huffman codes, the DTZ maps, the sparse indices, the block lengths and finally the blocks.
+			for (int f = 0; f <= max_file; f++) {
+				for (int i = 0; i < sides; i++) {
+					data = set_sizes(e.get(i, f), data);
+				}
+			}
+
+			data = set_dtz_map(e, data, max_file);
+
+			for (int f = 0; f <= max_file; f++) {
+				for (int i = 0; i < sides; i++) {
+					PairsData* d = e.get(i, f);
+					d->sparse_index = data;
+					data += d->sparse_index_size * 6;
+				}
+			}
+
+			for (int f = 0; f <= max_file; f++) {
+				for (int i = 0; i < sides; i++) {
+					PairsData* d = e.get(i, f);
+					d->block_length = data;
+					data += size_t(d->block_length_size) * 2;
+				}
+			}
+
+			for (int f = 0; f <= max_file; f++) {
+				for (int i = 0; i < sides; i++) {
+					data = reinterpret_cast<const uint8_t*>((uintptr_t(data) + 0x3F) & ~uintptr_t(0x3F));
+
+					PairsData* d = e.get(i, f);
+					d->data = data;
+					data += size_t(d->num_blocks) * d->block_size;
+				}
+			}
+
+			return true;
+		}
+
+
+		/// <summary>
+		/// Map and set up a table the first time it is probed.
+		/// </summary>
+		/// <returns>True if the table can be probed.</returns>
+		bool mapped(Table& e) {
+			if (e.ready.load(std::memory_order_acquire)) {
+				return e.mapping != nullptr;
+			}
+
+			std::lock_guard<std::mutex> lock(e.mutex);
+
+			if (e.ready.load(std::memory_order_relaxed)) {
+				return e.mapping != nullptr;
+			}
+
+			const uint8_t* data = map_file(e);
+
+			if (data == nullptr || !set(e, data)) {
+				e.unmap();
+			}
+
+			e.ready.store(true, std::memory_order_release);
+			return e.mapping != nullptr;
+		}
+
+
+		/*
+		Register the tables of a set of pieces if its WDL file exists. The pieces are the white ones, starting with the king, followed by the
+		black ones.
+		*/
+		void add(const std::vector<int>& pieces) {
+			std::string code;
+			for (int pce : pieces) {
+				code += PIECE_CHARS[pce];
+			}
+			code.insert(code.find('K', 1), "v");
+
+			if (find_file(code + ".rtbw").empty()) {
+				return;
+			}
+
+			max_cardinality = std::max(int(pieces.size()), max_cardinality);
+
+			wdl_tables.emplace_back(WDL, code);
+			dtz_tables.emplace_back(DTZ, code);
+
+			tables[wdl_tables.back().key] = { &wdl_tables.back(), &dtz_tables.back() };
+			tables[wdl_tables.back().key2] = { &wdl_tables.back(), &dtz_tables.back() };
+		}
+
+
+
+		/*
+		==================================================================================================================================
+		------------------------------------------------------------- PROBING ------------------------------------------------------------
+		==================================================================================================================================
+		*/
+
+		inline bool is_capture(const GameState_t* pos, unsigned int move) {
+			SIDE Them = (pos->side_to_move == WHITE) ? BLACK : WHITE;
+			return SPECIAL(move) == ENPASSANT || pos->piece_list[Them][TOSQ(move)] != NO_TYPE;
+		}
+
+
+		int probe_table(GameState_t* pos, TBType type, ProbeState* result, WDLScore wdl = WDL_DRAW) {
+
+			// KvK isn't in the tables.
+			if (countBits(pos->all_pieces[WHITE] | pos->all_pieces[BLACK]) == 2) {
+				return WDL_DRAW;
+			}
+
+			auto it = tables.find(pos->materialKey);
+			Table* e = (it == tables.end()) ? nullptr : (type == WDL) ? it->second.first : it->second.second;
+
+			if (e == nullptr || !mapped(*e)) {
+				*result = FAIL;
+				return 0;
+			}
+
+			return do_probe_table(pos, *e, wdl, result);
+		}
+
+
+		/*
+		The tables store "don't care" values for positions where the side to move has a winning capture, and may store a loss where a capture
+		draws. So the captures are searched as well, and the best of their results and the table's is the result of the position. If
+		check_zeroing is set, pawn moves are searched too, since the DTZ tables don't store positions where a zeroing move wins.
+		*/
+		WDLScore search(GameState_t* pos, ProbeState* result, bool check_zeroing) {
+			WDLScore value, best_value = WDL_LOSS;
+			int total_count = 0, move_count = 0;
+
+			SIDE Us = pos->side_to_move;
+
+			MoveList ml; moveGen::generate<ALL>(pos, &ml);
+
+			for (int i = 0; i < int(ml.size()); i++) {
+				unsigned int move = ml[i]->move;
+				bool zeroing = is_capture(pos, move) || (check_zeroing && pos->piece_list[Us][FROMSQ(move)] == PAWN);
+
+				if (!pos->make_move(ml[i])) {
+					continue;
+				}
+				total_count++;
+
+				if (!zeroing) {
+					pos->undo_move();
+					continue;
+				}
+
+				move_count++;
+				value = WDLScore(-search(pos, result, false));
+				pos->undo_move();
+
+				if (*result == FAIL) {
+					return WDL_DRAW;
+				}
+
+				if (value > best_value) {
+					best_value = value;
+
+					if (value >= WDL_WIN) {
+						*result = ZEROING_BEST_MOVE;
+						return value;
+					}
+				}
+			}
+
+			// If all moves were searched, the table isn't needed. It wouldn't know about en-passant captures anyways.
+			bool no_more_moves = (move_count && move_count == total_count);
+
+			if (no_more_moves) {
+				value = best_value;
+			}
+			else {
+				value = WDLScore(probe_table(pos, WDL, result));
+
+				if (*result == FAIL) {
+					return WDL_DRAW;
+				}
+			}
+
+			if (best_value >= value) {
+				*result = (best_value > WDL_DRAW || no_more_moves) ? ZEROING_BEST_MOVE : OK;
+				return best_value;
+			}
+
+			*result = OK;
+			return value;
+		}
+
+
+		// The DTZ of a position where the best move is a capture or pawn move.
+		int dtz_before_zeroing(WDLScore wdl) {
+			return (wdl == WDL_WIN) ? 1 : (wdl == WDL_CURSED_WIN) ? 101 : (wdl == WDL_BLESSED_LOSS) ? -101 : (wdl == WDL_LOSS) ? -1 : 0;
+		}
+	}
+
+
+
+	void INIT() {
+
+		// Step 1. MapB1H1H7 and MapA1D1D4. The squares on the diagonal are encoded after the others.
+		int code = 0;
+		for (int sq = 0; sq < 64; sq++) {
+			if (off_A1H8(sq) < 0) {
+				MapB1H1H7[sq] = code++;
+			}
+		}
+
+		std::vector<int> diagonal;
+		code = 0;
+		for (int sq = A1; sq <= D4; sq++) {
+			if (off_A1H8(sq) < 0 && file_of(sq) <= 3) {
+				MapA1D1D4[sq] = code++;
+			}
+			else if (!off_A1H8(sq) && file_of(sq) <= 3) {
+				diagonal.push_back(sq);
+			}
+		}
+		for (int sq : diagonal) {
+			MapA1D1D4[sq] = code++;
+		}
+
+		// Step 2. MapKK. If the first king is on the diagonal, the other can't be above it. Both kings on the diagonal are encoded last.
+		std::vector<std::pair<int, int>> both_on_diagonal;
+		code = 0;
+		for (int idx = 0; idx < 10; idx++) {
+			for (int s1 = A1; s1 <= D4; s1++) {
+				if (MapA1D1D4[s1] != idx || !(idx || s1 == B1)) {
+					continue;
+				}
+
+				for (int s2 = 0; s2 < 64; s2++) {
+					if (std::max(std::abs(file_of(s1) - file_of(s2)), std::abs(rank_of(s1) - rank_of(s2))) <= 1) {
+						continue;
+					}
+					else if (!off_A1H8(s1) && off_A1H8(s2) > 0) {
+						continue;
+					}
+					else if (!off_A1H8(s1) && !off_A1H8(s2)) {
+						both_on_diagonal.emplace_back(idx, s2);
+					}
+					else {
+						MapKK[idx][s2] = code++;
+					}
+				}
+			}
+		}
+		for (auto p : both_on_diagonal) {
+			MapKK[p.first][p.second] = code++;
+		}
+		assert(code == 462);
+
+		// Step 3. Binomial coefficients by Pascal's rule.
+		Binomial[0][0] = 1;
+		for (int n = 1; n < 64; n++) {
+			for (int k = 0; k < 6 && k <= n; k++) {
+				Binomial[k][n] = ((k > 0) ? Binomial[k - 1][n - 1] : 0) + ((k < n) ? Binomial[k][n - 1] : 0);
+			}
+		}
+
+		// Step 4. MapPawns, LeadPawnIdx and LeadPawnsSize. With a leading pawn on a square, the other pawns can't be closer to the edge or
+		//	on a lower rank of the same file.
+		int available_squares = 47;
+
+		for (int lead_pawns_count = 1; lead_pawns_count <= 5; lead_pawns_count++) {
+			for (int f = 0; f <= 3; f++) {
+				int idx = 0;
+
+				for (int r = 1; r <= 6; r++) {
+					int sq = 8 * r + f;
+
+					if (lead_pawns_count == 1) {
+						MapPawns[sq] = available_squares--;
+						MapPawns[sq ^ 7] = available_squares--;
+					}
+					LeadPawnIdx[lead_pawns_count][sq] = idx;
+					idx += int(Binomial[lead_pawns_count - 1][MapPawns[sq]]);
+				}
+
+				LeadPawnsSize[lead_pawns_count][f] = idx;
+			}
+		}
+	}
+
+
+
+	int load(const std::string& paths) {
+
+		// Step 1. Remove the previous tables.
+		tables.clear();
+		wdl_tables.clear();
+		dtz_tables.clear();
+		directories.clear();
+		max_cardinality = 0;
+
+		if (paths.empty() || paths == "<empty>") {
+			return 0;
+		}
+
+		size_t start = 0;
+		while (start <= paths.size()) {
+			size_t end = paths.find(PATH_SEPARATOR, start);
+			end = (end == std::string::npos) ? paths.size() : end;
+
+			if (end > start) {
+				directories.push_back(paths.substr(start, end - start));
+			}
+			start = end + 1;
+		}
+
+		// Step 2. Look for the tables of every material configuration with up to seven pieces.
+		for (int p1 = PAWN; p1 < KING; p1++) {
+			add({ KING, p1, KING });
+
+			for (int p2 = PAWN; p2 <= p1; p2++) {
+				add({ KING, p1, p2, KING });
+				add({ KING, p1, KING, p2 });
+
+				for (int p3 = PAWN; p3 < KING; p3++) {
+					add({ KING, p1, p2, KING, p3 });
+				}
+
+				for (int p3 = PAWN; p3 <= p2; p3++) {
+					add({ KING, p1, p2, p3, KING });
+
+					for (int p4 = PAWN; p4 <= p3; p4++) {
+						add({ KING, p1, p2, p3, p4, KING });
+
+						for (int p5 = PAWN; p5 <= p4; p5++) {
+							add({ KING, p1, p2, p3, p4, p5, KING });
+						}
+						for (int p5 = PAWN; p5 < KING; p5++) {
+							add({ KING, p1, p2, p3, p4, KING, p5 });
+						}
+					}
+
+					for (int p4 = PAWN; p4 < KING; p4++) {
+						add({ KING, p1, p2, p3, KING, p4 });
+
+						for (int p5 = PAWN; p5 <= p4; p5++) {
+							add({ KING, p1, p2, p3, KING, p4, p5 });
+						}
+					}
+				}
+
+				for (int p3 = PAWN; p3 <= p1; p3++) {
+					for (int p4 = PAWN; p4 <= ((p1 == p3) ? p2 : p3); p4++) {
+						add({ KING, p1, p2, KING, p3, p4 });
+					}
+				}
+			}
+		}
+
+		return int(wdl_tables.size());
+	}
+
+
+
+	WDLScore probe_wdl(GameState_t* pos, ProbeState* result) {
+		*result = OK;
+		return search(pos, result, false);
+	}
+
+
+
+	int probe_dtz(GameState_t* pos, ProbeState* result) {
+		*result = OK;
+		WDLScore wdl = search(pos, result, true);
+
+		// Step 1. Draws aren't stored, and if the best move is zeroing the table's value can't be used.
+		if (*result == FAIL || wdl == WDL_DRAW) {
+			return 0;
+		}
+
+		if (*result == ZEROING_BEST_MOVE) {
+			return dtz_before_zeroing(wdl);
+		}
+
+		int dtz = probe_table(pos, DTZ, result, wdl);
+
+		if (*result == FAIL) {
+			return 0;
+		}
+
+		if (*result != CHANGE_STM) {
+			return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * sign_of(wdl);
+		}
+
+		// Step 2. The table only has the other side to move, so do a one-ply search for the move with the lowest DTZ that keeps the result.
+		int min_dtz = 0xFFFF;
+
+		SIDE Us = pos->side_to_move;
+		MoveList ml; moveGen::generate<ALL>(pos, &ml);
+
+		for (int i = 0; i < int(ml.size()); i++) {
+			unsigned int move = ml[i]->move;
+			bool zeroing = is_capture(pos, move) || pos->piece_list[Us][FROMSQ(move)] == PAWN;
+
+			if (!pos->make_move(ml[i])) {
+				continue;
+			}
+
+			// For zeroing moves we want the DTZ before the move, and only need the result after it.
+			dtz = (zeroing) ? -dtz_before_zeroing(search(pos, result, false)) : -probe_dtz(pos, result);
+
+			// A mate has a DTZ of one.
+			if (dtz == 1 && pos->in_check() && !moveGen::has_legal_move(pos)) {
+				min_dtz = 1;
+			}
+
+			if (!zeroing) {
+				dtz += sign_of(dtz);
+			}
+
+			if (dtz < min_dtz && sign_of(dtz) == sign_of(wdl)) {
+				min_dtz = dtz;
+			}
+
+			pos->undo_move();
+
+			if (*result == FAIL) {
+				return 0;
+			}
+		}
+
+		// Without legal moves, the position is mate.
+		return (min_dtz == 0xFFFF) ? -1 : min_dtz;
+	}
+
+
+
+	bool root_probe(GameState_t* pos, std::vector<unsigned int>& root_moves, int& cardinality) {
+		root_moves.clear();
+
+		if (max_cardinality == 0 || pos->castleRights != 0 || countBits(pos->all_pieces[WHITE] | pos->all_pieces[BLACK]) > max_cardinality) {
+			return false;
+		}
+
+		ProbeState result = OK;
+		int fifty = pos->fiftyMove;
+		bool repeated = pos->is_repetition();
+
+		std::vector<std::pair<unsigned int, int>> ranked;
+
+		MoveList ml; moveGen::generate<ALL>(pos, &ml);
+
+		// Step 1. Rank the moves by DTZ. Wins that can be completed within the fifty-move rule are ranked equally, and so are losses that
+		//	can't be saved by it.
+		for (int i = 0; i < int(ml.size()); i++) {
+			if (!pos->make_move(ml[i])) {
+				continue;
+			}
+
+			int dtz;
+			if (pos->fiftyMove == 0) {
+				dtz = dtz_before_zeroing(WDLScore(-probe_wdl(pos, &result)));
+			}
+			else if (pos->is_draw()) {
+				// The move repeats a position of the game or reaches the fifty-move limit, so it is a draw.
+				dtz = 0;
+			}
+			else {
+				dtz = -probe_dtz(pos, &result);
+				dtz = (dtz > 0) ? dtz + 1 : (dtz < 0) ? dtz - 1 : dtz;
+			}
+
+			if (pos->in_check() && dtz == 2 && !moveGen::has_legal_move(pos)) {
+				dtz = 1;
+			}
+
+			pos->undo_move();
+
+			if (result == FAIL) {
+				break;
+			}
+
+			int rank = (dtz > 0) ? ((dtz + fifty <= 99 && !repeated) ? MAX_DTZ : MAX_DTZ - (dtz + fifty))
+				: (dtz < 0) ? ((-dtz * 2 + fifty < 100) ? -MAX_DTZ : -MAX_DTZ + (-dtz + fifty))
+				: 0;
+
+			ranked.emplace_back(ml[i]->move, rank);
+		}
+
+		// Step 2. Without the DTZ tables, rank the moves by WDL instead.
+		bool dtz_ranked = (result != FAIL);
+
+		if (result == FAIL) {
+			constexpr int WDL_TO_RANK[] = { -MAX_DTZ, -MAX_DTZ + 101, 0, MAX_DTZ - 101, MAX_DTZ };
+
+			ranked.clear();
+			result = OK;
+
+			for (int i = 0; i < int(ml.size()); i++) {
+				if (!pos->make_move(ml[i])) {
+					continue;
+				}
+
+				WDLScore wdl = (pos->is_draw()) ? WDL_DRAW : WDLScore(-probe_wdl(pos, &result));
+				pos->undo_move();
+
+				if (result == FAIL) {
+					return false;
+				}
+
+				ranked.emplace_back(ml[i]->move, WDL_TO_RANK[wdl + 2]);
+			}
+		}
+
+		if (ranked.empty()) {
+			return false;
+		}
+
+		// Step 3. Keep the best moves.
+		int best_rank = std::max_element(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->second;
+
+		for (const auto& m : ranked) {
+			if (m.second == best_rank) {
+				root_moves.push_back(m.first);
+			}
+		}
+
+		// Step 4. Moves ranked by DTZ keep the best result on their own, so the search doesn't probe the tables and let a WDL score override
+		//	them. With only WDL, it keeps probing to find the way to win, unless the best result is a draw or a loss.
+		if (dtz_ranked || best_rank <= 0) {
+			cardinality = 0;
+		}
+
+		return true;
+	}
+}
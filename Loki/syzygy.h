@@ -0,0 +1,66 @@
+/*
+	Loki, a UCI-compliant chess playing software
+	Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+
+	Loki is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Loki is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef SYZYGY_H
+#define SYZYGY_H
+#include "position.h"
+
+#include <string>
+#include <vector>
+
+
+/*
+
+Probing of Syzygy endgame tablebases. The WDL tables give the result of a position under the fifty-move rule, and the DTZ tables the distance to
+the next capture or pawn move that keeps that result. The files are found in the directories of the SyzygyPath option and are memory-mapped the
+first time they are probed.
+
+The decoding follows the reference implementation by Ronald de Man, as it is done in Stockfish.
+
+*/
+namespace Syzygy {
+
+	// The result of a position for the side to move. Cursed wins and blessed losses are draws by the fifty-move rule.
+	enum WDLScore : int { WDL_LOSS = -2, WDL_BLESSED_LOSS = -1, WDL_DRAW = 0, WDL_CURSED_WIN = 1, WDL_WIN = 2 };
+
+	// FAIL if a table is missing or broken, CHANGE_STM if a DTZ table only stores the other side to move and ZEROING_BEST_MOVE if the best move
+	//	is a capture or pawn move.
+	enum ProbeState : int { FAIL = 0, OK = 1, CHANGE_STM = -1, ZEROING_BEST_MOVE = 2 };
+
+	// The most pieces of any table found. Zero if there are none.
+	extern int max_cardinality;
+
+	// Computes the indexing tables.
+	void INIT();
+
+	// Finds the tables in a list of directories separated by ':' (';' on Windows) and returns the number found. "<empty>" or an empty string
+	//	removes all tables.
+	int load(const std::string& paths);
+
+	// Probe the WDL tables. The position must have no castling rights and at most max_cardinality pieces.
+	WDLScore probe_wdl(GameState_t* pos, ProbeState* result);
+
+	// Probe the DTZ tables. A positive number means a win in that many plies to the next zeroing move, and a negative one a loss.
+	int probe_dtz(GameState_t* pos, ProbeState* result);
+
+	// Ranks the legal root moves by their DTZ, or by WDL if the DTZ tables are missing, and stores the best of them in root_moves. Returns
+	//	false, with root_moves empty, if the position couldn't be probed. cardinality is set to zero if the search shouldn't probe the tables.
+	bool root_probe(GameState_t* pos, std::vector<unsigned int>& root_moves, int& cardinality);
+}
+
+
+#endif
@@ -22,10 +22,14 @@
 namespace Texel {
 
 	/*
-	Load an EPD file containing the FENs and the game results.
+	Load an EPD file containing the FENs and the game results. Files ending in ".bin" are read as packed positions from gensfen.
 	*/
 	
 	tuning_positions* load_epd(std::string path) {
+		if (path.size() >= 4 && path.substr(path.size() - 4) == ".bin") {
+			return load_packed(path);
+		}
+
 		tuning_positions* positions = new tuning_positions();
 
 		std::ifstream epd_file(path);
@@ -77,6 +81,25 @@ namespace Texel {
 		return positions;
 	}
 
+
+	/*
+	Load a file of 32-byte packed positions written by gensfen.
+	*/
+
+	tuning_positions* load_packed(std::string path) {
+		tuning_positions* positions = new tuning_positions();
+
+		std::ifstream packed_file(path, std::ios::binary);
+
+		Gensfen::PackedPosition p;
+
+		while (packed_file.read(reinterpret_cast<char*>(&p), sizeof(Gensfen::PackedPosition))) {
+			positions->push_back(texel_position(Gensfen::to_fen(p), p.result / 2.0));
+		}
+
+		return positions;
+	}
+
 	/*
 		thread_batch is run by each individual thread. It computes the squared differences between a position's eval and the game result, for the particular partition
 		the main thread has alotted to it.
@@ -165,14 +188,13 @@ namespace Texel {
 		This function changes the parameters in the evaluation function and computes the new error based on the EPD-file provided and the value of k.
 	*/
 
-	double changed_error(Parameters p, std::vector<Score> new_values, tuning_positions* EPDS, double k) {
+	double changed_error(Parameters p, std::vector<Weight> new_values, tuning_positions* EPDS, double k) {
 
 		assert(p.size() == new_values.size());
 
 		// Step 1. Change the values in p with the ones in new_values
 		for (int i = 0; i < new_values.size(); i++) {
-			p[i].variable->mg = new_values[i].mg;
-			p[i].variable->eg = new_values[i].eg;
+			*p[i].variable = new_values[i].score();
 		}
 
 		// Step 2. Compute the new error and return
@@ -242,10 +264,10 @@ namespace Texel {
 
 
 		// Step 2. Set up the vector of parameter values, we call it theta here.
-		std::vector<Score> theta;
+		std::vector<Weight> theta;
 
 		for (int p = 0; p < tuning_vars.size(); p++) {
-			theta.push_back(Score(tuning_vars[p].variable->mg, tuning_vars[p].variable->eg));
+			theta.push_back(Weight(*tuning_vars[p].variable));
 		}
 
 
@@ -282,10 +304,10 @@ namespace Texel {
 		// Step 5. Run the tuning with the given number of iterations
 		std::cout << "\n[*] Initialization complete. Starting AdamSPSA tuning session for " << iterations << " iterations." << std::endl;
 
-		std::vector<Score> theta_plus;
-		std::vector<Score> theta_minus;
+		std::vector<Weight> theta_plus;
+		std::vector<Weight> theta_minus;
 
-		std::vector<Score> delta; // Initialize perturbation vector.
+		std::vector<Weight> delta; // Initialize perturbation vector.
 
 		double g_hat_mg = 0.0;
 		double g_hat_eg = 0.0;
@@ -310,8 +332,8 @@ namespace Texel {
 			// Step 5A. Compute the current error. This is only used for outputting the progress.
 			double error = changed_error(tuning_vars, theta, EPDS, k);
 
-			//data.push_back(TexelStats::DataPoint(n + 1, error, Score(g_hat_mg, g_hat_eg), Score(abs(an * g_hat_mg), abs(an * g_hat_eg)), theta));
-			data.push_back(TexelStats::DataPoint(n + 1, error, Score(g_hat_mg, g_hat_eg), Score(0, 0), theta));
+			//data.push_back(TexelStats::DataPoint(n + 1, error, Weight(g_hat_mg, g_hat_eg), Weight(abs(an * g_hat_mg), abs(an * g_hat_eg)), theta));
+			data.push_back(TexelStats::DataPoint(n + 1, error, Weight(g_hat_mg, g_hat_eg), Weight(0, 0), theta));
 
 			// Step 5B. Calculate iteration dependent constants
 			//an = a / (std::pow(BIG_A + double(n) + 1.0, alpha));
@@ -339,13 +361,13 @@ namespace Texel {
 				int d_mg = randemacher();
 				int d_eg = randemacher();
 
-				delta.push_back(Score(d_mg, d_eg)); // Add the scores to the delta vector.
+				delta.push_back(Weight(d_mg, d_eg)); // Add the scores to the delta vector.
 
 				// Step 5C.1. Compute theta_plus and theta_minus from these values
-				//theta_plus.push_back(Score(std::round(theta[p].mg + double(d_mg) * cn), std::round(theta[p].eg + double(d_eg) * cn)));
-				//theta_minus.push_back(Score(std::round(theta[p].mg - double(d_mg) * cn), std::round(theta[p].eg - double(d_eg) * cn)));
-				theta_plus.push_back(Score(std::round(theta[p].mg + double(d_mg) * cn[p].mg), std::round(theta[p].eg + double(d_eg) * cn[p].eg)));
-				theta_minus.push_back(Score(std::round(theta[p].mg - double(d_mg) * cn[p].mg), std::round(theta[p].eg - double(d_eg) * cn[p].eg)));
+				//theta_plus.push_back(Weight(std::round(theta[p].mg + double(d_mg) * cn), std::round(theta[p].eg + double(d_eg) * cn)));
+				//theta_minus.push_back(Weight(std::round(theta[p].mg - double(d_mg) * cn), std::round(theta[p].eg - double(d_eg) * cn)));
+				theta_plus.push_back(Weight(std::round(theta[p].mg + double(d_mg) * cn[p].mg), std::round(theta[p].eg + double(d_eg) * cn[p].eg)));
+				theta_minus.push_back(Weight(std::round(theta[p].mg - double(d_mg) * cn[p].mg), std::round(theta[p].eg - double(d_eg) * cn[p].eg)));
 			}
 
 			// Step 5D. Compute the error of theta_plus and theta_minus respectively.
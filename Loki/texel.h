@@ -89,12 +89,29 @@ namespace Texel {
 
 
 
+	/*
+	The Weight struct holds the middlegame and endgame values of a parameter unpacked, so the tuner can change them one at a time.
+	*/
+	struct Weight {
+		Weight(int m, int e) { mg = m; eg = e; }
+		Weight(const Score s) { mg = s.mg(); eg = s.eg(); }
+		Weight() { mg = 0; eg = 0; }
+
+		Score score() const { return Score(mg, eg); }
+
+		int mg;
+		int eg;
+	};
+
+
+
 	/*
 	This structure holds all the necessary data for the parameter, which is its original value, the address (to change it in eval) and its bounds if specified.
 	*/
+	// NOTE: The evaluation parameters can only be changed in builds with TUNE defined (make tune=yes).
 	struct Parameter {
 
-		Parameter (Score* var, Value _rend = Value(0.002, 0.002), Value _cend = Value(4.0, 4.0), Score max_val = Score(INF, INF), Score min_val = Score(-INF, -INF)) {
+		Parameter (Score* var, Value _rend = Value(0.002, 0.002), Value _cend = Value(4.0, 4.0), Weight max_val = Weight(INF, INF), Weight min_val = Weight(-INF, -INF)) {
 			variable = var; // Copy the pointer
 
 			max_value = max_val;
@@ -109,11 +126,11 @@ namespace Texel {
 		Score* variable;
 
 
-		Score max_value;
-		Score min_value;
+		Weight max_value;
+		Weight min_value;
 
 
-		Score original_value;
+		Weight original_value;
 
 		Value C_END;
 		Value R_END;
@@ -145,18 +162,18 @@ namespace Texel {
 
 		struct DataPoint {
 
-			DataPoint(int i, double e, Score g, Score ss, std::vector<Score> theta) {
+			DataPoint(int i, double e, Weight g, Weight ss, std::vector<Weight> theta) {
 				iteration = i; error = e; gradient = g; step_size = ss; values = theta;
 			}
 
 			int iteration = 0;
 
-			std::vector<Score> values;
+			std::vector<Weight> values;
 
 			double error;
 
-			Score gradient;
-			Score step_size;
+			Weight gradient;
+			Weight step_size;
 		};
 
 		typedef std::vector<DataPoint> TuningData;
@@ -188,11 +205,13 @@ namespace Texel {
 
 	tuning_positions* load_epd(std::string path);
 
+	tuning_positions* load_packed(std::string path);
+
 	double optimal_k(tuning_positions* EPDS);
 
 	double mean_squared_error(tuning_positions* EPDS, double k);
 
-	double changed_error(Parameters p, std::vector<Score> new_values, tuning_positions* EPDS, double k);
+	double changed_error(Parameters p, std::vector<Weight> new_values, tuning_positions* EPDS, double k);
 
 	void Tune(Parameters tuning_vars, std::string epd_file, int iterations = 100);
 
@@ -17,6 +17,8 @@
 */
 #include "thread.h"
 
+#include <cstring>
+
 
 
 /*
@@ -37,12 +39,19 @@ void SearchInfo_t::clear() {
 	infinite = false;
 
 	nodes = 0;
+	node_limit = 0;
+	tbhits = 0;
+	root_moves.clear();
+	tb_cardinality = 32;
 
 	quit = false;
 	stopped = false;
 
 	fh = 0;
 	fhf = 0;
+
+	lazy_calls = 0;
+	lazy_exits = 0;
 }
 
 
@@ -53,10 +62,12 @@ Set a new killer move. This will push back the previously best killer move.
 
 */
 void SearchThread_t::setKillers(int ply, int move) {
+	unsigned int* killers = stack(ply)->killers;
+
 	// If the move is already the first killer, don't add it since it'll just result in duplicate killers
-	if (stats.killers[ply][0] != move) {
-		stats.killers[ply][1] = stats.killers[ply][0];
-		stats.killers[ply][0] = move;
+	if (killers[0] != move) {
+		killers[1] = killers[0];
+		killers[0] = move;
 	}
 }
 
@@ -65,51 +76,77 @@ void SearchThread_t::setKillers(int ply, int move) {
 
 /*
 
-Update the move ordering heuristics. This function is called when a beta cutoff occurs.
+Update the move ordering heuristics. This function is called when a beta cutoff occurs, with the quiet moves and captures that were searched
+before best_move.
 
 */
-void SearchThread_t::update_move_heuristics(int best_move, int depth, MoveList* ml) {
-	
-	// Step 1. Set the new killer moves
-	setKillers(pos->ply, best_move);
+void SearchThread_t::update_move_heuristics(int best_move, int depth, const unsigned int* quiets, int quiet_count, const unsigned int* captures, int capture_count) {
+	SIDE Us = pos->side_to_move;
+	SIDE Them = (Us == WHITE) ? BLACK : WHITE;
+
+	int bonus = history_bonus(depth);
+
+	int captured = (SPECIAL(best_move) == ENPASSANT) ? PAWN : pos->piece_list[Them][TOSQ(best_move)];
 
+	// Step 1. If the best move is quiet, update the quiet heuristics.
+	if (captured == NO_TYPE && SPECIAL(best_move) != PROMOTION) {
 
-	// Step 2. Update countermove heuristic
-	//if (pos->ply > 0 && stats.moves_path[pos->ply - 1] != MOVE_NULL) { // We need to be at least one ply deep, otherwise we'd index negative array values.
-	//	stats.counterMoves[FROMSQ(stats.moves_path[pos->ply - 1])][TOSQ(stats.moves_path[pos->ply - 1])] = best_move;
-	//}
+		// Step 1A. Set the new killer moves
+		setKillers(pos->ply, best_move);
 
 
-	// Step 3. Update history
-	int history_bonus = std::min(depth * depth, 400);
+		// Step 1B. Update countermove heuristic. The entries below ply 0 and null moves have no previous move.
+		unsigned int previous_move = stack(pos->ply - 1)->current_move;
+		if (previous_move != NOMOVE && previous_move != MOVE_NULL) {
+			stats.counterMoves[FROMSQ(previous_move)][TOSQ(previous_move)] = best_move;
+		}
 
-	stats.history[pos->side_to_move][FROMSQ(best_move)][TOSQ(best_move)] += history_bonus;
 
-	
-	// Decrease history value for all other quiet moves, since they didn't fail high
-	unsigned int move = NOMOVE;
-	for (int mn = 0; mn < ml->size(); mn++) {
-		move = (*ml)[mn]->move;
-		if (pos->piece_list[(pos->side_to_move == WHITE) ? BLACK : WHITE][TOSQ(move)] == NO_TYPE && SPECIAL(move) != PROMOTION
-			&& SPECIAL(move) != ENPASSANT) { // No piece is captured, not a promotion and not an en-passant
+		// Step 1C. Update the butterfly and continuation histories with a bonus for the best move and a malus for the quiets that didn't fail high.
+		update_quiet_histories(best_move, bonus);
 
-			stats.history[pos->side_to_move][FROMSQ(move)][TOSQ(move)] = std::max(-countermove_bonus, stats.history[pos->side_to_move][FROMSQ(move)][TOSQ(move)] - history_bonus);
+		for (int i = 0; i < quiet_count; i++) {
+			update_quiet_histories(quiets[i], -bonus);
 		}
 	}
 
-	// Handle history table overflows
-	if (stats.history[pos->side_to_move][FROMSQ(best_move)][TOSQ(best_move)] >= countermove_bonus) {
-	
-		for (int i = 0; i < 64; i++) {
-	
-			for (int j = 0; j < 64; j++) {
-	
-				stats.history[0][i][j] /= 2;
-				stats.history[1][i][j] /= 2;
-			}
+	// Step 2. Otherwise give the capture a bonus in the capture history.
+	else if (captured != NO_TYPE) {
+		update_history(stats.capture_history[piece_index(Us, pos->piece_list[Us][FROMSQ(best_move)])][TOSQ(best_move)][captured], bonus);
+	}
+
+	// Step 3. The captures searched before the best move all failed low, so give them a malus.
+	for (int i = 0; i < capture_count; i++) {
+		int c = (SPECIAL(captures[i]) == ENPASSANT) ? PAWN : pos->piece_list[Them][TOSQ(captures[i])];
+
+		if (c != NO_TYPE) {
+			update_history(stats.capture_history[piece_index(Us, pos->piece_list[Us][FROMSQ(captures[i])])][TOSQ(captures[i])][c], -bonus);
 		}
 	}
+}
+
+
+
+/*
+
+Update the butterfly history and the one- and two-ply continuation histories of a quiet move.
+
+*/
+void SearchThread_t::update_quiet_histories(int move, int bonus) {
+	SIDE Us = pos->side_to_move;
+	int to_sq = TOSQ(move);
+	int pce = piece_index(Us, pos->piece_list[Us][FROMSQ(move)]);
+
+	update_history(stats.history[Us][FROMSQ(move)][to_sq], bonus);
+
+	SearchStack_t* ply_stack = stack(pos->ply);
 
+	if ((ply_stack - 1)->continuation_history != nullptr) {
+		update_history((*(ply_stack - 1)->continuation_history)[pce][to_sq], bonus);
+	}
+	if ((ply_stack - 2)->continuation_history != nullptr) {
+		update_history((*(ply_stack - 2)->continuation_history)[pce][to_sq], bonus);
+	}
 }
 
 
@@ -120,24 +157,35 @@ Clear all the move ordering heuristics.
 
 */
 void SearchThread_t::clear_move_heuristics() {
+	stats.clear();
 
-	for (int i = 0; i < 64; i++) {
-	
-		for (int j = 0; j < 64; j++) {
-			stats.counterMoves[i][j] = 0;
-	
-			stats.history[0][i][j] = 0;
-			stats.history[1][i][j] = 0;
-		}
-	
-	}
+	clear_search_stack();
+}
+
+
+
+/*
 
-	for (int d = 0; d < MAXDEPTH; d++) {
-		stats.moves_path[d] = 0;
-		stats.static_eval[d] = 0;
+Reset all the tables in a MoveStats_t object.
 
-		stats.killers[d][0] = 0;
-		stats.killers[d][1] = 0;
+*/
+void MoveStats_t::clear() {
+	std::memset(counterMoves, 0, sizeof(counterMoves));
+	std::memset(history, 0, sizeof(history));
+	std::memset(capture_history, 0, sizeof(capture_history));
+	std::memset(continuation_history, 0, sizeof(continuation_history));
+}
+
+
+
+/*
+
+Clear all entries in the search stack, including the sentinels below ply 0.
+
+*/
+void SearchThread_t::clear_search_stack() {
+	for (int i = 0; i < MAXDEPTH + 1 + STACK_OFFSET; i++) {
+		search_stack[i].clear();
 	}
 }
 
@@ -20,6 +20,10 @@
 #include "movegen.h"
 #include "search_const.h"
 #include "evaluation.h"
+#include "transposition.h"
+#include "searchstats.h"
+
+#include <vector>
 
 
 
@@ -38,12 +42,28 @@ public:
 
 	long nodes = 0;
 
+	// Stop the search after this many nodes. Zero means no limit.
+	long long node_limit = 0;
+
+	// The number of successful tablebase probes.
+	long long tbhits = 0;
+
+	// The root moves that the tablebases allow. Empty if all moves are searched.
+	std::vector<unsigned int> root_moves;
+
+	// The search only probes the tablebases in positions with at most this many pieces. Zero if the root moves were ranked by DTZ.
+	int tb_cardinality = 32;
+
 	bool quit = false;
 	bool stopped = false;
 
 	int fh = 0;
 	int fhf = 0;
 
+	// Windowed evaluations and lazy exits of the main thread. Only set after the search.
+	uint64_t lazy_calls = 0;
+	uint64_t lazy_exits = 0;
+
 	SearchInfo_t() {
 
 	}
@@ -56,26 +76,125 @@ public:
 
 /*
 
-The MoveStats_t struct holds all move ordering and pruning statistics.
+History tables are indexed by colored pieces: Black's pieces are 0..5 and White's are 6..11.
 
 */
+inline int piece_index(SIDE side, int pce) {
+	return side * 6 + pce;
+}
 
-struct MoveStats_t {
-	// Holds the moves played to get to a position in search. Used for countermoves.
-	unsigned int moves_path[MAXDEPTH + 1] = { 0 };
 
+// PieceToHistory is indexed by [piece][to] of a move. A continuation history holds one of these for every [piece][to] of the move before.
+typedef int16_t PieceToHistory[12][64];
+
+
+/// <summary>
+/// Gravity-style history update. The closer an entry is to HISTORY_MAX, the smaller the effect of a bonus pointing the same way, so the entries
+/// stay bounded and no wholesale rescaling of the tables is needed.
+/// </summary>
+template<typename T>
+inline void update_history(T& entry, int bonus) {
+	entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+
+/*
+
+The MoveStats_t struct holds all move ordering and pruning statistics that aren't tied to a specific ply.
+
+*/
+
+struct MoveStats_t {
 	// Countermoves
 	unsigned int counterMoves[64][64] = { {0} };
 
 	// History heuristic
 	int history[2][64][64] = { {{0}} };
 
+	// Capture history. Indexed by [piece][to][captured piece type].
+	int capture_history[12][64][6] = { {{0}} };
+
+	// Continuation history. Indexed by [piece][to] of the move one or two plies earlier and then by [piece][to] of the current move.
+	PieceToHistory continuation_history[12][64] = { {{{0}}} };
+
+	void clear();
+};
+
+
+/*
+
+The SearchStack_t struct holds the search context of a single ply. Each thread has a contiguous array of these, so a node finds everything it
+needs about itself and its ancestors in one place instead of in several [MAXDEPTH + 1] arrays.
+
+*/
+
+struct SearchStack_t {
+	// The move being searched from this ply. Set to MOVE_NULL when a null move is made.
+	unsigned int current_move = NOMOVE;
+
+	// A move that should not be searched from this ply. Reserved for singular extensions.
+	unsigned int excluded_move = NOMOVE;
+
 	// Killer moves
-	unsigned int killers[MAXDEPTH + 1][2] = { {0} };
+	unsigned int killers[2] = { NOMOVE, NOMOVE };
+
+	// The static evaluation of the position (VALUE_NONE if in check).
+	int static_eval = 0;
 
-	// Static evaluations
-	int static_eval[MAXDEPTH + 1] = { 0 };
+	// The number of moves searched from this ply so far.
+	int move_count = 0;
 
+	// The continuation history entry of current_move. nullptr if no move (or a null move) has been made from this ply.
+	PieceToHistory* continuation_history = nullptr;
+
+	void clear() {
+		current_move = NOMOVE;
+		excluded_move = NOMOVE;
+		killers[0] = killers[1] = NOMOVE;
+		static_eval = 0;
+		move_count = 0;
+		continuation_history = nullptr;
+	}
+};
+
+// The number of sentinel entries below ply 0, so that a node can always look two plies back.
+constexpr int STACK_OFFSET = 2;
+
+
+/*
+
+The PvTable_t struct is a triangular table of principal variations. Row "ply" holds the best line found from that ply and onwards, with the moves
+stored at their absolute ply indices. When a move raises alpha, only the remainder of the child's row is copied, so no PV-arrays are allocated or
+copied in nodes that never raise alpha.
+
+*/
+
+struct PvTable_t {
+	// The index one past the last move of the line for each ply.
+	int length[MAXDEPTH + 1] = { 0 };
+
+	// table[ply][ply .. length[ply] - 1] is the principal variation from ply.
+	unsigned int table[MAXDEPTH + 1][MAXDEPTH + 1] = { {0} };
+
+	// Called on entering a node to mark its line as empty.
+	inline void clear(int ply) {
+		length[ply] = ply;
+	}
+
+	// Called when "move" raises alpha at ply. The child's line is appended after it.
+	inline void update(int ply, unsigned int move) {
+		table[ply][ply] = move;
+
+		int child_length = (ply + 1 <= MAXDEPTH) ? length[ply + 1] : ply + 1;
+		for (int n = ply + 1; n < child_length; n++) {
+			table[ply][n] = table[ply + 1][n];
+		}
+		length[ply] = std::max(child_length, ply + 1);
+	}
+
+	// The principal variation from the root.
+	inline unsigned int* root_line() { return table[0]; }
+	inline int root_length() const { return length[0]; }
 };
 
 
@@ -88,13 +207,53 @@ public:
 
 	int thread_id = 0;
 
+	// A standalone thread searches on its own. It doesn't read input, print or share the stop flag with other threads, so several of them
+	//	can search different positions at the same time.
+	bool standalone = false;
+
+	// The result of the last completed iteration of searchPosition.
+	unsigned int best_move = NOMOVE;
+	int best_score = 0;
+
+	// The time in milliseconds and the nodes searched at the end of the iteration where best_move became the best move and stayed so.
+	long long best_move_time = 0;
+	long best_move_nodes = 0;
+
+	// The depth and principal variation of the last completed iteration.
+	int best_depth = 0;
+	std::vector<unsigned int> best_pv;
+
+	// A standalone thread can search with a transposition table of its own instead of the global one.
+	TranspositionTable* own_table = nullptr;
+
+	inline TranspositionTable* table() const {
+		return (own_table != nullptr) ? own_table : tt;
+	}
+
 
 	void setKillers(int ply, int move);
 	
 	// All move ordering and pruning statistics is held in stats
 	MoveStats_t stats;
 
-	void update_move_heuristics(int best_move, int depth, MoveList* ml);
+#if defined(SEARCH_STATS)
+	// The statistics of this thread's search.
+	SearchStats::Table search_stats;
+#endif
+
+	// The per-ply search stack. stack(ply) returns the entry for a given ply.
+	SearchStack_t search_stack[MAXDEPTH + 1 + STACK_OFFSET];
+
+	inline SearchStack_t* stack(int ply) {
+		return &search_stack[ply + STACK_OFFSET];
+	}
+
+	// The principal variations found by this thread.
+	PvTable_t pv_table;
+
+	void update_move_heuristics(int best_move, int depth, const unsigned int* quiets, int quiet_count, const unsigned int* captures, int capture_count);
+	void update_quiet_histories(int move, int bonus);
+	void clear_search_stack();
 	void clear_move_heuristics();
 	
 	~SearchThread_t() {
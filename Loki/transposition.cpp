@@ -24,7 +24,8 @@ TranspositionTable *tt = new TranspositionTable(TT_DEFAULT_SIZE);
 /// Default constructor for the transposition table.
 /// </summary>
 /// <param name="size">The size of the table in megabytes.</param>
-TranspositionTable::TranspositionTable(uint64_t size) {
+/// <param name="verbose">Print the size of the table. Tables of the analysis tools are created silently.</param>
+TranspositionTable::TranspositionTable(uint64_t size, bool verbose) {
 	uint64_t upperSize = MB(size) / sizeof(TT_Entry);
 	numEntries = nearest_power_two(upperSize); // numEntries should be a power of two.
 	num_slots = numEntries / 2;
@@ -33,7 +34,9 @@ TranspositionTable::TranspositionTable(uint64_t size) {
 
 	clear_table();
 
-	std::cout << "Initialized " << size << "MB (" << numEntries << " entries) " << " transposition table." << std::endl;
+	if (verbose) {
+		std::cout << "Initialized " << size << "MB (" << numEntries << " entries) " << " transposition table." << std::endl;
+	}
 }
 
 /// <summary>
@@ -58,7 +61,8 @@ size_t TranspositionTable::size() {
 /// Set a new size for the transposition table.
 /// </summary>
 /// <param name="size">The new size in MB</param>
-void TranspositionTable::resize(uint64_t size) {
+/// <param name="verbose">Print the new size.</param>
+void TranspositionTable::resize(uint64_t size, bool verbose) {
 	delete[] table;
 
 	uint64_t upperSize = MB(size) / sizeof(TT_Entry);
@@ -69,7 +73,9 @@ void TranspositionTable::resize(uint64_t size) {
 
 	clear_table();
 
-	std::cout << "Resized transposition table to " << size << "MB (" << numEntries << " entries)." << std::endl;
+	if (verbose) {
+		std::cout << "Resized transposition table to " << size << "MB (" << numEntries << " entries)." << std::endl;
+	}
 }
 
 
@@ -124,9 +130,10 @@ EntryData_t* TranspositionTable::probe_tt(uint64_t key, bool& hit) {
 // For now we are just using a replace all strategy
 void TranspositionTable::store_entry(const GameState_t* pos, uint16_t move, int16_t score, uint16_t depth, uint16_t flag) {
 	TT_Slot* slot = &table[pos->posKey & (num_slots - 1)];
+	uint16_t age = generation.load(std::memory_order_relaxed);
 
 	// Step 1. Check if the data can be written to the first entry.
-	if (depth >= slot->EntryOne.data.get_depth() || depth == slot->EntryOne.data.get_depth() - 1 || generation > slot->EntryOne.data.get_age()) {
+	if (depth >= slot->EntryOne.data.get_depth() || depth == slot->EntryOne.data.get_depth() - 1 || age > slot->EntryOne.data.get_age()) {
 
 		// Step 1A. For 32-bit systems, get the data as a 64-bit integer.
 #if !(defined(_WIN64) || defined(IS_64BIT))
@@ -135,7 +142,7 @@ void TranspositionTable::store_entry(const GameState_t* pos, uint16_t move, int1
 
 		// Step 1B. Write the new data.
 		// If generation has reached its limit (127), we'll subtract a random number from that so we'll be able to still replace later on.
-		slot->EntryOne.data.set(pos, move, score, depth, flag, (generation >= 127) ? generation - (pos->posKey & 1) : generation);
+		slot->EntryOne.data.set(pos, move, score, depth, flag, (age >= 127) ? age - (pos->posKey & 1) : age);
 
 		// Step 1C. For 32-bit systems, we need to save the position key XOR'd with the data in order to make the tt thread safe.
 #if !(defined(_WIN64) || defined(IS_64BIT))
@@ -162,4 +169,32 @@ void TranspositionTable::store_entry(const GameState_t* pos, uint16_t move, int1
 		slot->EntryTwo.key = pos->posKey ^ *data;
 #endif
 	}
-}
\ No newline at end of file
+}
+
+
+
+/// <summary>
+/// Shrink the global table while the threads of a command use their own tables.
+/// </summary>
+/// <param name="threads">The number of threads the Hash size is split between.</param>
+TableResizeGuard::TableResizeGuard(int threads) {
+	hash_mb = tt->size() - 1;
+	thread_count = std::max(threads, 1);
+
+	tt->resize(TT_MIN_SIZE, false);
+}
+
+/// <summary>
+/// Give the global table its Hash size back.
+/// </summary>
+TableResizeGuard::~TableResizeGuard() {
+	tt->resize(hash_mb, false);
+}
+
+/// <summary>
+/// Create a table for one of the threads. It is created silently, since a command may create one for every thread.
+/// </summary>
+/// <returns>A cleared table of Hash / threads megabytes, but at least the minimum size.</returns>
+TranspositionTable* TableResizeGuard::thread_table() const {
+	return new TranspositionTable(std::max<uint64_t>(TT_MIN_SIZE, hash_mb / thread_count), false);
+}
@@ -19,6 +19,7 @@
 #define TRANSPOSITION_H
 #include "tt_entry.h"
 
+#include <atomic>
 #include <vector>
 
 
@@ -45,11 +46,11 @@ inline uint64_t nearest_power_two(uint64_t maxSize) {
 /// </summary>
 class TranspositionTable {
 public:
-	TranspositionTable(uint64_t size);
+	TranspositionTable(uint64_t size, bool verbose = true);
 
 	~TranspositionTable();
 
-	void resize(uint64_t size);
+	void resize(uint64_t size, bool verbose = true);
 
 	EntryData_t* probe_tt(const uint64_t key, bool& hit);
 
@@ -62,11 +63,12 @@ public:
 		generation = std::min(a, 127);
 	}
 	void increment_age() {
-		generation = std::min(generation + 1, 127); // We use 7 bits to store age information in the entries, and we shouldn't store anymore since they'd overflow.
+		int age = std::min(generation + 1, 127); // We use 7 bits to store age information in the entries, and we shouldn't store anymore since they'd overflow.
 
-		if (generation >= 127) {
-			generation /= 2; // We need to increment the generation in games that are more than 127 moves.
+		if (age >= 127) {
+			age /= 2; // We need to increment the generation in games that are more than 127 moves.
 		}
+		generation = uint16_t(age);
 	}
 	uint16_t getAge() {
 		return generation;
@@ -86,12 +88,34 @@ private:
 	size_t num_slots = 0;
 	size_t numEntries = 0;
 
-	uint16_t generation = 0;
+	// The threads of the analysis commands share the table and age it while the others are storing entries.
+	std::atomic<uint16_t> generation{ 0 };
 };
 
 
 extern TranspositionTable *tt;
 
 
+/// <summary>
+/// When the threads of a command search with tables of their own, the Hash size is split between them and the global table is shrunk to the
+/// minimum size, so about the same memory is used. The global table gets its size back when the guard goes out of scope.
+/// </summary>
+class TableResizeGuard {
+public:
+	TableResizeGuard(int threads);
+	~TableResizeGuard();
+
+	TableResizeGuard(const TableResizeGuard&) = delete;
+	TableResizeGuard& operator=(const TableResizeGuard&) = delete;
+
+	// Creates a table of one thread's part of the Hash size. It is owned by the caller.
+	TranspositionTable* thread_table() const;
+
+private:
+	uint64_t hash_mb = 0;
+	int thread_count = 1;
+};
+
+
 
 #endif
\ No newline at end of file
@@ -21,13 +21,13 @@
 
 
 /// <summary>
-/// Make the score of a position relative to the root in case of mate scores.
+/// Make the score of a position relative to the root in case of mate or tablebase scores.
 /// </summary>
 /// <param name="score">The score form a shallow search.</param>
 /// <param name="ply">The ply-depth from root.</param>
 /// <returns></returns>
 inline int16_t value_to_tt(int score, int ply) {
-	return (score > MATE) ? score + ply : ((score < -MATE) ? score - ply : score);
+	return (score >= TB_WIN_IN_MAX_PLY) ? score + ply : ((score <= -TB_WIN_IN_MAX_PLY) ? score - ply : score);
 }
 
 /// <summary>
@@ -37,7 +37,7 @@ inline int16_t value_to_tt(int score, int ply) {
 /// <param name="ply">The ply-depth from root.</param>
 /// <returns></returns>
 inline int16_t value_from_tt(int score, int ply) {
-	return (score > MATE) ? score - ply : ((score < -MATE) ? score + ply : score);
+	return (score >= TB_WIN_IN_MAX_PLY) ? score - ply : ((score <= -TB_WIN_IN_MAX_PLY) ? score + ply : score);
 }
 
 
@@ -18,6 +18,7 @@
 #include "uci.h"
 
 int UCI::num_threads = THREADS_DEFAULT_NUM;
+bool UCI::own_book = false;
 
 
 /*
@@ -29,9 +30,17 @@ void UCI::print_info() {
 	std::cout << "id name " << EngineInfo[NAME] << " " << EngineInfo[VERSION] << std::endl;
 	std::cout << "id author " << EngineInfo[AUTHOR] << std::endl;
 
+	// Report which compiled versions of the hot functions and which slider attack lookup the processor ended up with.
+	std::cout << "info string instruction set " << CPU::instruction_set_name(CPU::instruction_set())
+		<< ", " << Magics::backend_name(Magics::backend) << " slider attacks" << std::endl;
+
 	// Step 3C.1. Output all ajustible options for Loki.
 	std::cout << "option name Hash type spin default " << TT_DEFAULT_SIZE << " min " << TT_MIN_SIZE << " max " << TT_MAX_SIZE << std::endl;
 	std::cout << "option name Threads type spin default " << THREADS_DEFAULT_NUM << " min " << THREADS_MIN_NUM << " max " << THREADS_MAX_NUM << std::endl;
+	std::cout << "option name EvalFile type string default <empty>" << std::endl;
+	std::cout << "option name SyzygyPath type string default <empty>" << std::endl;
+	std::cout << "option name OwnBook type check default false" << std::endl;
+	std::cout << "option name BookFile type string default <empty>" << std::endl;
 	std::cout << "uciok" << std::endl;
 }
 
@@ -65,6 +74,86 @@ void UCI::loop() {
 			continue;
 		}
 
+		// Step 3A.1. Load an NNUE network. The path is the rest of the line, since it may contain spaces. This is checked before the other
+		//	commands, since the path could contain their names.
+		if (input.find(std::string("setoption name EvalFile value")) != std::string::npos) {
+			std::string path = input.substr(input.find("value") + 5);
+			path.erase(0, path.find_first_not_of(' '));
+
+			if (NNUE::load(path)) {
+				std::cout << "info string " << ((NNUE::is_loaded()) ? "NNUE network " + path + " loaded, " + NNUE::kernel_name(NNUE::kernel) + " kernels"
+					: std::string("NNUE disabled")) << std::endl;
+			}
+			else {
+				std::cout << "info string Could not load the NNUE network " << path << std::endl;
+			}
+
+			continue;
+		}
+
+		// Step 3A.2. Set the directories of the Syzygy tablebases, which can also contain spaces.
+		if (input.find(std::string("setoption name SyzygyPath value")) != std::string::npos) {
+			std::string paths = input.substr(input.find("value") + 5);
+			paths.erase(0, paths.find_first_not_of(' '));
+
+			int found = Syzygy::load(paths);
+			std::cout << "info string Found " << found << " tablebases with up to " << Syzygy::max_cardinality << " pieces" << std::endl;
+
+			continue;
+		}
+
+		// Step 3A.3. Load a Polyglot opening book. The path may contain spaces too.
+		if (input.find(std::string("setoption name BookFile value")) != std::string::npos) {
+			std::string path = input.substr(input.find("value") + 5);
+			path.erase(0, path.find_first_not_of(' '));
+
+			if (Book::load(path)) {
+				std::cout << "info string " << ((Book::is_loaded()) ? "Opening book " + path + " loaded with " + std::to_string(Book::size()) + " entries"
+					: std::string("Opening book disabled")) << std::endl;
+			}
+			else {
+				std::cout << "info string Could not load the opening book " << path << std::endl;
+			}
+
+			continue;
+		}
+
+		// Step 3A.4. Turn the use of the opening book on or off.
+		if (input.find(std::string("setoption name OwnBook value")) != std::string::npos) {
+			own_book = input.find("true") != std::string::npos;
+			continue;
+		}
+
+		// Step 3A.5. Generate self-play training data. Like the network path, this is checked early since "positions" contains "position".
+		if (input.rfind("gensfen", 0) == 0) {
+			Gensfen::parse(input);
+			continue;
+		}
+
+		// Step 3A.6. Run a test suite.
+		if (input.rfind("solve", 0) == 0) {
+			Solve::parse(input);
+			continue;
+		}
+
+		// Step 3A.7. Analyse the positions of a file.
+		if (input.rfind("batch", 0) == 0) {
+			Batch::parse(input);
+			continue;
+		}
+
+		// Step 3A.8. Run a perft suite. This has to come before the "perft" command below, which would match it as well.
+		if (input.rfind("perftsuite", 0) == 0) {
+			Perft::parse_suite(input);
+			continue;
+		}
+
+		// Step 3A.9. Print the statistics of the last search.
+		if (input.rfind("stats", 0) == 0) {
+			SearchStats::parse(input);
+			continue;
+		}
+
 		// Step 3B. If we're told to start a new game, clear the transposition table and set up the starting position
 		if (input.find(std::string("ucinewgame")) != std::string::npos) {
 			tt->clear_table();
@@ -153,6 +242,17 @@ void UCI::loop() {
 			continue;
 		}
 
+		else if (input == "bookkey") { // Print the Polyglot hash key of the position
+			std::cout << "info string bookkey " << std::hex << std::setw(16) << std::setfill('0') << Book::polyglot_key(pos) << std::dec
+				<< std::setfill(' ') << std::endl;
+			continue;
+		}
+
+		else if (input == "tbprobe") { // Print the tablebase values of the position
+			printTablebaseProbe(pos);
+			continue;
+		}
+
 		else if (input.find(std::string("evaltest")) != std::string::npos) { // Do an evaluation test to make sure the eval is the same for white and black.
 			Eval::Debug::eval_balance();
 			continue;
@@ -163,9 +263,18 @@ void UCI::loop() {
 			continue;
 		}
 
-		// Step 3J. If we receive a "bench", run a benchmark node-count measurement
+		// Step 3J. If we receive a "bench", run a benchmark node-count measurement. "bench sliders" times the slider attack lookups and
+		//	"bench eval" times the static evaluation instead.
 		else if (input.find("bench") != std::string::npos) {
-			Bench::run_benchmark();
+			if (input.find("sliders") != std::string::npos) {
+				Bench::run_slider_benchmark();
+			}
+			else if (input.find("eval") != std::string::npos) {
+				Bench::run_eval_benchmark();
+			}
+			else {
+				Bench::run_benchmark();
+			}
 			continue;
 		}
 
@@ -308,6 +417,10 @@ void UCI::parse_go(std::string params, GameState_t* pos, SearchInfo_t* info) {
 		depth = std::stoi(params.substr(index + 6));
 	}
 
+	// Step 2F. If we've been told to search a certain amount of nodes, stop there.
+	index = params.find("nodes");
+	info->node_limit = (index != std::string::npos) ? std::stoll(params.substr(index + 6)) : 0;
+
 	// Step 3. Configure the search time and depth depending on the parameters we've been given.
 	// FIXME: Add some more elaborate time management scheme here. Right now, Loki's time management is taken from Vice...
 	info->depth = depth;
@@ -334,7 +447,18 @@ void UCI::parse_go(std::string params, GameState_t* pos, SearchInfo_t* info) {
 		}
 	}
 
-	// Step 4. Finally, run the search.
+	// Step 4. If the position is in the opening book, play one of its moves without searching. Infinite searches are used for analysis, so
+	//	they always search.
+	if (own_book && params.find("infinite") == std::string::npos) {
+		unsigned int book_move = Book::probe(pos);
+
+		if (book_move != NOMOVE) {
+			std::cout << "bestmove " << printMove(book_move) << std::endl;
+			return;
+		}
+	}
+
+	// Step 5. Finally, run the search.
 	
 	Search::isStop = false;
 	Search::runSearch(pos, info, num_threads);
@@ -387,4 +511,31 @@ void UCI::printHashEntry(GameState_t* pos) {
 	else {
 		std::cout << "Position is not stored in transposition table" << std::endl;
 	}
+}
+
+
+/*
+
+printTablebaseProbe prints the WDL and DTZ values of the current position as "info string tbprobe wdl <wdl> dtz <dtz>", or that it couldn't be
+probed. tests/syzygy.py uses it to check the tables against known values.
+
+*/
+
+void UCI::printTablebaseProbe(GameState_t* pos) {
+	if (pos->castleRights != 0 || countBits(pos->all_pieces[WHITE] | pos->all_pieces[BLACK]) > Syzygy::max_cardinality) {
+		std::cout << "info string tbprobe failed" << std::endl;
+		return;
+	}
+
+	Syzygy::ProbeState wdl_result, dtz_result;
+	Syzygy::WDLScore wdl = Syzygy::probe_wdl(pos, &wdl_result);
+
+	if (wdl_result == Syzygy::FAIL) {
+		std::cout << "info string tbprobe failed" << std::endl;
+		return;
+	}
+
+	int dtz = Syzygy::probe_dtz(pos, &dtz_result);
+
+	std::cout << "info string tbprobe wdl " << int(wdl) << " dtz " << ((dtz_result == Syzygy::FAIL) ? std::string("none") : std::to_string(dtz)) << std::endl;
 }
\ No newline at end of file
@@ -20,7 +20,12 @@
 #include "search.h"
 #include "perft.h"
 #include "bench.h"
+#include "gensfen.h"
+#include "book.h"
+#include "solve.h"
+#include "batch.h"
 
+#include <iomanip>
 #include <map>
 #include <sstream>
 
@@ -38,6 +43,7 @@ namespace UCI {
 	constexpr int MOVE_BUFFER = 50;
 
 	extern int num_threads; // Global such that it can be accessed by both loop() and parse_go();
+	extern bool own_book; // If true, parse_go() plays a move from the opening book instead of searching when it can.
 
 	// Main method of the UCI implementation. Responsible for listening for all input
 	void loop();
@@ -55,6 +61,9 @@ namespace UCI {
 
 	// Helper function for debugging the transposition table. It prints info about the position stored in the tt.
 	void printHashEntry(GameState_t* pos);
+
+	// Helper function for checking the tablebases. It prints the WDL and DTZ values of the position.
+	void printTablebaseProbe(GameState_t* pos);
 }
 
 
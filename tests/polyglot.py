@@ -0,0 +1,93 @@
+"""
+    Loki, a UCI-compliant chess playing software
+    Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+    
+    Loki is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    
+    Loki is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+"""
+
+
+
+'''
+
+This python script checks the Polyglot hash keys that Loki computes for opening books against the reference keys of the Polyglot book format
+specification, which are in polyglot.epd.
+
+'''
+import argparse
+import subprocess
+import sys
+
+
+def main():
+    print("-"*100)
+    print("[*] Starting Polyglot key test")
+    print("-"*100)
+
+    # Step 1. Parse the inputs
+    parser = argparse.ArgumentParser(description='Test the Polyglot hash keys of Loki')
+
+    parser.add_argument("exe", type=str, help='The path to the Loki executable. Please use an ABSOLUTE path')
+    parser.add_argument("epd", type=str, help='The path to the EPD file with the expected keys. Please use an ABSOLUTE path')
+
+    args = parser.parse_args()
+
+    # Step 2. Run the engine
+    prc = subprocess.Popen(args.exe,
+                    stderr=subprocess.PIPE,
+                    stdout=subprocess.PIPE,
+                    stdin=subprocess.PIPE,
+                    universal_newlines=True)
+
+    # Step 3. Compute the key of every position and compare it with the expected one
+    passed = 0
+    failed = 0
+
+    with open(args.epd, "r") as epd_file:
+        for line in epd_file:
+            elements = [e.strip() for e in line.split(";")]
+            if len(elements) < 2:
+                continue
+
+            fen = elements[0]
+            expected = elements[1].split()[1]
+
+            prc.stdin.write("position fen " + fen + "\n")
+            prc.stdin.write("bookkey\n")
+            prc.stdin.flush()
+
+            while True:
+                output = prc.stdout.readline().strip()
+                if "bookkey" in output:
+                    break
+
+            key = output.split()[-1]
+
+            if key == expected:
+                passed += 1
+                print("[*] PASSED " + fen)
+            else:
+                failed += 1
+                print("[!] FAILED " + fen + ": key " + key + ", expected " + expected)
+
+    print("[*] " + str(passed) + " passed, " + str(failed) + " failed")
+
+    # Step 4. Close Loki
+    prc.stdin.write('quit\n')
+    prc.stdin.flush()
+
+    sys.exit(1 if failed > 0 or passed == 0 else 0)
+
+
+if __name__ == "__main__":
+    main()
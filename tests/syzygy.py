@@ -0,0 +1,182 @@
+"""
+    Loki, a UCI-compliant chess playing software
+    Copyright (C) 2021  Niels Abildskov (https://github.com/BimmerBass)
+    
+    Loki is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    
+    Loki is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+"""
+
+
+
+'''
+
+This python script checks the Syzygy probing code against known WDL and DTZ values. It needs the KQvK, KRvK and KPvK tables (.rtbw and .rtbz),
+e.g. from https://tablebase.lichess.ovh/tables/standard/3-4-5/. If the directory doesn't exist or doesn't have them, the test is skipped.
+
+The expected values in syzygy.epd were computed by a separate retrograde analysis of the three endgames. A DTZ value of the tables may be one
+lower than the real distance, as explained in syzygy.cpp, so that is accepted as well.
+
+Afterwards it checks that the search stores a tablebase loss in the transposition table with the right score and bound, and that a second search
+of the same position is cut off by it and probes the tables less.
+
+'''
+import argparse
+import os
+import subprocess
+import sys
+
+
+# The score of a tablebase win in defs.h. A loss found at any ply is stored as -TB_WIN, since the score is made relative to the position.
+TB_WIN = 19900
+
+# Queen takes rook gives KQvK with black to move.
+TT_TEST_FEN = "8/8/8/8/8/2k5/8/K2Q2r1 w - - 0 1"
+TT_TEST_MOVE = "d1g1"
+
+
+def main():
+    print("-"*100)
+    print("[*] Starting tablebase test")
+    print("-"*100)
+
+    # Step 1. Parse the inputs
+    parser = argparse.ArgumentParser(description='Test the Syzygy tablebase probing of Loki')
+
+    parser.add_argument("exe", type=str, help='The path to the Loki executable. Please use an ABSOLUTE path')
+    parser.add_argument("epd", type=str, help='The path to the EPD file with the expected values. Please use an ABSOLUTE path')
+    parser.add_argument("tables", type=str, help='The directory with the tablebase files')
+
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.tables):
+        print("[*] SKIPPED: the tablebase directory " + args.tables + " doesn't exist")
+        sys.exit(0)
+
+    # Step 2. Run the engine and load the tables
+    prc = subprocess.Popen(args.exe,
+                    stderr=subprocess.PIPE,
+                    stdout=subprocess.PIPE,
+                    stdin=subprocess.PIPE,
+                    universal_newlines=True)
+
+    def command(cmd, answer):
+        prc.stdin.write(cmd + "\n")
+        prc.stdin.flush()
+
+        while True:
+            line = prc.stdout.readline().strip()
+            if answer in line:
+                return line
+
+    found = command("setoption name SyzygyPath value " + args.tables, "tablebases with up to")
+    print("[*] " + found)
+
+    # Step 2A. Without the KQvK, KRvK and KPvK tables there is nothing to test.
+    if int(found.split()[3]) < 3 or int(found.split()[-2]) < 3:
+        print("[*] SKIPPED: the KQvK, KRvK and KPvK tables were not found in " + args.tables)
+
+        prc.stdin.write('quit\n')
+        prc.stdin.flush()
+        sys.exit(0)
+
+    # Step 3. Probe every position and compare with the expected values
+    passed = 0
+    failed = 0
+
+    with open(args.epd, "r") as epd_file:
+        for line in epd_file:
+            elements = [e.strip() for e in line.split(";")]
+            if len(elements) < 3:
+                continue
+
+            fen = elements[0]
+            expected = {}
+            for e in elements[1:]:
+                opcode, _, operand = e.partition(" ")
+                expected[opcode] = operand
+
+            prc.stdin.write("position fen " + fen + "\n")
+            result = command("tbprobe", "tbprobe").split()
+
+            wdl = int(result[-3]) if result[-4] == "wdl" else None
+            dtz = int(result[-1]) if wdl is not None and result[-1] != "none" else None
+
+            exp_wdl = int(expected["wdl"])
+            exp_dtz = int(expected["dtz"])
+
+            # A DTZ of n can mean n or n + 1 plies.
+            dtz_ok = dtz is not None and (dtz == exp_dtz or (exp_dtz > 1 and dtz == exp_dtz - 1) or (exp_dtz < -1 and dtz == exp_dtz + 1))
+
+            if wdl == exp_wdl and dtz_ok:
+                passed += 1
+            else:
+                failed += 1
+                print("[!] FAILED " + fen + " (" + expected.get("c0", "") + "): wdl " + str(wdl) + " dtz " + str(dtz) +
+                      ", expected wdl " + str(exp_wdl) + " dtz " + str(exp_dtz))
+
+    print("[*] " + str(passed) + " passed, " + str(failed) + " failed")
+
+    # Step 4. Search a position where a capture leads to KQvK twice, and check the transposition table entry after the capture.
+    def search_tbhits():
+        prc.stdin.write("position fen " + TT_TEST_FEN + "\n")
+        prc.stdin.write("go depth 6\n")
+        prc.stdin.flush()
+
+        tbhits = 0
+        while True:
+            line = prc.stdout.readline().strip()
+            if "tbhits" in line:
+                tbhits = int(line.split()[line.split().index("tbhits") + 1])
+            if line.startswith("bestmove"):
+                return tbhits
+
+    prc.stdin.write("ucinewgame\n")
+    first_hits = search_tbhits()
+
+    prc.stdin.write("position fen " + TT_TEST_FEN + " moves " + TT_TEST_MOVE + "\n")
+    prc.stdin.write("probetable\n")
+    prc.stdin.flush()
+
+    score = None
+    flag = None
+    while flag is None:
+        line = prc.stdout.readline().strip()
+        if line.startswith("Score:"):
+            score = int(line.split()[-1])
+        elif line.startswith("Flag:"):
+            flag = line.split()[-1]
+        elif "not stored" in line:
+            break
+
+    second_hits = search_tbhits()
+
+    # The loss is an upper bound, and the nodes that find it in the table again don't probe. Only the PV nodes, which aren't cut off by the
+    #	table, probe it again.
+    if score == -TB_WIN and flag == "ALPHA" and second_hits < first_hits:
+        passed += 1
+    else:
+        failed += 1
+        print("[!] FAILED transposition table test: stored score " + str(score) + " flag " + str(flag) + ", expected " + str(-TB_WIN) + " ALPHA, tbhits " +
+              str(first_hits) + " and then " + str(second_hits))
+
+    print("[*] Transposition table test: stored score " + str(score) + " " + str(flag) + ", tbhits " + str(first_hits) + " and then " + str(second_hits))
+
+    # Step 5. Close Loki
+    prc.stdin.write('quit\n')
+    prc.stdin.flush()
+
+    sys.exit(1 if failed > 0 or passed == 0 else 0)
+
+
+if __name__ == "__main__":
+    main()